@@ -0,0 +1,234 @@
+#include "benchmarks/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "core/base/logging.h"
+#include "core/strings/numbers.h"
+#include "core/strings/str_util.h"
+#include "core/strings/stringprintf.h"
+
+namespace mr {
+namespace benchmark {
+
+namespace {
+
+uint64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::vector<std::pair<std::string, Function>>* Registry() {
+  static auto* registry = new std::vector<std::pair<std::string, Function>>;
+  return registry;
+}
+
+// Everything reported for one benchmark.
+struct Result {
+  std::string name;
+  int repetitions = 0;
+  std::vector<double> seconds;  // One per repetition.
+  int64_t items = 0;            // Over all repetitions.
+  std::vector<double> latencies;
+  std::map<std::string, double> counters;  // Sums; divided on output.
+};
+
+std::string JsonEscape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    out += c;
+  }
+  return out;
+}
+
+}  // namespace
+
+State::State()
+    : running_(true), start_nanos_(NowNanos()), elapsed_nanos_(0), items_(0) {}
+
+void State::PauseTiming() {
+  DCHECK(running_);
+  elapsed_nanos_ += NowNanos() - start_nanos_;
+  running_ = false;
+}
+
+void State::ResumeTiming() {
+  DCHECK(!running_);
+  start_nanos_ = NowNanos();
+  running_ = true;
+}
+
+double State::elapsed_seconds() const {
+  uint64_t nanos = elapsed_nanos_;
+  if (running_) nanos += NowNanos() - start_nanos_;
+  return nanos * 1e-9;
+}
+
+class Runner {
+ public:
+  static Result Run(const std::string& name, const Function& fn,
+                    const Options& options) {
+    for (int i = 0; i < options.warmup; ++i) {
+      State state;
+      fn(&state);
+    }
+    Result result;
+    result.name = name;
+    result.repetitions = options.repetitions;
+    for (int i = 0; i < options.repetitions; ++i) {
+      State state;
+      fn(&state);
+      if (state.running_) state.PauseTiming();
+      result.seconds.push_back(state.elapsed_nanos_ * 1e-9);
+      result.items += state.items_;
+      result.latencies.insert(result.latencies.end(), state.latencies_.begin(),
+                              state.latencies_.end());
+      for (const auto& c : state.counters_) result.counters[c.first] += c.second;
+    }
+    return result;
+  }
+};
+
+double Percentile(std::vector<double>* values, double p) {
+  if (values->empty()) return 0;
+  std::sort(values->begin(), values->end());
+  const double rank = p / 100 * (values->size() - 1);
+  const size_t lo = static_cast<size_t>(rank);
+  const size_t hi = std::min(lo + 1, values->size() - 1);
+  return (*values)[lo] + (rank - lo) * ((*values)[hi] - (*values)[lo]);
+}
+
+int Register(const std::string& name, Function fn) {
+  Registry()->emplace_back(name, std::move(fn));
+  return 0;
+}
+
+namespace {
+
+void PrintText(Result* r, bool header) {
+  if (header) {
+    printf("%-44s %5s %10s %10s %10s %10s %14s %10s %10s\n", "benchmark",
+           "reps", "min_ms", "p50_ms", "p90_ms", "max_ms", "items/s",
+           "lat_p50_us", "lat_p99_us");
+  }
+  double total = 0;
+  for (double s : r->seconds) total += s;
+  const double items_per_sec = total > 0 ? r->items / total : 0;
+  printf("%-44s %5d %10.3f %10.3f %10.3f %10.3f %14.0f", r->name.c_str(),
+         r->repetitions, Percentile(&r->seconds, 0) * 1e3,
+         Percentile(&r->seconds, 50) * 1e3, Percentile(&r->seconds, 90) * 1e3,
+         Percentile(&r->seconds, 100) * 1e3, items_per_sec);
+  if (!r->latencies.empty()) {
+    printf(" %10.2f %10.2f", Percentile(&r->latencies, 50) * 1e6,
+           Percentile(&r->latencies, 99) * 1e6);
+  } else {
+    printf(" %10s %10s", "-", "-");
+  }
+  for (const auto& c : r->counters) {
+    printf(" %s=%.4g", c.first.c_str(), c.second / r->repetitions);
+  }
+  printf("\n");
+}
+
+void PrintJson(Result* r) {
+  double total = 0;
+  for (double s : r->seconds) total += s;
+  std::string out = strings::Printf(
+      "{\"name\":\"%s\",\"repetitions\":%d,\"items_per_second\":%.6g,"
+      "\"seconds\":{\"mean\":%.6g,\"min\":%.6g,\"p50\":%.6g,\"p90\":%.6g,"
+      "\"p99\":%.6g,\"max\":%.6g}",
+      JsonEscape(r->name).c_str(), r->repetitions,
+      total > 0 ? r->items / total : 0,
+      r->seconds.empty() ? 0 : total / r->seconds.size(),
+      Percentile(&r->seconds, 0), Percentile(&r->seconds, 50),
+      Percentile(&r->seconds, 90), Percentile(&r->seconds, 99),
+      Percentile(&r->seconds, 100));
+  if (!r->latencies.empty()) {
+    strings::Appendf(
+        &out,
+        ",\"latency_seconds\":{\"count\":%zu,\"p50\":%.6g,\"p90\":%.6g,"
+        "\"p99\":%.6g,\"p999\":%.6g,\"max\":%.6g}",
+        r->latencies.size(), Percentile(&r->latencies, 50),
+        Percentile(&r->latencies, 90), Percentile(&r->latencies, 99),
+        Percentile(&r->latencies, 99.9), Percentile(&r->latencies, 100));
+  }
+  if (!r->counters.empty()) {
+    out += ",\"counters\":{";
+    bool first = true;
+    for (const auto& c : r->counters) {
+      strings::Appendf(&out, "%s\"%s\":%.6g", first ? "" : ",",
+                       JsonEscape(c.first).c_str(), c.second / r->repetitions);
+      first = false;
+    }
+    out += "}";
+  }
+  out += "}";
+  printf("%s\n", out.c_str());
+}
+
+bool ParseIntFlag(StringPiece arg, StringPiece flag, int* value) {
+  if (!str_util::ConsumePrefix(&arg, flag)) return false;
+  int32_t v;
+  if (!strings::safe_strto32(arg, &v) || v < 0) return false;
+  *value = v;
+  return true;
+}
+
+}  // namespace
+
+bool ParseFlags(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    StringPiece arg(argv[i]);
+    if (str_util::ConsumePrefix(&arg, "--filter=")) {
+      options->filter = arg.ToString();
+    } else if (arg == "--format=json") {
+      options->json = true;
+    } else if (arg == "--format=text") {
+      options->json = false;
+    } else if (!ParseIntFlag(arg, "--warmup=", &options->warmup) &&
+               !ParseIntFlag(arg, "--repetitions=", &options->repetitions)) {
+      fprintf(stderr,
+              "Unknown flag %s\nUsage: %s [--filter=<substring>] "
+              "[--warmup=<n>] [--repetitions=<n>] [--format=text|json]\n",
+              argv[i], argv[0]);
+      return false;
+    }
+  }
+  if (options->repetitions < 1) {
+    fprintf(stderr, "--repetitions must be at least 1\n");
+    return false;
+  }
+  return true;
+}
+
+int RunBenchmarks(const Options& options) {
+  int count = 0;
+  for (const auto& entry : *Registry()) {
+    if (entry.first.find(options.filter) == std::string::npos) continue;
+    Result result = Runner::Run(entry.first, entry.second, options);
+    if (options.json) {
+      PrintJson(&result);
+    } else {
+      PrintText(&result, count == 0);
+    }
+    fflush(stdout);
+    ++count;
+  }
+  return count;
+}
+
+int Main(int argc, char** argv) {
+  Options options;
+  if (!ParseFlags(argc, argv, &options)) return 1;
+  RunBenchmarks(options);
+  return 0;
+}
+
+}  // namespace benchmark
+}  // namespace mr
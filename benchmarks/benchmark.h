@@ -0,0 +1,110 @@
+// A small benchmark harness.  Each registered benchmark is run a number of
+// warmup times and then timed over several repetitions; the harness
+// reports percentiles of the repetition times, throughput, and
+// percentiles of any per-operation latencies the benchmark records.
+//
+// Example:
+//   static void BM_Schedule(benchmark::State* state) {
+//     ... set up, untimed ...
+//     state->ResumeTiming();
+//     for (int i = 0; i < kTasks; ++i) pool->Schedule(...);
+//     ... wait ...
+//     state->PauseTiming();
+//     state->SetItemsProcessed(kTasks);
+//   }
+//   MR_BENCHMARK("Schedule", BM_Schedule);
+//
+//   int main(int argc, char** argv) { return benchmark::Main(argc, argv); }
+//
+// Flags:
+//   --filter=<substring>   only run benchmarks whose name contains it
+//   --warmup=<n>           untimed runs before measuring (default 1)
+//   --repetitions=<n>      timed runs (default 5)
+//   --format=text|json     json prints one object per benchmark per line
+
+#ifndef BENCHMARKS_BENCHMARK_H_
+#define BENCHMARKS_BENCHMARK_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core/base/macros.h"
+
+namespace mr {
+namespace benchmark {
+
+// Handed to a benchmark function once per run.  The timer starts running
+// when the function is called unless it calls PauseTiming() first.
+class State {
+ public:
+  State();
+
+  void PauseTiming();
+  void ResumeTiming();
+
+  // Items processed by this run; reported as items per second.
+  void SetItemsProcessed(int64_t items) { items_ = items; }
+
+  // Records the latency of one operation, in seconds.
+  void AddLatencySample(double seconds) { latencies_.push_back(seconds); }
+
+  // A named metric of this run (e.g. a steal rate), averaged over the
+  // repetitions.
+  void SetCounter(const std::string& name, double value) {
+    counters_[name] = value;
+  }
+
+  double elapsed_seconds() const;
+
+ private:
+  friend class Runner;
+
+  bool running_;
+  uint64_t start_nanos_;
+  uint64_t elapsed_nanos_;
+  int64_t items_;
+  std::vector<double> latencies_;
+  std::map<std::string, double> counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(State);
+};
+
+typedef std::function<void(State*)> Function;
+
+// Registers "fn" under "name".  Returns a dummy value so that it can
+// initialize a namespace-scope variable.
+int Register(const std::string& name, Function fn);
+
+#define MR_BENCHMARK(name, fn) MR_BENCHMARK_UNIQ(__COUNTER__, name, fn)
+#define MR_BENCHMARK_UNIQ(ctr, name, fn) MR_BENCHMARK_UNIQ_IMPL(ctr, name, fn)
+#define MR_BENCHMARK_UNIQ_IMPL(ctr, name, fn) \
+  static int mr_benchmark_##ctr = ::mr::benchmark::Register(name, fn)
+
+struct Options {
+  std::string filter;
+  int warmup = 1;
+  int repetitions = 5;
+  bool json = false;
+};
+
+// Returns false, after printing usage, on an unknown or malformed flag.
+bool ParseFlags(int argc, char** argv, Options* options);
+
+// Runs the registered benchmarks that match options.filter and prints the
+// results to stdout.  Returns the number of benchmarks run.
+int RunBenchmarks(const Options& options);
+
+// ParseFlags() + RunBenchmarks(); the usual body of main().
+int Main(int argc, char** argv);
+
+// The "p"-th percentile (0 <= p <= 100) of "values", interpolating between
+// the closest ranks.  Sorts "values".
+double Percentile(std::vector<double>* values, double p);
+
+}  // namespace benchmark
+}  // namespace mr
+#endif  // BENCHMARKS_BENCHMARK_H_
@@ -0,0 +1,100 @@
+// Hashing 1M short keys (8 to 24 bytes, like shuffle keys) and 64MB in 4KB
+// blocks with StringPieceHash, which partitioned map outputs before,
+// std::hash, Hash64 one key at a time and Hash64Batch.  Items are keys or
+// blocks.
+//
+// Usage: hash_benchmark [--filter=...] [--format=json] ...
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/hash.h"
+#include "core/strings/strcat.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace {
+
+static const int kNumKeys = 1 << 20;
+static const size_t kBlockSize = 4096;
+static const int kNumBlocks = 16 << 10;
+
+// All keys back to back, and pieces of them.
+struct Keys {
+  std::string data;
+  std::vector<StringPiece> pieces;
+};
+
+void MakeKeys(bool long_keys, Keys* keys) {
+  std::mt19937 rng(301);
+  const int count = long_keys ? kNumBlocks : kNumKeys;
+  std::vector<size_t> sizes;
+  for (int i = 0; i < count; ++i) {
+    sizes.push_back(long_keys ? kBlockSize : 8 + rng() % 17);
+    for (size_t j = 0; j < sizes.back(); ++j) {
+      keys->data.push_back(static_cast<char>('a' + rng() % 26));
+    }
+  }
+  const char* p = keys->data.data();
+  for (size_t size : sizes) {
+    keys->pieces.push_back(StringPiece(p, size));
+    p += size;
+  }
+}
+
+void BM_Hash(const std::string& impl, bool long_keys,
+             benchmark::State* state) {
+  state->PauseTiming();
+  Keys keys;
+  MakeKeys(long_keys, &keys);
+  std::vector<uint64_t> hashes(keys.pieces.size());
+  state->ResumeTiming();
+  if (impl == "StringPieceHash") {
+    for (size_t i = 0; i < keys.pieces.size(); ++i) {
+      hashes[i] = StringPieceHash()(keys.pieces[i]);
+    }
+  } else if (impl == "std_hash") {
+    // std::hash<StringPiece> does not exist; this includes no copy.
+    for (size_t i = 0; i < keys.pieces.size(); ++i) {
+      hashes[i] = std::_Hash_bytes(keys.pieces[i].data(),
+                                   keys.pieces[i].size(), 0xc70f6907);
+    }
+  } else if (impl == "Hash64") {
+    for (size_t i = 0; i < keys.pieces.size(); ++i) {
+      hashes[i] = Hash64(keys.pieces[i]);
+    }
+  } else {
+    Hash64Batch(keys.pieces, 0, &hashes);
+  }
+  state->PauseTiming();
+  CHECK_NE(hashes[0], hashes[1]);
+  state->SetItemsProcessed(hashes.size());
+}
+
+int RegisterAll() {
+  for (bool long_keys : {false, true}) {
+    for (const char* impl :
+         {"StringPieceHash", "std_hash", "Hash64", "Hash64Batch"}) {
+      const std::string name = impl;
+      benchmark::Register(
+          strings::StrCat(long_keys ? "Blocks/" : "Keys/", impl),
+          [name, long_keys](benchmark::State* state) {
+            BM_Hash(name, long_keys, state);
+          });
+    }
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
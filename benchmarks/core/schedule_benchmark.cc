@@ -0,0 +1,159 @@
+// Measures ThreadPool::Schedule throughput and heap allocations per
+// Schedule, against a pool that builds its tasks the way ThreadPool used
+// to: a std::function for the closure plus a new'ed task record.  Items
+// are closures; the "allocs_per_schedule" counter is the number of
+// operator new calls per Schedule.
+//
+// Usage: schedule_benchmark [--filter=...] [--format=json] ...
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/thread/non_blocking_thread_pool.h"
+#include "core/base/threadpool.h"
+#include "core/strings/strcat.h"
+#include "core/system/env.h"
+
+// Every replaceable operator new and delete goes through these two, so
+// that allocations are counted whichever form a caller uses, and memory is
+// always released by the function that matches the one that got it.
+namespace {
+
+std::atomic<int64_t> g_allocations(0);
+
+__attribute__((noinline)) void* CountedAllocate(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  return malloc(size == 0 ? 1 : size);
+}
+
+__attribute__((noinline)) void CountedFree(void* p) { free(p); }
+
+}  // namespace
+
+void* operator new(size_t size) {
+  void* p = CountedAllocate(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) {
+  void* p = CountedAllocate(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p, size_t) noexcept { CountedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  CountedFree(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  CountedFree(p);
+}
+
+namespace mr {
+namespace {
+
+// The task environment ThreadPool used before closures were pooled.
+struct LegacyEnvironment {
+  typedef eigen::StlThreadEnvironment::EnvThread EnvThread;
+  struct TaskImpl {
+    std::function<void()> f;
+    uint64_t trace_id;
+  };
+  struct Task {
+    std::unique_ptr<TaskImpl> f;
+  };
+
+  EnvThread* CreateThread(std::function<void()> f) {
+    return new EnvThread(std::move(f));
+  }
+  Task CreateTask(std::function<void()> f) {
+    return Task{std::unique_ptr<TaskImpl>(new TaskImpl{std::move(f), 0})};
+  }
+  void ExecuteTask(const Task& t) { t.f->f(); }
+};
+
+static const int kClosures = 200000;
+static const int kWarmupClosures = 1000;
+
+// Schedules kClosures closures that capture three words, the common shape
+// of a ParallelFor shard, and waits for all of them to run.  Allocations
+// are counted over the Schedule calls only.  "schedule" is called untimed
+// to warm up the pool first.
+template <typename Schedule>
+void RunSchedules(Schedule schedule, benchmark::State* state) {
+  std::atomic<int64_t> done(0);
+  int64_t a = 1, b = 2;
+  for (int i = 0; i < kWarmupClosures; ++i) {
+    schedule([&done, &a, &b]() { done.fetch_add(a * b - 1); });
+  }
+  while (done.load() < kWarmupClosures) {
+  }
+  done = 0;
+  const int64_t allocs_before = g_allocations.load();
+  state->ResumeTiming();
+  for (int i = 0; i < kClosures; ++i) {
+    schedule([&done, &a, &b]() { done.fetch_add(a * b - 1); });
+  }
+  const int64_t allocs = g_allocations.load() - allocs_before;
+  while (done.load() < kClosures) {
+  }
+  state->PauseTiming();
+  state->SetItemsProcessed(kClosures);
+  state->SetCounter("allocs_per_schedule",
+                    static_cast<double>(allocs) / kClosures);
+}
+
+void BM_ScheduleLegacy(int num_threads, benchmark::State* state) {
+  state->PauseTiming();
+  eigen::NonBlockingThreadPoolTempl<LegacyEnvironment> pool(num_threads);
+  RunSchedules(
+      [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); },
+      state);
+}
+
+void BM_ScheduleClosure(int num_threads, benchmark::State* state) {
+  state->PauseTiming();
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  RunSchedules(
+      [&pool](thread::ThreadPool::Closure fn) {
+        pool.Schedule(std::move(fn));
+      },
+      state);
+}
+
+int RegisterAll() {
+  for (int threads : {1, 4}) {
+    const std::string suffix = strings::StrCat("/threads:", threads);
+    benchmark::Register(strings::StrCat("Schedule/legacy", suffix),
+                        [threads](benchmark::State* state) {
+                          BM_ScheduleLegacy(threads, state);
+                        });
+    benchmark::Register(strings::StrCat("Schedule/closure", suffix),
+                        [threads](benchmark::State* state) {
+                          BM_ScheduleClosure(threads, state);
+                        });
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
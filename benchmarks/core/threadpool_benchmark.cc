@@ -0,0 +1,203 @@
+// Compares NonBlockingThreadPoolTempl with SimpleThreadPoolTempl on
+// Schedule throughput, fan-out/fan-in latency, ParallelFor scaling and
+// work stealing, for several thread counts.
+//
+// Usage: threadpool_benchmark [--filter=...] [--format=json] ...
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/thread/device_thread_pool.h"
+#include "core/strings/strcat.h"
+
+namespace mr {
+namespace {
+
+typedef std::function<eigen::ThreadPoolInterface*(int num_threads)>
+    PoolFactory;
+
+struct PoolKind {
+  const char* name;
+  PoolFactory factory;
+};
+
+const std::vector<PoolKind>& PoolKinds() {
+  static const std::vector<PoolKind>* kinds = new std::vector<PoolKind>{
+      {"nonblocking",
+       [](int n) -> eigen::ThreadPoolInterface* {
+         return new eigen::NonBlockingThreadPool(n);
+       }},
+      {"simple",
+       [](int n) -> eigen::ThreadPoolInterface* {
+         return new eigen::SimpleThreadPool(n);
+       }},
+  };
+  return *kinds;
+}
+
+const int kThreadCounts[] = {1, 2, 4, 8};
+
+// Schedules kTasks empty closures from outside the pool and waits for them.
+void BM_Schedule(const PoolFactory& factory, int num_threads,
+                 benchmark::State* state) {
+  const int kTasks = 100000;
+  state->PauseTiming();
+  std::unique_ptr<eigen::ThreadPoolInterface> pool(factory(num_threads));
+  eigen::Barrier barrier(kTasks);
+  state->ResumeTiming();
+  for (int i = 0; i < kTasks; ++i) {
+    pool->Schedule([&barrier]() { barrier.Notify(); });
+  }
+  barrier.Wait();
+  state->PauseTiming();
+  state->SetItemsProcessed(kTasks);
+}
+
+// Repeatedly fans one task out per thread and waits for all of them; the
+// latency of a round is the time from the first Schedule to the return of
+// the wait.
+void BM_FanOutFanIn(const PoolFactory& factory, int num_threads,
+                    benchmark::State* state) {
+  const int kRounds = 2000;
+  state->PauseTiming();
+  std::unique_ptr<eigen::ThreadPoolInterface> pool(factory(num_threads));
+  state->ResumeTiming();
+  for (int round = 0; round < kRounds; ++round) {
+    benchmark::State round_timer;
+    eigen::Barrier barrier(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      pool->Schedule([&barrier]() { barrier.Notify(); });
+    }
+    barrier.Wait();
+    state->AddLatencySample(round_timer.elapsed_seconds());
+  }
+  state->PauseTiming();
+  state->SetItemsProcessed(kRounds);
+}
+
+// Sums a large array with ThreadPoolDevice::ParallelFor.
+void BM_ParallelFor(const PoolFactory& factory, int num_threads,
+                    benchmark::State* state) {
+  const int kElements = 1 << 22;
+  const int kCalls = 20;
+  state->PauseTiming();
+  std::unique_ptr<eigen::ThreadPoolInterface> pool(factory(num_threads));
+  eigen::ThreadPoolDevice device(pool.get(), num_threads);
+  std::vector<int64_t> data(kElements);
+  for (int i = 0; i < kElements; ++i) data[i] = i;
+  std::atomic<int64_t> sum(0);
+  state->ResumeTiming();
+  for (int call = 0; call < kCalls; ++call) {
+    device.ParallelFor(kElements, eigen::OpCost(8, 0, 1),
+                       [&data, &sum](eigen::Index first, eigen::Index last) {
+                         int64_t local = 0;
+                         for (eigen::Index i = first; i < last; ++i) {
+                           local += data[i];
+                         }
+                         sum += local;
+                       });
+  }
+  state->PauseTiming();
+  CHECK_EQ(sum.load(), kCalls * (int64_t(kElements) * (kElements - 1) / 2));
+  state->SetItemsProcessed(int64_t(kCalls) * kElements);
+}
+
+// Many ParallelFor calls of a few tens of microseconds each, where the
+// cost of splitting and scheduling the blocks dominates.
+void BM_ShortParallelFor(const PoolFactory& factory, int num_threads,
+                         benchmark::State* state) {
+  const int kElements = 1 << 14;
+  const int kCalls = 2000;
+  state->PauseTiming();
+  std::unique_ptr<eigen::ThreadPoolInterface> pool(factory(num_threads));
+  eigen::ThreadPoolDevice device(pool.get(), num_threads);
+  std::vector<int64_t> data(kElements, 1);
+  std::atomic<int64_t> sum(0);
+  state->ResumeTiming();
+  for (int call = 0; call < kCalls; ++call) {
+    benchmark::State call_timer;
+    device.ParallelFor(kElements, eigen::OpCost(8, 0, 20),
+                       [&data, &sum](eigen::Index first, eigen::Index last) {
+                         int64_t local = 0;
+                         for (eigen::Index i = first; i < last; ++i) {
+                           local += data[i];
+                         }
+                         sum += local;
+                       });
+    state->AddLatencySample(call_timer.elapsed_seconds());
+  }
+  state->PauseTiming();
+  CHECK_EQ(sum.load(), int64_t(kCalls) * kElements);
+  state->SetItemsProcessed(kCalls);
+}
+
+// One task running on a worker spawns kChildren tasks.  The non-blocking
+// pool queues them on that worker, so every child that runs on another
+// thread was stolen; the simple pool has one shared queue, where the same
+// counter measures how much work migrates.
+void BM_Steal(const PoolFactory& factory, int num_threads,
+              benchmark::State* state) {
+  const int kChildren = 20000;
+  state->PauseTiming();
+  std::unique_ptr<eigen::ThreadPoolInterface> pool(factory(num_threads));
+  eigen::Barrier barrier(kChildren);
+  std::atomic<int64_t> stolen(0);
+  eigen::ThreadPoolInterface* p = pool.get();
+  state->ResumeTiming();
+  pool->Schedule([p, &barrier, &stolen]() {
+    const int parent = p->CurrentThreadId();
+    for (int i = 0; i < kChildren; ++i) {
+      p->Schedule([p, parent, &barrier, &stolen]() {
+        volatile int spin = 0;
+        for (int j = 0; j < 200; ++j) spin = spin + j;
+        if (p->CurrentThreadId() != parent) ++stolen;
+        barrier.Notify();
+      });
+    }
+  });
+  barrier.Wait();
+  state->PauseTiming();
+  state->SetItemsProcessed(kChildren);
+  state->SetCounter("stolen_fraction",
+                    static_cast<double>(stolen.load()) / kChildren);
+}
+
+typedef void (*BenchmarkFn)(const PoolFactory&, int, benchmark::State*);
+
+int RegisterAll() {
+  const struct {
+    const char* name;
+    BenchmarkFn fn;
+  } benchmarks[] = {
+      {"Schedule", BM_Schedule},
+      {"FanOutFanIn", BM_FanOutFanIn},
+      {"ParallelFor", BM_ParallelFor},
+      {"ShortParallelFor", BM_ShortParallelFor},
+      {"Steal", BM_Steal},
+  };
+  for (const auto& b : benchmarks) {
+    for (const PoolKind& kind : PoolKinds()) {
+      for (int threads : kThreadCounts) {
+        const BenchmarkFn fn = b.fn;
+        const PoolFactory factory = kind.factory;
+        benchmark::Register(
+            strings::StrCat(b.name, "/", kind.name, "/threads:", threads),
+            [fn, factory, threads](benchmark::State* state) {
+              fn(factory, threads, state);
+            });
+      }
+    }
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
@@ -0,0 +1,149 @@
+// Parsing about 16MB of TSV or CSV with std::getline and str_util::Split,
+// which is how text jobs read input before, against DelimitedTextReader
+// over a ZeroCopyInputStream and ParseDelimitedTextInParallel.  Items are
+// input bytes.
+//
+// Usage: delimited_text_benchmark [--filter=...] [--format=json] ...
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/logging.h"
+#include "core/base/threadpool.h"
+#include "core/io/delimited_text.h"
+#include "core/io/zero_copy_stream_impl_lite.h"
+#include "core/strings/str_util.h"
+#include "core/strings/strcat.h"
+#include "core/system/env.h"
+
+namespace mr {
+namespace {
+
+using io::DelimitedTextOptions;
+
+// Lines of 8 fields of about "field_length" bytes; with "quoted", one
+// field in four is quoted and holds a delimiter.
+std::string MakeText(size_t field_length, bool quoted) {
+  std::mt19937 rng(301);
+  std::string text;
+  while (text.size() < (16 << 20)) {
+    for (int f = 0; f < 8; ++f) {
+      if (f > 0) text.push_back(quoted ? ',' : '\t');
+      const bool quote = quoted && rng() % 4 == 0;
+      if (quote) text += "\"a,";
+      const size_t length = 1 + rng() % (2 * field_length);
+      for (size_t i = 0; i < length; ++i) text.push_back('a' + rng() % 26);
+      if (quote) text.push_back('"');
+    }
+    text.push_back('\n');
+  }
+  return text;
+}
+
+DelimitedTextOptions Options(bool quoted) {
+  DelimitedTextOptions options;
+  options.delimiter = quoted ? ',' : '\t';
+  options.quote = quoted ? '"' : '\0';
+  return options;
+}
+
+// getline + Split cannot handle quoting; it only runs on TSV.
+size_t ParseGetline(const std::string& text) {
+  std::istringstream in(text);
+  std::string line;
+  size_t checksum = 0;
+  while (std::getline(in, line)) {
+    for (const std::string& field : str_util::Split(line, '\t')) {
+      checksum += field.size();
+    }
+  }
+  return checksum;
+}
+
+size_t ParseReader(const std::string& text, bool quoted) {
+  ArrayInputStream input(text.data(), text.size(), 512 << 10);
+  io::DelimitedTextReader reader(&input, Options(quoted));
+  std::vector<StringPiece> fields;
+  size_t checksum = 0;
+  while (reader.ReadRecord(&fields).ok()) {
+    for (StringPiece field : fields) checksum += field.size();
+  }
+  return checksum;
+}
+
+size_t ParseParallel(const std::string& text, bool quoted,
+                     thread::ThreadPool* pool) {
+  std::vector<size_t> checksums(pool->NumThreads() * 16, 0);
+  CHECK(io::ParseDelimitedTextInParallel(
+            pool, text, Options(quoted),
+            [&checksums](int chunk, gtl::ArraySlice<StringPiece> fields) {
+              for (StringPiece field : fields) {
+                checksums[chunk] += field.size();
+              }
+              return Status::OK;
+            })
+            .ok());
+  size_t checksum = 0;
+  for (size_t c : checksums) checksum += c;
+  return checksum;
+}
+
+void BM_Parse(const std::string& impl, size_t field_length, bool quoted,
+              benchmark::State* state) {
+  state->PauseTiming();
+  const std::string text = MakeText(field_length, quoted);
+  // Only the parallel parse gets a pool; idle workers spinning for work
+  // would slow down the others.
+  std::unique_ptr<thread::ThreadPool> pool;
+  if (impl == "parallel") {
+    pool.reset(new thread::ThreadPool(
+        Env::Default(), "parse",
+        std::max(1u, std::thread::hardware_concurrency())));
+  }
+  state->ResumeTiming();
+  size_t checksum;
+  if (impl == "getline") {
+    checksum = ParseGetline(text);
+  } else if (impl == "reader") {
+    checksum = ParseReader(text, quoted);
+  } else {
+    checksum = ParseParallel(text, quoted, pool.get());
+  }
+  state->PauseTiming();
+  CHECK_GT(checksum, 0);
+  state->SetItemsProcessed(text.size());
+}
+
+int RegisterAll() {
+  const size_t kFieldLengths[] = {4, 32};
+  for (const char* impl : {"getline", "reader", "parallel"}) {
+    for (bool quoted : {false, true}) {
+      if (quoted && std::string(impl) == "getline") continue;
+      for (size_t length : kFieldLengths) {
+        const std::string name = impl;
+        benchmark::Register(
+            strings::StrCat("Parse/", impl, quoted ? "/csv" : "/tsv",
+                            "/len:", length),
+            [name, length, quoted](benchmark::State* state) {
+              BM_Parse(name, length, quoted, state);
+            });
+      }
+    }
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
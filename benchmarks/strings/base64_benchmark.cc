@@ -0,0 +1,106 @@
+// Base64 of 16MB with a byte-at-a-time loop like the one base64.cc used
+// before, against the vector kernels behind Base64Encode/Base64Decode and
+// the streaming Base64Encoder/Base64Decoder over 64KB buffers.  Items are
+// unencoded bytes.
+//
+// Usage: base64_benchmark [--filter=...] [--format=json] ...
+
+#include <stddef.h>
+
+#include <random>
+#include <string>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/logging.h"
+#include "core/io/zero_copy_stream_impl_lite.h"
+#include "core/strings/base64.h"
+#include "core/strings/strcat.h"
+
+namespace mr {
+namespace {
+
+static const size_t kSize = 16 << 20;
+static const int kBlockSize = 64 << 10;
+
+std::string MakeData() {
+  std::mt19937 rng(301);
+  std::string data(kSize, '\0');
+  for (char& c : data) c = static_cast<char>(rng());
+  return data;
+}
+
+void ScalarEncode(const std::string& data, std::string* encoded) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  encoded->resize(data.size() / 3 * 4);
+  char* out = &(*encoded)[0];
+  for (size_t i = 0; i + 3 <= data.size(); i += 3) {
+    const char* p = data.data() + i;
+    *out++ = kChars[(p[0] >> 2) & 0x3F];
+    *out++ = kChars[((p[0] & 0x03) << 4) | ((p[1] >> 4) & 0x0F)];
+    *out++ = kChars[((p[1] & 0x0F) << 2) | ((p[2] >> 6) & 0x03)];
+    *out++ = kChars[p[2] & 0x3F];
+  }
+}
+
+void BM_Encode(const std::string& impl, benchmark::State* state) {
+  state->PauseTiming();
+  const std::string data = MakeData();
+  std::string encoded;
+  encoded.reserve(kSize / 3 * 4 + 4);
+  state->ResumeTiming();
+  if (impl == "scalar") {
+    ScalarEncode(data, &encoded);
+  } else if (impl == "string") {
+    CHECK(Base64Encode(data, &encoded).ok());
+  } else {
+    ArrayInputStream input(data.data(), data.size(), kBlockSize);
+    StringOutputStream output(&encoded);
+    CHECK(Base64Encode(&input, false, &output).ok());
+  }
+  state->PauseTiming();
+  CHECK_GE(encoded.size(), kSize / 3 * 4);
+  state->SetItemsProcessed(kSize);
+}
+
+void BM_Decode(const std::string& impl, benchmark::State* state) {
+  state->PauseTiming();
+  std::string encoded;
+  CHECK(Base64Encode(MakeData(), &encoded).ok());
+  std::string decoded;
+  decoded.reserve(kSize);
+  state->ResumeTiming();
+  if (impl == "string") {
+    CHECK(Base64Decode(encoded, &decoded).ok());
+  } else {
+    ArrayInputStream input(encoded.data(), encoded.size(), kBlockSize);
+    StringOutputStream output(&decoded);
+    CHECK(Base64Decode(&input, &output).ok());
+  }
+  state->PauseTiming();
+  CHECK_GE(decoded.size(), kSize);
+  state->SetItemsProcessed(kSize);
+}
+
+int RegisterAll() {
+  for (const char* impl : {"scalar", "string", "stream"}) {
+    const std::string name = impl;
+    benchmark::Register(
+        strings::StrCat("Encode/", impl),
+        [name](benchmark::State* state) { BM_Encode(name, state); });
+  }
+  for (const char* impl : {"string", "stream"}) {
+    const std::string name = impl;
+    benchmark::Register(
+        strings::StrCat("Decode/", impl),
+        [name](benchmark::State* state) { BM_Decode(name, state); });
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
@@ -0,0 +1,166 @@
+// Formatting and parsing numbers with the C library, which is what
+// numbers.cc did before, against the table-driven integer formatting, the
+// shortest round-trip DoubleToBuffer and the Eisel-Lemire safe_strtod.
+// Items are numbers.
+//
+// Usage: numbers_benchmark [--filter=...] [--format=json] ...
+
+#include <float.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/strings/numbers.h"
+#include "core/strings/strcat.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace {
+
+static const int kCount = 1 << 20;
+
+// Integers of 1 to 19 digits, equally often.
+std::vector<int64_t> MakeInts() {
+  std::mt19937_64 rng(301);
+  std::vector<int64_t> values;
+  for (int i = 0; i < kCount; ++i) {
+    int64_t limit = 10;
+    for (int digits = rng() % 18; digits > 0; --digits) limit *= 10;
+    const int64_t v = rng() % limit;
+    values.push_back(rng() % 2 ? v : -v);
+  }
+  return values;
+}
+
+// "short" values have a few decimals, like prices and measurements; the
+// others are random doubles that need 15 to 17 digits.
+std::vector<double> MakeDoubles(bool short_values) {
+  std::mt19937_64 rng(301);
+  std::uniform_real_distribution<double> uniform(-1e6, 1e6);
+  std::vector<double> values;
+  for (int i = 0; i < kCount; ++i) {
+    const double v = uniform(rng);
+    values.push_back(short_values ? static_cast<int64_t>(v * 100) / 100.0
+                                  : v);
+  }
+  return values;
+}
+
+std::vector<std::string> Format(const std::vector<double>& values) {
+  std::vector<std::string> strings;
+  char buffer[strings::kFastToBufferSize];
+  for (double v : values) {
+    strings.push_back(strings::DoubleToBuffer(v, buffer));
+  }
+  return strings;
+}
+
+void BM_FormatInt64(bool fast, benchmark::State* state) {
+  state->PauseTiming();
+  const std::vector<int64_t> values = MakeInts();
+  size_t checksum = 0;
+  char buffer[strings::kFastToBufferSize];
+  state->ResumeTiming();
+  for (int64_t v : values) {
+    if (fast) {
+      checksum += strings::FastInt64ToBufferLeft(v, buffer) - buffer;
+    } else {
+      checksum += snprintf(buffer, sizeof(buffer), "%lld",
+                           static_cast<long long>(v));
+    }
+  }
+  state->PauseTiming();
+  CHECK_GT(checksum, 0);
+  state->SetItemsProcessed(values.size());
+}
+
+// The previous DoubleToBuffer(): %.15g if it round-trips, else %.17g.
+void SnprintfRoundTrip(double value, char* buffer) {
+  snprintf(buffer, strings::kFastToBufferSize, "%.*g", DBL_DIG, value);
+  if (strtod(buffer, nullptr) != value) {
+    snprintf(buffer, strings::kFastToBufferSize, "%.*g", DBL_DIG + 2, value);
+  }
+}
+
+void BM_FormatDouble(bool fast, bool short_values, benchmark::State* state) {
+  state->PauseTiming();
+  const std::vector<double> values = MakeDoubles(short_values);
+  size_t checksum = 0;
+  char buffer[strings::kFastToBufferSize];
+  state->ResumeTiming();
+  for (double v : values) {
+    if (fast) {
+      strings::DoubleToBuffer(v, buffer);
+    } else {
+      SnprintfRoundTrip(v, buffer);
+    }
+    checksum += buffer[0];
+  }
+  state->PauseTiming();
+  CHECK_GT(checksum, 0);
+  state->SetItemsProcessed(values.size());
+}
+
+void BM_ParseDouble(const std::string& impl, bool short_values,
+                    benchmark::State* state) {
+  state->PauseTiming();
+  const std::vector<std::string> strings = Format(MakeDoubles(short_values));
+  const std::vector<StringPiece> column(strings.begin(), strings.end());
+  std::vector<double> values(strings.size());
+  state->ResumeTiming();
+  if (impl == "strtod") {
+    for (size_t i = 0; i < strings.size(); ++i) {
+      values[i] = strtod(strings[i].c_str(), nullptr);
+    }
+  } else if (impl == "safe_strtod") {
+    for (size_t i = 0; i < strings.size(); ++i) {
+      CHECK(strings::safe_strtod(strings[i].c_str(), &values[i]));
+    }
+  } else {
+    CHECK_EQ(column.size(), strings::ParseDoubles(column, &values));
+  }
+  state->PauseTiming();
+  CHECK_NE(values[0], values[1]);
+  state->SetItemsProcessed(values.size());
+}
+
+int RegisterAll() {
+  for (bool fast : {false, true}) {
+    benchmark::Register(
+        strings::StrCat("FormatInt64/", fast ? "fast" : "snprintf"),
+        [fast](benchmark::State* state) { BM_FormatInt64(fast, state); });
+  }
+  for (bool short_values : {true, false}) {
+    const char* values = short_values ? "/short" : "/random";
+    for (bool fast : {false, true}) {
+      benchmark::Register(
+          strings::StrCat("FormatDouble/", fast ? "shortest" : "snprintf",
+                          values),
+          [fast, short_values](benchmark::State* state) {
+            BM_FormatDouble(fast, short_values, state);
+          });
+    }
+    for (const char* impl : {"strtod", "safe_strtod", "column"}) {
+      const std::string name = impl;
+      benchmark::Register(
+          strings::StrCat("ParseDouble/", impl, values),
+          [name, short_values](benchmark::State* state) {
+            BM_ParseDouble(name, short_values, state);
+          });
+    }
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
@@ -0,0 +1,221 @@
+// Throughput of OrderedCode::WriteString and ReadString against the
+// byte-at-a-time code they replaced, for several key lengths, with and
+// without bytes that need escaping.  Items are input bytes.  The
+// EncodeKeys benchmarks build (string, uint64, int64) sort keys one
+// string per key and with OrderedCode::WriteKeys; items are keys.
+//
+// Usage: ordered_code_benchmark [--filter=...] [--format=json] ...
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/logging.h"
+#include "core/strings/ordered_code.h"
+#include "core/strings/strcat.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace {
+
+using strings::OrderedCode;
+
+// The encoder and decoder before the SIMD scan, for comparison.
+namespace legacy {
+
+inline bool IsSpecialByte(char c) { return ((unsigned char)(c + 1)) < 2; }
+
+const char* SkipToNextSpecialByte(const char* start, const char* limit) {
+  const char* p = start;
+  while (p < limit && !IsSpecialByte(*p)) p++;
+  return p;
+}
+
+void WriteString(std::string* dest, StringPiece s) {
+  const char* p = s.data();
+  const char* limit = p + s.size();
+  const char* copy_start = p;
+  while (true) {
+    p = SkipToNextSpecialByte(p, limit);
+    if (p >= limit) break;
+    const char c = *(p++);
+    dest->append(copy_start, p - copy_start - 1);
+    dest->push_back(c);
+    dest->push_back(c == '\0' ? '\xff' : '\0');
+    copy_start = p;
+  }
+  if (p > copy_start) dest->append(copy_start, p - copy_start);
+  dest->push_back('\0');
+  dest->push_back('\001');
+}
+
+bool ReadString(StringPiece* src, std::string* result) {
+  const char* start = src->data();
+  const char* limit = src->data() + src->size() - 1;
+  const char* copy_start = start;
+  while (true) {
+    start = SkipToNextSpecialByte(start, limit);
+    if (start >= limit) return false;
+    const char c = *(start++);
+    result->append(copy_start, start - copy_start - 1);
+    const char next = *(start++);
+    if (c == '\0' && next == '\001') {
+      src->remove_prefix(start - src->data());
+      return true;
+    }
+    result->push_back(c == '\0' ? '\0' : '\xff');
+    copy_start = start;
+  }
+}
+
+}  // namespace legacy
+
+typedef void (*WriteFn)(std::string*, StringPiece);
+typedef bool (*ReadFn)(StringPiece*, std::string*);
+
+// About 1MB of keys of "length" bytes; one byte in "special_one_in" is
+// 0x00 or 0xff (0 for none).
+std::vector<std::string> MakeKeys(size_t length, int special_one_in) {
+  std::mt19937 rng(301);
+  std::vector<std::string> keys(std::max<size_t>(1, (1 << 20) / length));
+  for (std::string& key : keys) {
+    key.resize(length);
+    for (char& c : key) {
+      c = static_cast<char>(1 + rng() % 254);
+      if (special_one_in > 0 && rng() % special_one_in == 0) {
+        c = (rng() % 2) ? '\0' : '\xff';
+      }
+    }
+  }
+  return keys;
+}
+
+void BM_Encode(WriteFn write, size_t length, int special_one_in,
+               benchmark::State* state) {
+  state->PauseTiming();
+  const std::vector<std::string> keys = MakeKeys(length, special_one_in);
+  std::string out;
+  state->ResumeTiming();
+  for (const std::string& key : keys) {
+    out.clear();
+    write(&out, key);
+  }
+  state->PauseTiming();
+  state->SetItemsProcessed(keys.size() * length);
+}
+
+void BM_Decode(ReadFn read, size_t length, int special_one_in,
+               benchmark::State* state) {
+  state->PauseTiming();
+  const std::vector<std::string> keys = MakeKeys(length, special_one_in);
+  std::vector<std::string> encoded(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    OrderedCode::WriteString(&encoded[i], keys[i]);
+  }
+  std::string out;
+  state->ResumeTiming();
+  for (const std::string& e : encoded) {
+    StringPiece in(e);
+    out.clear();
+    CHECK(read(&in, &out));
+  }
+  state->PauseTiming();
+  state->SetItemsProcessed(keys.size() * length);
+}
+
+struct KeyColumns {
+  std::vector<std::string> names;
+  std::vector<StringPiece> name_pieces;
+  std::vector<uint64_t> counts;
+  std::vector<int64_t> deltas;
+};
+
+KeyColumns MakeKeyColumns() {
+  KeyColumns columns;
+  columns.names = MakeKeys(16, 100);
+  std::mt19937 rng(302);
+  for (const std::string& name : columns.names) {
+    columns.name_pieces.push_back(name);
+    columns.counts.push_back(rng() % 100000);
+    columns.deltas.push_back(static_cast<int32_t>(rng()));
+  }
+  return columns;
+}
+
+void BM_EncodeKeysPerKey(benchmark::State* state) {
+  state->PauseTiming();
+  const KeyColumns columns = MakeKeyColumns();
+  const size_t n = columns.names.size();
+  std::vector<std::string> keys(n);
+  state->ResumeTiming();
+  for (size_t i = 0; i < n; ++i) {
+    OrderedCode::WriteString(&keys[i], columns.name_pieces[i]);
+    OrderedCode::WriteNumIncreasing(&keys[i], columns.counts[i]);
+    OrderedCode::WriteSignedNumIncreasing(&keys[i], columns.deltas[i]);
+  }
+  state->PauseTiming();
+  state->SetItemsProcessed(n);
+}
+
+void BM_EncodeKeysBatch(benchmark::State* state) {
+  state->PauseTiming();
+  const KeyColumns columns = MakeKeyColumns();
+  std::string buffer;
+  std::vector<size_t> offsets;
+  state->ResumeTiming();
+  OrderedCode::WriteKeys(
+      {OrderedCode::Column::Strings(columns.name_pieces),
+       OrderedCode::Column::NumIncreasing(columns.counts),
+       OrderedCode::Column::SignedNumIncreasing(columns.deltas)},
+      &buffer, &offsets);
+  state->PauseTiming();
+  state->SetItemsProcessed(columns.names.size());
+}
+
+int RegisterAll() {
+  const struct {
+    const char* name;
+    WriteFn write;
+    ReadFn read;
+  } impls[] = {
+      {"legacy", legacy::WriteString, legacy::ReadString},
+      {"simd", OrderedCode::WriteString, OrderedCode::ReadString},
+  };
+  const size_t kLengths[] = {8, 32, 128, 1024};
+  const struct {
+    const char* name;
+    int one_in;
+  } mixes[] = {{"clean", 0}, {"escaped:1%", 100}};
+  for (const auto& impl : impls) {
+    for (size_t length : kLengths) {
+      for (const auto& mix : mixes) {
+        const std::string suffix =
+            strings::StrCat("/", impl.name, "/len:", length, "/", mix.name);
+        const WriteFn write = impl.write;
+        const ReadFn read = impl.read;
+        const int one_in = mix.one_in;
+        benchmark::Register(strings::StrCat("Encode", suffix),
+                            [write, length, one_in](benchmark::State* state) {
+                              BM_Encode(write, length, one_in, state);
+                            });
+        benchmark::Register(strings::StrCat("Decode", suffix),
+                            [read, length, one_in](benchmark::State* state) {
+                              BM_Decode(read, length, one_in, state);
+                            });
+      }
+    }
+  }
+  benchmark::Register("EncodeKeys/per_key", BM_EncodeKeysPerKey);
+  benchmark::Register("EncodeKeys/batch", BM_EncodeKeysBatch);
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
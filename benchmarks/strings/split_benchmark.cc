@@ -0,0 +1,123 @@
+// Splitting tab-separated lines with str_util::Split, which copies every
+// field into a string, against the lazy SplitPieces ranges.  Items are
+// input bytes.
+//
+// Usage: split_benchmark [--filter=...] [--format=json] ...
+
+#include <stddef.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/strings/split.h"
+#include "core/strings/str_util.h"
+#include "core/strings/strcat.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace {
+
+using str_util::ByAnyChar;
+using str_util::ByString;
+using str_util::SplitPieces;
+
+// About 4MB of newline-terminated lines of "fields" tab-separated fields
+// of 1 to 2 * "field_length" bytes.
+std::string MakeText(int fields, size_t field_length) {
+  std::mt19937 rng(301);
+  std::string text;
+  while (text.size() < (4 << 20)) {
+    for (int f = 0; f < fields; ++f) {
+      if (f > 0) text.push_back('\t');
+      const size_t length = 1 + rng() % (2 * field_length);
+      for (size_t i = 0; i < length; ++i) text.push_back('a' + rng() % 26);
+    }
+    text.push_back('\n');
+  }
+  return text;
+}
+
+// Calls fn(text, &checksum) on the lines of "text", and makes sure the
+// work is not optimized away.
+template <typename Fn>
+void BM_Split(int fields, size_t field_length, Fn fn,
+              benchmark::State* state) {
+  state->PauseTiming();
+  const std::string text = MakeText(fields, field_length);
+  size_t checksum = 0;
+  state->ResumeTiming();
+  fn(StringPiece(text), &checksum);
+  state->PauseTiming();
+  CHECK_GT(checksum, 0);
+  state->SetItemsProcessed(text.size());
+}
+
+void SplitCopies(StringPiece text, size_t* checksum) {
+  for (const std::string& line : str_util::Split(text, '\n')) {
+    for (const std::string& field : str_util::Split(line, '\t')) {
+      *checksum += field.size();
+    }
+  }
+}
+
+void SplitLazily(StringPiece text, size_t* checksum) {
+  for (StringPiece line : SplitPieces(text, '\n')) {
+    for (StringPiece field : SplitPieces(line, '\t')) {
+      *checksum += field.size();
+    }
+  }
+}
+
+void SplitAnyChar(StringPiece text, size_t* checksum) {
+  for (StringPiece field : SplitPieces(text, ByAnyChar("\t\n"))) {
+    *checksum += field.size();
+  }
+}
+
+void SplitString(StringPiece text, size_t* checksum) {
+  for (StringPiece line : SplitPieces(text, ByString("\n"))) {
+    for (StringPiece field : SplitPieces(line, ByString("\t"))) {
+      *checksum += field.size();
+    }
+  }
+}
+
+int RegisterAll() {
+  typedef void (*SplitFn)(StringPiece, size_t*);
+  const struct {
+    const char* name;
+    SplitFn fn;
+  } impls[] = {
+      {"copies", SplitCopies},
+      {"pieces", SplitLazily},
+      {"any_char", SplitAnyChar},
+      {"by_string", SplitString},
+  };
+  const struct {
+    int fields;
+    size_t field_length;
+  } shapes[] = {{8, 4}, {8, 32}, {4, 256}};
+  for (const auto& impl : impls) {
+    for (const auto& shape : shapes) {
+      const SplitFn fn = impl.fn;
+      const int fields = shape.fields;
+      const size_t field_length = shape.field_length;
+      benchmark::Register(
+          strings::StrCat("SplitTsv/", impl.name, "/fields:", fields,
+                          "/len:", field_length),
+          [fn, fields, field_length](benchmark::State* state) {
+            BM_Split(fields, field_length, fn, state);
+          });
+    }
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
@@ -0,0 +1,146 @@
+// CEscape, CUnescape and Lowercase over 4MB of mostly printable text, with
+// byte-at-a-time loops like the ones str_util.cc used before against the
+// current versions.  Items are input bytes.
+//
+// Usage: str_util_benchmark [--filter=...] [--format=json] ...
+
+#include <ctype.h>
+#include <stddef.h>
+
+#include <random>
+#include <string>
+
+#include "benchmarks/benchmark.h"
+#include "core/strings/str_util.h"
+#include "core/strings/strcat.h"
+
+namespace mr {
+namespace str_util {
+namespace {
+
+static const size_t kSize = 4 << 20;
+
+// Log-like text: one byte in "escape_every" needs escaping.
+string MakeText(int escape_every) {
+  std::mt19937 rng(301);
+  string text(kSize, '\0');
+  for (char& c : text) {
+    c = rng() % escape_every == 0 ? '\n' : static_cast<char>('0' + rng() % 75);
+    if (c == '\\') c = 'x';
+  }
+  return text;
+}
+
+string ScalarCEscape(StringPiece src) {
+  static const char hex_char[] = "0123456789abcdef";
+  string dest;
+  for (unsigned char c : src) {
+    switch (c) {
+      case '\n':
+        dest.append("\\n");
+        break;
+      case '\r':
+        dest.append("\\r");
+        break;
+      case '\t':
+        dest.append("\\t");
+        break;
+      case '\"':
+        dest.append("\\\"");
+        break;
+      case '\'':
+        dest.append("\\'");
+        break;
+      case '\\':
+        dest.append("\\\\");
+        break;
+      default:
+        if ((c >= 0x80) || !isprint(c)) {
+          dest.append("\\");
+          dest.push_back(hex_char[c / 64]);
+          dest.push_back(hex_char[(c % 64) / 8]);
+          dest.push_back(hex_char[c % 8]);
+        } else {
+          dest.push_back(c);
+        }
+    }
+  }
+  return dest;
+}
+
+string ScalarLowercase(StringPiece s) {
+  string result(s.data(), s.size());
+  for (char& c : result) {
+    c = tolower(c);
+  }
+  return result;
+}
+
+void BM_CEscape(bool scalar, int escape_every, benchmark::State* state) {
+  state->PauseTiming();
+  const string text = MakeText(escape_every);
+  state->ResumeTiming();
+  const string escaped = scalar ? ScalarCEscape(text) : CEscape(text);
+  state->PauseTiming();
+  CHECK_GT(escaped.size(), text.size());
+  state->SetItemsProcessed(text.size());
+}
+
+void BM_CUnescape(int escape_every, benchmark::State* state) {
+  state->PauseTiming();
+  const string escaped = CEscape(MakeText(escape_every));
+  string text;
+  state->ResumeTiming();
+  CHECK(CUnescape(escaped, &text, nullptr));
+  state->PauseTiming();
+  state->SetItemsProcessed(escaped.size());
+}
+
+void BM_Lowercase(const string& impl, benchmark::State* state) {
+  state->PauseTiming();
+  string text = MakeText(1000);
+  state->ResumeTiming();
+  if (impl == "scalar") {
+    text = ScalarLowercase(text);
+  } else if (impl == "copy") {
+    text = Lowercase(text);
+  } else {
+    LowercaseInPlace(&text);
+  }
+  state->PauseTiming();
+  CHECK_EQ(kSize, text.size());
+  state->SetItemsProcessed(kSize);
+}
+
+int RegisterAll() {
+  for (int escape_every : {1000, 10}) {
+    const string suffix = strings::StrCat("/1in", escape_every);
+    for (bool scalar : {true, false}) {
+      benchmark::Register(
+          strings::StrCat("CEscape/", scalar ? "scalar" : "runs", suffix),
+          [scalar, escape_every](benchmark::State* state) {
+            BM_CEscape(scalar, escape_every, state);
+          });
+    }
+    benchmark::Register(strings::StrCat("CUnescape", suffix),
+                        [escape_every](benchmark::State* state) {
+                          BM_CUnescape(escape_every, state);
+                        });
+  }
+  for (const char* impl : {"scalar", "copy", "in_place"}) {
+    const string name = impl;
+    benchmark::Register(strings::StrCat("Lowercase/", impl),
+                        [name](benchmark::State* state) {
+                          BM_Lowercase(name, state);
+                        });
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace str_util
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
@@ -0,0 +1,76 @@
+// Building short shuffle-key-like strings ("<table>/<shard>/<hex id>") with
+// snprintf into a std::string, with StrCat, and with a StringBuilder whose
+// arena is reset every few thousand keys.  Items are keys.
+//
+// Usage: strcat_benchmark [--filter=...] [--format=json] ...
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmarks/benchmark.h"
+#include "core/base/arena.h"
+#include "core/strings/strcat.h"
+#include "core/strings/string_builder.h"
+
+namespace mr {
+namespace strings {
+namespace {
+
+static const int kCount = 1 << 20;
+static const int kKeysPerReset = 4096;
+
+void BM_BuildKeys(const string& impl, benchmark::State* state) {
+  state->PauseTiming();
+  const string table = "user_events";
+  Arena arena(64 << 10);
+  size_t checksum = 0;
+  state->ResumeTiming();
+  for (int i = 0; i < kCount; ++i) {
+    const int shard = i % 1000;
+    const uint64_t id = i * 0x9E3779B97F4A7C15ULL;
+    if (impl == "snprintf") {
+      char buffer[64];
+      const int n = snprintf(buffer, sizeof(buffer), "%s/%05d/%016llx",
+                             table.c_str(), shard,
+                             static_cast<unsigned long long>(id));
+      const string key(buffer, n);
+      checksum += key.size();
+    } else if (impl == "strcat") {
+      const string key = StrCat(table, "/", Dec(shard, ZERO_PAD_5), "/",
+                                Hex(id, ZERO_PAD_16));
+      checksum += key.size();
+    } else {
+      StringBuilder key(&arena);
+      key.Append(table, "/", Dec(shard, ZERO_PAD_5), "/",
+                 Hex(id, ZERO_PAD_16));
+      checksum += key.size();
+      if (i % kKeysPerReset == kKeysPerReset - 1) arena.Reset();
+    }
+  }
+  state->PauseTiming();
+  CHECK_EQ(checksum, kCount * (table.size() + 23));
+  state->SetItemsProcessed(kCount);
+}
+
+int RegisterAll() {
+  for (const char* impl : {"snprintf", "strcat", "builder"}) {
+    const string name = impl;
+    benchmark::Register(StrCat("BuildKeys/", impl),
+                        [name](benchmark::State* state) {
+                          BM_BuildKeys(name, state);
+                        });
+  }
+  return 0;
+}
+
+static int registered = RegisterAll();
+
+}  // namespace
+}  // namespace strings
+}  // namespace mr
+
+int main(int argc, char** argv) { return mr::benchmark::Main(argc, argv); }
@@ -0,0 +1,125 @@
+#include "core/base/arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "core/base/mem.h"
+
+namespace mr {
+
+const size_t Arena::kHugePageSize;
+const size_t Arena::kDefaultAlignment;
+
+namespace {
+
+// Alignment of every block; a block is never shared across cache lines
+// with anything else.
+static const int kBlockAlignment = 64;
+
+}  // namespace
+
+Arena::Arena(const Options& options) : options_(options) {
+  CHECK_GE(options_.block_size, kBlockAlignment);
+}
+
+Arena::Arena(size_t block_size)
+    : Arena([block_size]() {
+        Options options;
+        options.block_size = block_size;
+        return options;
+      }()) {}
+
+Arena::~Arena() {
+  for (const Block& b : blocks_) FreeBlock(b);
+  for (const Block& b : large_blocks_) FreeBlock(b);
+}
+
+char* Arena::AllocSlow(size_t size, size_t alignment) {
+  if (size + alignment > options_.block_size / 4) {
+    // Oversized: a block of its own, so the current block keeps its tail.
+    Block b = NewBlock(size + alignment);
+    large_blocks_.push_back(b);
+    large_bytes_ += b.size;
+    const uintptr_t p = reinterpret_cast<uintptr_t>(b.mem);
+    return reinterpret_cast<char*>((p + alignment - 1) & ~(alignment - 1));
+  }
+  if (used_blocks_ == blocks_.size()) {
+    blocks_.push_back(NewBlock(options_.block_size));
+  }
+  StartBlock(blocks_[used_blocks_++]);
+  char* result = AllocAligned(size, alignment);
+  DCHECK(result != nullptr);
+  return result;
+}
+
+void Arena::StartBlock(const Block& block) {
+  ptr_ = block.mem;
+  remaining_ = block.size;
+}
+
+Arena::Block Arena::NewBlock(size_t min_size) {
+  Block b;
+  b.size = std::max(min_size, options_.block_size);
+  b.huge = false;
+  b.mem = nullptr;
+  if (options_.use_huge_pages) {
+    // Over-map by one huge page so the block can start on a huge page
+    // boundary, then hand the unaligned head and tail back.
+    const size_t size = (b.size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    void* raw = mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw != MAP_FAILED) {
+      char* start = static_cast<char*>(raw);
+      char* aligned = reinterpret_cast<char*>(
+          (reinterpret_cast<uintptr_t>(start) + kHugePageSize - 1) &
+          ~(kHugePageSize - 1));
+      const size_t head = aligned - start;
+      if (head > 0) munmap(start, head);
+      munmap(aligned + size, kHugePageSize - head);
+#ifdef MADV_HUGEPAGE
+      madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+      b.mem = aligned;
+      b.size = size;
+      b.huge = true;
+    } else {
+      LOG(WARNING) << "Arena: huge page mmap of " << size
+                   << " bytes failed, using regular pages";
+    }
+  }
+  if (b.mem == nullptr) {
+    b.mem = static_cast<char*>(aligned_malloc(b.size, kBlockAlignment));
+    CHECK(b.mem != nullptr) << "Arena: out of memory allocating " << b.size;
+  }
+  memory_usage_ += b.size;
+  return b;
+}
+
+void Arena::FreeBlock(const Block& block) {
+  if (block.huge) {
+    munmap(block.mem, block.size);
+  } else {
+    aligned_free(block.mem);
+  }
+}
+
+void Arena::Reset() {
+  for (const Block& b : large_blocks_) {
+    memory_usage_ -= b.size;
+    FreeBlock(b);
+  }
+  large_blocks_.clear();
+  large_bytes_ = 0;
+  used_blocks_ = 0;
+  ptr_ = nullptr;
+  remaining_ = 0;
+}
+
+size_t Arena::BytesAllocated() const {
+  size_t total = large_bytes_;
+  for (size_t i = 0; i < used_blocks_; ++i) total += blocks_[i].size;
+  return total - remaining_;
+}
+
+}  // namespace mr
@@ -0,0 +1,175 @@
+// Arena is a bump-pointer allocator for short-lived scratch memory, such
+// as everything a task allocates while it processes one input split.
+// Memory is carved out of chained blocks and is never freed piecemeal:
+// Reset() makes the whole arena reusable at once, and the blocks are kept
+// for the next task.
+//
+// Arena is not thread-safe; give each worker its own.
+//
+// Example:
+//   Arena arena(4096);
+//   char* buf = arena.Alloc(n);
+//   std::vector<int, ArenaAllocator<int>> v{ArenaAllocator<int>(&arena)};
+//   ...
+//   arena.Reset();  // buf and v's storage are gone.
+
+#ifndef CORE_BASE_ARENA_H_
+#define CORE_BASE_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "core/base/logging.h"
+#include "core/base/macros.h"
+
+namespace mr {
+
+class Arena {
+ public:
+  struct Options {
+    // Size of each block obtained from the system.  Allocations larger
+    // than a quarter of this get a block of their own.
+    size_t block_size = 8192;
+
+    // Back blocks with transparent huge pages.  Blocks are then rounded
+    // up to kHugePageSize and mapped on a huge page boundary.  Falls back
+    // to normal pages when the kernel refuses.
+    bool use_huge_pages = false;
+  };
+
+  static const size_t kHugePageSize = 2 << 20;
+
+  explicit Arena(const Options& options);
+  explicit Arena(size_t block_size);
+  ~Arena();
+
+  // Returns "size" bytes aligned to kDefaultAlignment.
+  char* Alloc(size_t size) { return AllocAligned(size, kDefaultAlignment); }
+
+  // Returns "size" bytes aligned to "alignment", which must be a power of
+  // two no larger than the block size.
+  char* AllocAligned(size_t size, size_t alignment) {
+    DCHECK_EQ(alignment & (alignment - 1), 0u);
+    const size_t adjust =
+        (alignment - (reinterpret_cast<uintptr_t>(ptr_) & (alignment - 1))) &
+        (alignment - 1);
+    if (PREDICT_TRUE(size + adjust <= remaining_)) {
+      char* result = ptr_ + adjust;
+      ptr_ = result + size;
+      remaining_ -= size + adjust;
+      return result;
+    }
+    return AllocSlow(size, alignment);
+  }
+
+  // Constructs a T in the arena.  Its destructor is never run, so T must
+  // not own resources outside the arena.
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    void* p = AllocAligned(sizeof(T), alignof(T) < kDefaultAlignment
+                                          ? kDefaultAlignment
+                                          : alignof(T));
+    return new (p) T(std::forward<Args>(args)...);
+  }
+
+  // Makes all memory handed out so far available again.  Regular blocks
+  // are kept for reuse, so this only walks the list of oversized blocks.
+  void Reset();
+
+  // Bytes obtained from the system, including unused block tails.
+  size_t MemoryUsage() const { return memory_usage_; }
+
+  // Bytes handed out since the last Reset(), including alignment padding
+  // and the tails of blocks that were skipped.
+  size_t BytesAllocated() const;
+
+ private:
+  static const size_t kDefaultAlignment = 8;
+
+  struct Block {
+    char* mem;
+    size_t size;
+    bool huge;
+  };
+
+  char* AllocSlow(size_t size, size_t alignment);
+  Block NewBlock(size_t min_size);
+  void FreeBlock(const Block& block);
+  void StartBlock(const Block& block);
+
+  const Options options_;
+
+  // Regular blocks; the first used_blocks_ have been used since Reset().
+  std::vector<Block> blocks_;
+  size_t used_blocks_ = 0;
+  // Blocks made for a single oversized allocation; freed by Reset().
+  std::vector<Block> large_blocks_;
+
+  char* ptr_ = nullptr;
+  size_t remaining_ = 0;
+  size_t memory_usage_ = 0;
+  size_t large_bytes_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+// An STL allocator that draws from an Arena, so standard containers can
+// keep their storage there:
+//
+//   std::vector<int64_t, ArenaAllocator<int64_t>> v{
+//       ArenaAllocator<int64_t>(&arena)};
+//
+// deallocate() is a no-op; memory comes back with Arena::Reset().  The
+// container must not outlive the arena or survive its Reset().
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef ArenaAllocator<U> other;
+  };
+
+  explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)  // NOLINT(runtime/explicit)
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    const size_t alignment = alignof(T) < 8 ? 8 : alignof(T);
+    return reinterpret_cast<T*>(arena_->AllocAligned(n * sizeof(T), alignment));
+  }
+  void deallocate(T* p, size_t n) {
+    (void)p;
+    (void)n;
+  }
+
+  Arena* arena() const { return arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() != b.arena();
+}
+
+}  // namespace mr
+#endif  // CORE_BASE_ARENA_H_
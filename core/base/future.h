@@ -0,0 +1,464 @@
+// Futures and promises whose continuations run on a ThreadPool.
+//
+// A Promise<T> is the producing end of an asynchronous result: it is
+// completed exactly once, with either a value or an error Status.  Every
+// Future<T> obtained from it sees the same result.  Continuations are
+// attached with Then() and run, on the given pool, once the result is
+// there, so nothing blocks while waiting; an error skips them and travels
+// down the chain to the last future.
+//
+// Example:
+//   Promise<string> read;
+//   StartRead(fname, read);  // Calls read.Set(data) or read.SetError(s).
+//   Future<int64_t> n = read.GetFuture().Then(
+//       pool, [](const string& data) { return CountRecords(data); });
+//   ...
+//   int64_t records;
+//   RETURN_IF_ERROR(n.Get(&records));
+//
+// A continuation returning a Future<U> yields a Future<U> that completes
+// with it, which chains asynchronous steps (and lets a step fail, through
+// MakeErrorFuture).  Promise and Future are cheap handles to shared state
+// and may be copied freely.  If the last Promise of a result goes away
+// without completing it, e.g. on a forgotten error path, the result fails
+// with ABORTED instead of leaving its waiters blocked.
+//
+// Future<void> and Promise<void> carry only a Status, for steps such as
+// writes that have no value: Set() takes no argument, Get() returns the
+// Status, and continuations on them take no argument.  Continuations that
+// return nothing yield a Future<void>.
+
+#ifndef CORE_BASE_FUTURE_H_
+#define CORE_BASE_FUTURE_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/base/logging.h"
+#include "core/base/macros.h"
+#include "core/base/manual_constructor.h"
+#include "core/base/status.h"
+#include "core/base/threadpool.h"
+
+namespace mr {
+namespace thread {
+
+template <typename T>
+class Future;
+template <typename T>
+class Promise;
+
+namespace future_internal {
+
+// The result shared by a Promise and its Futures.
+template <typename T>
+class State {
+ public:
+  typedef std::function<void()> Callback;
+
+  State() : ready_(false), promises_(0) {}
+  ~State() {
+    if (ready_ && status_.ok()) value_.Destroy();
+  }
+
+  void SetValue(T value) {
+    std::vector<Callback> callbacks;
+    {
+      std::lock_guard<std::mutex> l(mu_);
+      CHECK(!ready_) << "Promise completed twice";
+      value_.Init(std::move(value));
+      ready_.store(true, std::memory_order_release);
+      callbacks.swap(callbacks_);
+    }
+    Finish(&callbacks);
+  }
+
+  void SetError(const Status& status) {
+    CHECK(!status.ok());
+    std::vector<Callback> callbacks;
+    {
+      std::lock_guard<std::mutex> l(mu_);
+      CHECK(!ready_) << "Promise completed twice";
+      status_ = status;
+      ready_.store(true, std::memory_order_release);
+      callbacks.swap(callbacks_);
+    }
+    Finish(&callbacks);
+  }
+
+  bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+  // Counts the Promise handles; the last one to go fails the result if
+  // it is not there yet.
+  void AddPromise() { promises_.fetch_add(1, std::memory_order_relaxed); }
+  void RemovePromise() {
+    // Once no Promise is left, nothing else can complete the result.
+    if (promises_.fetch_sub(1, std::memory_order_acq_rel) == 1 && !ready()) {
+      SetError(Status(error::ABORTED, "broken promise"));
+    }
+  }
+
+  void Wait() {
+    if (ready()) return;
+    std::unique_lock<std::mutex> l(mu_);
+    while (!ready_) cv_.wait(l);
+  }
+
+  // Only valid once ready.
+  const Status& status() const { return status_; }
+  const T& value() const { return *value_; }
+
+  // Runs "callback" on the completing thread, or right away if the result
+  // is already there.
+  void AddCallback(Callback callback) {
+    {
+      std::lock_guard<std::mutex> l(mu_);
+      if (!ready_) {
+        callbacks_.push_back(std::move(callback));
+        return;
+      }
+    }
+    callback();
+  }
+
+ private:
+  void Finish(std::vector<Callback>* callbacks) {
+    cv_.notify_all();
+    for (Callback& callback : *callbacks) callback();
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::atomic<bool> ready_;
+  std::atomic<int> promises_;
+  Status status_;
+  ManualConstructor<T> value_;  // Constructed iff ready_ && status_.ok().
+  std::vector<Callback> callbacks_;
+
+  DISALLOW_COPY_AND_ASSIGN(State);
+};
+
+// What the State of a Future<void> holds.
+struct Empty {};
+
+template <typename T>
+struct Stored {
+  typedef T type;
+};
+template <>
+struct Stored<void> {
+  typedef Empty type;
+};
+
+// Calls a continuation with the value of "f", or with nothing for a
+// Future<void>.
+template <typename F, typename T>
+auto Apply(F* fn, const Future<T>& f) -> decltype((*fn)(f.value())) {
+  return (*fn)(f.value());
+}
+template <typename F>
+auto Apply(F* fn, const Future<void>&) -> decltype((*fn)()) {
+  return (*fn)();
+}
+
+// The Future returned by Then(), and how it gets completed: a
+// continuation returning a Future<U> is flattened into a Future<U>, and
+// one returning nothing gives a Future<void>.
+template <typename T, typename F,
+          typename R = decltype(Apply(std::declval<F*>(),
+                                      std::declval<const Future<T>&>()))>
+struct ThenTraits {
+  typedef R value_type;
+  static void Run(F* fn, const Future<T>& f, Promise<R>* promise) {
+    promise->Set(Apply(fn, f));
+  }
+};
+
+template <typename T, typename F>
+struct ThenTraits<T, F, void> {
+  typedef void value_type;
+  // A template, as Promise<void> is not defined yet.
+  template <typename P>
+  static void Run(F* fn, const Future<T>& f, P* promise) {
+    Apply(fn, f);
+    promise->Set();
+  }
+};
+
+template <typename T, typename F, typename U>
+struct ThenTraits<T, F, Future<U>> {
+  typedef U value_type;
+  static void Run(F* fn, const Future<T>& f, Promise<U>* promise) {
+    Promise<U> p = *promise;
+    Apply(fn, f).OnReady(nullptr, [p](const Future<U>& inner) mutable {
+      p.SetFrom(inner);
+    });
+  }
+};
+
+// What Promise<T> and Promise<void> share: everything but Set().
+template <typename T>
+class PromiseBase {
+ public:
+  Future<T> GetFuture() const { return Future<T>(state_); }
+
+  // Completes the promise with an error.  Exactly one of Set() and
+  // SetError() must be called, once.  Continuations waiting on the result
+  // run before these return, unless they were given a pool.
+  void SetError(const Status& status) { state_->SetError(status); }
+
+  // Completes the promise with the result of "f", which must be ready.
+  void SetFrom(const Future<T>& f) {
+    if (f.status().ok()) {
+      state_->SetValue(f.state_->value());
+    } else {
+      SetError(f.status());
+    }
+  }
+
+ protected:
+  typedef State<typename Stored<T>::type> StateType;
+
+  PromiseBase() : state_(std::make_shared<StateType>()) {
+    state_->AddPromise();
+  }
+  PromiseBase(const PromiseBase& other) : state_(other.state_) {
+    state_->AddPromise();
+  }
+  PromiseBase(PromiseBase&& other) : state_(std::move(other.state_)) {}
+  PromiseBase& operator=(const PromiseBase& other) {
+    PromiseBase copy(other);
+    state_.swap(copy.state_);
+    return *this;
+  }
+  PromiseBase& operator=(PromiseBase&& other) {
+    state_.swap(other.state_);
+    return *this;
+  }
+  ~PromiseBase() {
+    if (state_ != nullptr) state_->RemovePromise();
+  }
+
+  std::shared_ptr<StateType> state_;
+};
+
+// What Future<T> and Future<void> share: everything but getting the value.
+template <typename T>
+class FutureBase {
+ public:
+  typedef T value_type;
+
+  bool valid() const { return state_ != nullptr; }
+
+  // Whether the result is there; never blocks.
+  bool ready() const { return state_->ready(); }
+
+  // Blocks until the result is there.  Prefer Then() on pool threads.
+  void Wait() const { state_->Wait(); }
+
+  // Waits for the result first.
+  const Status& status() const {
+    Wait();
+    return state_->status();
+  }
+
+  // Calls fn(*this) once the result is there, whether it is a value or an
+  // error.  With a null "pool", fn runs on the thread completing the
+  // promise, or on the caller if the result is already there; keep such
+  // callbacks short.
+  void OnReady(ThreadPool* pool,
+               std::function<void(const Future<T>&)> fn) const {
+    const Future<T> self = static_cast<const Future<T>&>(*this);
+    if (pool == nullptr) {
+      state_->AddCallback([self, fn]() { fn(self); });
+    } else {
+      state_->AddCallback(
+          [self, fn, pool]() { pool->Schedule([self, fn]() { fn(self); }); });
+    }
+  }
+
+  // Returns the future of fn(value()), or of fn() for a Future<void>, run
+  // on "pool" once this future succeeds.  If this future fails, fn is not
+  // called and the returned future fails with the same Status.  If fn
+  // returns a Future<U>, so does Then(); if it returns nothing, Then()
+  // returns a Future<void>.
+  template <typename F>
+  Future<typename ThenTraits<T, F>::value_type> Then(ThreadPool* pool,
+                                                     F fn) const {
+    typedef ThenTraits<T, F> Traits;
+    Promise<typename Traits::value_type> promise;
+    OnReady(pool, [promise, fn](const Future<T>& f) mutable {
+      if (!f.status().ok()) {
+        promise.SetError(f.status());
+        return;
+      }
+      Traits::Run(&fn, f, &promise);
+    });
+    return promise.GetFuture();
+  }
+
+ protected:
+  typedef State<typename Stored<T>::type> StateType;
+
+  FutureBase() {}
+  explicit FutureBase(std::shared_ptr<StateType> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<StateType> state_;
+
+ private:
+  friend class PromiseBase<T>;
+};
+
+}  // namespace future_internal
+
+template <typename T>
+class Promise : public future_internal::PromiseBase<T> {
+ public:
+  Promise() {}
+
+  // Completes the promise; see SetError().
+  void Set(T value) { this->state_->SetValue(std::move(value)); }
+};
+
+template <>
+class Promise<void> : public future_internal::PromiseBase<void> {
+ public:
+  Promise() {}
+
+  void Set() { state_->SetValue(future_internal::Empty()); }
+};
+
+template <typename T>
+class Future : public future_internal::FutureBase<T> {
+ public:
+  // An invalid future; only assignment and valid() may be used.
+  Future() {}
+
+  // REQUIRES: status().ok().  The reference lives as long as the shared
+  // state, i.e. the longest-lived Future or Promise of this result.
+  const T& value() const {
+    CHECK(this->status().ok()) << this->status().ToString();
+    return this->state_->value();
+  }
+  // Copies the value to "*value" if the future succeeded.
+  Status Get(T* value) const {
+    if (!this->status().ok()) return this->status();
+    *value = this->state_->value();
+    return Status::OK;
+  }
+
+ private:
+  friend class future_internal::PromiseBase<T>;
+  explicit Future(
+      std::shared_ptr<typename future_internal::FutureBase<T>::StateType>
+          state)
+      : future_internal::FutureBase<T>(std::move(state)) {}
+};
+
+template <>
+class Future<void> : public future_internal::FutureBase<void> {
+ public:
+  Future() {}
+
+  // Waits for the result.
+  Status Get() const { return status(); }
+
+ private:
+  friend class future_internal::PromiseBase<void>;
+  explicit Future(std::shared_ptr<StateType> state)
+      : future_internal::FutureBase<void>(std::move(state)) {}
+};
+
+inline Future<void> MakeReadyFuture() {
+  Promise<void> promise;
+  promise.Set();
+  return promise.GetFuture();
+}
+
+template <typename T>
+Future<typename std::decay<T>::type> MakeReadyFuture(T&& value) {
+  Promise<typename std::decay<T>::type> promise;
+  promise.Set(std::forward<T>(value));
+  return promise.GetFuture();
+}
+
+template <typename T>
+Future<T> MakeErrorFuture(const Status& status) {
+  Promise<T> promise;
+  promise.SetError(status);
+  return promise.GetFuture();
+}
+
+// The values of all "futures", in order, once all of them succeed.  Fails
+// as soon as any of them fails, with that future's Status.
+template <typename T>
+Future<std::vector<T>> WhenAll(const std::vector<Future<T>>& futures) {
+  struct Context {
+    explicit Context(const std::vector<Future<T>>& futures)
+        : futures(futures), remaining(futures.size()), failed(false) {}
+    const std::vector<Future<T>> futures;
+    std::atomic<size_t> remaining;
+    std::atomic<bool> failed;
+    Promise<std::vector<T>> promise;
+  };
+  std::shared_ptr<Context> context = std::make_shared<Context>(futures);
+  Future<std::vector<T>> result = context->promise.GetFuture();
+  if (futures.empty()) {
+    context->promise.Set(std::vector<T>());
+    return result;
+  }
+  for (const Future<T>& f : futures) {
+    f.OnReady(nullptr, [context](const Future<T>& done) {
+      if (!done.status().ok()) {
+        if (!context->failed.exchange(true)) {
+          context->promise.SetError(done.status());
+        }
+      } else if (context->remaining.fetch_sub(1) == 1 &&
+                 !context->failed.load()) {
+        std::vector<T> values;
+        values.reserve(context->futures.size());
+        for (const Future<T>& g : context->futures) {
+          values.push_back(g.value());
+        }
+        context->promise.Set(std::move(values));
+      }
+    });
+  }
+  return result;
+}
+
+// The index in "futures" of the first one to complete, with a value or
+// an error.  Fails with INVALID_ARGUMENT if "futures" is empty.
+template <typename T>
+Future<size_t> WhenAny(const std::vector<Future<T>>& futures) {
+  if (futures.empty()) {
+    return MakeErrorFuture<size_t>(
+        Status(error::INVALID_ARGUMENT, "WhenAny of no futures"));
+  }
+  struct Context {
+    Context() : done(false) {}
+    std::atomic<bool> done;
+    Promise<size_t> promise;
+  };
+  std::shared_ptr<Context> context = std::make_shared<Context>();
+  Future<size_t> result = context->promise.GetFuture();
+  for (size_t i = 0; i < futures.size(); ++i) {
+    futures[i].OnReady(nullptr, [context, i](const Future<T>&) {
+      if (!context->done.exchange(true)) context->promise.Set(i);
+    });
+  }
+  return result;
+}
+
+}  // namespace thread
+}  // namespace mr
+#endif  // CORE_BASE_FUTURE_H_
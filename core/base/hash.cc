@@ -0,0 +1,174 @@
+#include "core/base/hash.h"
+
+#include <string.h>
+
+#include "core/base/logging.h"
+#include "core/base/macros.h"
+
+namespace mr {
+
+namespace {
+
+typedef unsigned __int128 uint128;
+
+// The secret of wyhash.
+static const uint64_t kSecret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+    0x4d5a2da51de1aa47ULL};
+
+// Seed offset for the high half of Hash128().
+static const uint64_t kHighSeed = 0x9e3779b97f4a7c15ULL;
+
+// Multiplies *a by *b into the low (*a) and high (*b) halves.
+inline void Multiply(uint64_t* a, uint64_t* b) {
+  const uint128 r = static_cast<uint128>(*a) * *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64);
+}
+
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+  Multiply(&a, &b);
+  return a ^ b;
+}
+
+// Little-endian loads, so the hash is the same on every platform.
+inline uint64_t Load64(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+inline uint64_t Load32(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+// Loads 1 to 3 bytes.
+inline uint64_t Load3(const char* p, size_t n) {
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  return (static_cast<uint64_t>(u[0]) << 16) |
+         (static_cast<uint64_t>(u[n >> 1]) << 8) | u[n - 1];
+}
+
+inline uint64_t PrepareSeed(uint64_t seed) {
+  return seed ^ Mix(seed ^ kSecret[0], kSecret[1]);
+}
+
+// Reads up to 16 bytes into two words, with overlapping loads.
+inline void LoadShort(const char* p, size_t n, uint64_t* a, uint64_t* b) {
+  if (PREDICT_TRUE(n >= 4)) {
+    const size_t mid = (n >> 3) << 2;
+    *a = (Load32(p) << 32) | Load32(p + mid);
+    *b = (Load32(p + n - 4) << 32) | Load32(p + n - 4 - mid);
+  } else if (n > 0) {
+    *a = Load3(p, n);
+    *b = 0;
+  } else {
+    *a = *b = 0;
+  }
+}
+
+// Mixes more than 16 bytes into "*seed", leaving the last 16 in a and b.
+inline void LoadLong(const char* p, size_t n, uint64_t* seed, uint64_t* a,
+                     uint64_t* b) {
+  size_t i = n;
+  if (PREDICT_FALSE(i > 48)) {
+    uint64_t seed1 = *seed;
+    uint64_t seed2 = *seed;
+    do {
+      *seed = Mix(Load64(p) ^ kSecret[1], Load64(p + 8) ^ *seed);
+      seed1 = Mix(Load64(p + 16) ^ kSecret[2], Load64(p + 24) ^ seed1);
+      seed2 = Mix(Load64(p + 32) ^ kSecret[3], Load64(p + 40) ^ seed2);
+      p += 48;
+      i -= 48;
+    } while (PREDICT_TRUE(i > 48));
+    *seed ^= seed1 ^ seed2;
+  }
+  while (PREDICT_FALSE(i > 16)) {
+    *seed = Mix(Load64(p) ^ kSecret[1], Load64(p + 8) ^ *seed);
+    p += 16;
+    i -= 16;
+  }
+  *a = Load64(p + i - 16);
+  *b = Load64(p + i - 8);
+}
+
+inline uint64_t Finish(uint64_t a, uint64_t b, uint64_t seed, size_t n) {
+  a ^= kSecret[1];
+  b ^= seed;
+  Multiply(&a, &b);
+  return Mix(a ^ kSecret[0] ^ n, b ^ kSecret[1]);
+}
+
+// Takes PrepareSeed(seed), which batches compute once.
+inline uint64_t HashInline(const char* p, size_t n, uint64_t seed) {
+  uint64_t a, b;
+  if (PREDICT_TRUE(n <= 16)) {
+    LoadShort(p, n, &a, &b);
+  } else {
+    LoadLong(p, n, &seed, &a, &b);
+  }
+  return Finish(a, b, seed, n);
+}
+
+inline uint64_t HashIntInline(uint64_t value, uint64_t seed) {
+  uint64_t a = value ^ kSecret[0];
+  uint64_t b = seed ^ kSecret[1];
+  Multiply(&a, &b);
+  return Mix(a ^ kSecret[0], b ^ kSecret[1]);
+}
+
+}  // namespace
+
+uint64_t Hash64(const char* data, size_t n, uint64_t seed) {
+  return HashInline(data, n, PrepareSeed(seed));
+}
+
+uint64_t HashInt64(uint64_t value, uint64_t seed) {
+  return HashIntInline(value, seed);
+}
+
+uint64_t Hash64Combine(uint64_t hash, uint64_t value) {
+  return Mix(hash ^ kSecret[2], value ^ kSecret[3]);
+}
+
+HashValue128 Hash128(StringPiece s, uint64_t seed) {
+  HashValue128 result;
+  if (s.size() <= 16) {
+    uint64_t a, b;
+    LoadShort(s.data(), s.size(), &a, &b);
+    result.low = Finish(a, b, PrepareSeed(seed), s.size());
+    result.high = Finish(a, b, PrepareSeed(seed ^ kHighSeed), s.size());
+  } else {
+    result.low = HashInline(s.data(), s.size(), PrepareSeed(seed));
+    result.high =
+        HashInline(s.data(), s.size(), PrepareSeed(seed ^ kHighSeed));
+  }
+  return result;
+}
+
+void Hash64Batch(gtl::ArraySlice<StringPiece> keys, uint64_t seed,
+                 gtl::MutableArraySlice<uint64_t> hashes) {
+  CHECK_EQ(keys.size(), hashes.size());
+  seed = PrepareSeed(seed);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    hashes[i] = HashInline(keys[i].data(), keys[i].size(), seed);
+  }
+}
+
+void HashInt64Batch(gtl::ArraySlice<uint64_t> values, uint64_t seed,
+                    gtl::MutableArraySlice<uint64_t> hashes) {
+  CHECK_EQ(values.size(), hashes.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    hashes[i] = HashIntInline(values[i], seed);
+  }
+}
+
+}  // namespace mr
@@ -0,0 +1,84 @@
+// Fast non-cryptographic hashing of byte strings and integers.
+//
+// Hash64() follows the construction of wyhash: short keys take two
+// overlapping loads and one 64x64->128 bit multiply, long keys are mixed
+// 48 bytes at a time in three independent lanes.  It runs at several
+// bytes per cycle and distributes well enough for hash tables,
+// partitioning and bloom filters.  It is not resistant to chosen-input
+// attacks; do not use it where an adversary controls the keys and
+// collisions hurt.
+//
+// The results are part of the on-disk and cross-process contract: map
+// outputs are partitioned with them, so every worker, whatever its
+// platform or build, must get the same values.  They do not depend on
+// byte order or char signedness, and must never change; the golden values
+// in hash_unittest.cc guard this.
+//
+// Example:
+//   const uint64_t h = Hash64(key);
+//   const int shard = ReduceHash(h, num_shards);
+//   std::unordered_map<string, int, Hasher> counts;
+
+#ifndef CORE_BASE_HASH_H_
+#define CORE_BASE_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/base/array_slice.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+
+// Hashes "n" bytes at "data".  Different seeds give independent hash
+// functions.
+uint64_t Hash64(const char* data, size_t n, uint64_t seed);
+
+inline uint64_t Hash64(StringPiece s, uint64_t seed = 0) {
+  return Hash64(s.data(), s.size(), seed);
+}
+
+// Hashes an integer.  Cheaper than, and different from, Hash64() of its
+// bytes.
+uint64_t HashInt64(uint64_t value, uint64_t seed = 0);
+
+// Folds "value", typically another hash, into "hash"; for keys made of
+// several fields.  Not commutative.
+uint64_t Hash64Combine(uint64_t hash, uint64_t value);
+
+struct HashValue128 {
+  uint64_t low;
+  uint64_t high;
+};
+
+// Two independent 64-bit hashes of "s", e.g. for the k probes of a bloom
+// filter by double hashing: low + i * high.  "low" equals Hash64(s, seed).
+// Keys of up to 16 bytes are read once for both halves; longer ones cost
+// two Hash64() calls.
+HashValue128 Hash128(StringPiece s, uint64_t seed = 0);
+
+// Hash64()/HashInt64() of every key, into hashes[i], which must have as
+// many elements as "keys".  Faster than a loop of single calls on short
+// keys: the hash is inlined and independent keys overlap in the pipeline.
+void Hash64Batch(gtl::ArraySlice<StringPiece> keys, uint64_t seed,
+                 gtl::MutableArraySlice<uint64_t> hashes);
+void HashInt64Batch(gtl::ArraySlice<uint64_t> values, uint64_t seed,
+                    gtl::MutableArraySlice<uint64_t> hashes);
+
+// Maps "hash" to [0, n) with a multiply instead of a division.  Uses the
+// high bits of the hash, unlike "hash % n".
+inline int ReduceHash(uint64_t hash, int n) {
+  return static_cast<int>(
+      (static_cast<unsigned __int128>(hash) * static_cast<uint64_t>(n)) >> 64);
+}
+
+// For hash tables keyed by strings, StringPieces or integers:
+//   std::unordered_set<StringPiece, Hasher> seen;
+struct Hasher {
+  size_t operator()(StringPiece s) const { return Hash64(s); }
+  size_t operator()(uint64_t value) const { return HashInt64(value); }
+};
+
+}  // namespace mr
+
+#endif  // CORE_BASE_HASH_H_
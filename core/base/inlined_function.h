@@ -0,0 +1,204 @@
+// An InlinedFunction<R(Args...), N> is like a std::function<R(Args...)>,
+// except that it is move-only and stores callables of up to N bytes
+// inline, without any heap allocation.  std::function (libstdc++) only
+// keeps 16 bytes inline, so a lambda capturing three pointers already
+// costs a malloc; that is too expensive for closures scheduled on a
+// thread pool.  Larger callables, or ones that may throw while being
+// moved, still go to the heap.
+//
+// Being move-only, it can also hold callables that capture move-only
+// state, e.g. a std::unique_ptr.
+
+#ifndef CORE_BASE_INLINED_FUNCTION_H_
+#define CORE_BASE_INLINED_FUNCTION_H_
+
+#include <stddef.h>
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "core/base/logging.h"
+
+namespace mr {
+namespace gtl {
+
+template <typename Signature, size_t N = 48>
+class InlinedFunction;
+
+template <typename R, typename... Args, size_t N>
+class InlinedFunction<R(Args...), N> {
+ public:
+  static const size_t kInlineSize = N;
+
+  InlinedFunction() : ops_(nullptr) {}
+  InlinedFunction(std::nullptr_t) : ops_(nullptr) {}  // NOLINT
+
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, InlinedFunction>::value>::type>
+  InlinedFunction(F&& f) : ops_(nullptr) {  // NOLINT(runtime/explicit)
+    typedef typename std::decay<F>::type Fn;
+    if (IsNull(f)) return;
+    Init<Fn>(std::forward<F>(f),
+             std::integral_constant<bool, FitsInline<Fn>()>());
+  }
+
+  InlinedFunction(InlinedFunction&& other) : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->move(&storage_, &other.storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  InlinedFunction& operator=(InlinedFunction&& other) {
+    if (this != &other) {
+      Clear();
+      if (other.ops_ != nullptr) {
+        other.ops_->move(&storage_, &other.storage_);
+        ops_ = other.ops_;
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  InlinedFunction& operator=(std::nullptr_t) {
+    Clear();
+    return *this;
+  }
+
+  ~InlinedFunction() { Clear(); }
+
+  R operator()(Args... args) const {
+    DCHECK(ops_ != nullptr);
+    return ops_->invoke(const_cast<Storage*>(&storage_),
+                        std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  // True if the callable lives in the inline buffer.
+  bool is_inlined() const { return ops_ != nullptr && ops_->inlined; }
+
+  // True if a callable of type F would be stored inline.
+  template <typename F>
+  static constexpr bool FitsInline() {
+    return sizeof(F) <= N && alignof(F) <= alignof(Storage) &&
+           std::is_nothrow_move_constructible<F>::value;
+  }
+
+ private:
+  typedef typename std::aligned_storage<(N < sizeof(void*) ? sizeof(void*) : N),
+                                        alignof(std::max_align_t)>::type
+      Storage;
+
+  struct Ops {
+    R (*invoke)(Storage* s, Args&&... args);
+    void (*move)(Storage* dst, Storage* src);
+    void (*destroy)(Storage* s);
+    bool inlined;
+  };
+
+  template <typename Fn>
+  struct InlineOps {
+    static Fn* Get(Storage* s) { return reinterpret_cast<Fn*>(s); }
+    static R Invoke(Storage* s, Args&&... args) {
+      return (*Get(s))(std::forward<Args>(args)...);
+    }
+    static void Move(Storage* dst, Storage* src) {
+      new (dst) Fn(std::move(*Get(src)));
+      Get(src)->~Fn();
+    }
+    static void Destroy(Storage* s) { Get(s)->~Fn(); }
+    static const Ops ops;
+  };
+
+  template <typename Fn>
+  struct HeapOps {
+    static Fn*& Get(Storage* s) { return *reinterpret_cast<Fn**>(s); }
+    static R Invoke(Storage* s, Args&&... args) {
+      return (*Get(s))(std::forward<Args>(args)...);
+    }
+    static void Move(Storage* dst, Storage* src) {
+      new (dst) Fn*(Get(src));
+    }
+    static void Destroy(Storage* s) { delete Get(s); }
+    static const Ops ops;
+  };
+
+  // Empty function pointers and std::functions become empty
+  // InlinedFunctions, like they do for std::function.
+  template <typename T>
+  static bool IsNull(T* p) {
+    return p == nullptr;
+  }
+  template <typename Sig>
+  static bool IsNull(const std::function<Sig>& f) {
+    return !f;
+  }
+  template <typename F>
+  static bool IsNull(const F&) {
+    return false;
+  }
+
+  template <typename Fn, typename F>
+  void Init(F&& f, std::true_type /* inlined */) {
+    new (&storage_) Fn(std::forward<F>(f));
+    ops_ = &InlineOps<Fn>::ops;
+  }
+
+  template <typename Fn, typename F>
+  void Init(F&& f, std::false_type /* inlined */) {
+    new (&storage_) Fn*(new Fn(std::forward<F>(f)));
+    ops_ = &HeapOps<Fn>::ops;
+  }
+
+  void Clear() {
+    if (ops_ != nullptr) {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  const Ops* ops_;
+  Storage storage_;
+
+  InlinedFunction(const InlinedFunction&) = delete;
+  void operator=(const InlinedFunction&) = delete;
+};
+
+template <typename R, typename... Args, size_t N>
+template <typename Fn>
+const typename InlinedFunction<R(Args...), N>::Ops
+    InlinedFunction<R(Args...), N>::InlineOps<Fn>::ops = {
+        &InlineOps<Fn>::Invoke, &InlineOps<Fn>::Move, &InlineOps<Fn>::Destroy,
+        true};
+
+template <typename R, typename... Args, size_t N>
+template <typename Fn>
+const typename InlinedFunction<R(Args...), N>::Ops
+    InlinedFunction<R(Args...), N>::HeapOps<Fn>::ops = {
+        &HeapOps<Fn>::Invoke, &HeapOps<Fn>::Move, &HeapOps<Fn>::Destroy,
+        false};
+
+template <typename R, typename... Args, size_t N>
+const size_t InlinedFunction<R(Args...), N>::kInlineSize;
+
+template <typename R, typename... Args, size_t N>
+inline bool operator==(const InlinedFunction<R(Args...), N>& f,
+                       std::nullptr_t) {
+  return !f;
+}
+
+template <typename R, typename... Args, size_t N>
+inline bool operator!=(const InlinedFunction<R(Args...), N>& f,
+                       std::nullptr_t) {
+  return static_cast<bool>(f);
+}
+
+}  // namespace gtl
+}  // namespace mr
+#endif  // CORE_BASE_INLINED_FUNCTION_H_
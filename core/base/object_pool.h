@@ -0,0 +1,160 @@
+// ObjectPool<T> recycles the memory of small, frequently allocated objects
+// (e.g. the per-closure task records of a thread pool) so that steady-state
+// New/Delete pairs never reach malloc.
+//
+// Objects are grouped by size class.  Each thread keeps a small cache of
+// free slots and only takes a mutex to trade a batch of them with the
+// shared free list, which is what makes the pool cheap when objects are
+// allocated on one thread and freed on another.  Memory is never given
+// back to the system.
+
+#ifndef CORE_BASE_OBJECT_POOL_H_
+#define CORE_BASE_OBJECT_POOL_H_
+
+#include <stddef.h>
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "core/base/logging.h"
+#include "core/base/macros.h"
+#include "core/base/mem.h"
+
+namespace mr {
+
+// Fixed-size slots of kSize bytes, aligned for any scalar type.
+template <size_t kSize>
+class SizeClassPool {
+ public:
+  static void* Allocate() {
+    ThreadCache* tc = GetThreadCache();
+    if (PREDICT_FALSE(tc->head == nullptr)) tc->Refill();
+    FreeSlot* slot = tc->head;
+    tc->head = slot->next;
+    --tc->count;
+    return slot;
+  }
+
+  static void Deallocate(void* p) {
+    ThreadCache* tc = GetThreadCache();
+    FreeSlot* slot = static_cast<FreeSlot*>(p);
+    slot->next = tc->head;
+    tc->head = slot;
+    if (PREDICT_FALSE(++tc->count > 2 * kBatchSize)) tc->Release(kBatchSize);
+  }
+
+ private:
+  static const size_t kAlignment = alignof(std::max_align_t);
+  static const size_t kSlotSize =
+      ((kSize < sizeof(void*) ? sizeof(void*) : kSize) + kAlignment - 1) &
+      ~(kAlignment - 1);
+  // Slots moved between a thread cache and the central list at a time.
+  static const size_t kBatchSize = 32;
+  // Slots carved out of one malloc'ed slab.
+  static const size_t kSlabSlots = 128;
+
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  // Shared free list.  Leaked so that threads exiting during static
+  // destruction can still return their slots.
+  struct Central {
+    std::mutex mu;
+    FreeSlot* head = nullptr;
+    size_t count = 0;
+  };
+
+  static Central* GetCentral() {
+    static Central* central = new Central;
+    return central;
+  }
+
+  struct ThreadCache {
+    FreeSlot* head = nullptr;
+    size_t count = 0;
+
+    ~ThreadCache() { Release(count); }
+
+    void Refill() {
+      Central* c = GetCentral();
+      {
+        std::lock_guard<std::mutex> l(c->mu);
+        while (c->head != nullptr && count < kBatchSize) {
+          FreeSlot* slot = c->head;
+          c->head = slot->next;
+          --c->count;
+          slot->next = head;
+          head = slot;
+          ++count;
+        }
+      }
+      if (head != nullptr) return;
+      char* slab = static_cast<char*>(
+          aligned_malloc(kSlotSize * kSlabSlots, static_cast<int>(kAlignment)));
+      CHECK(slab != nullptr);
+      for (size_t i = 0; i < kSlabSlots; ++i) {
+        FreeSlot* slot = reinterpret_cast<FreeSlot*>(slab + i * kSlotSize);
+        slot->next = head;
+        head = slot;
+      }
+      count += kSlabSlots;
+      // Keep one batch; the rest of the slab goes to the central list.
+      Release(kSlabSlots - kBatchSize);
+    }
+
+    void Release(size_t n) {
+      if (n == 0) return;
+      FreeSlot* first = head;
+      FreeSlot* last = head;
+      for (size_t i = 1; i < n; ++i) last = last->next;
+      head = last->next;
+      count -= n;
+      Central* c = GetCentral();
+      std::lock_guard<std::mutex> l(c->mu);
+      last->next = c->head;
+      c->head = first;
+      c->count += n;
+    }
+  };
+
+  static ThreadCache* GetThreadCache() {
+    static thread_local ThreadCache cache;
+    return &cache;
+  }
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(SizeClassPool);
+};
+
+template <typename T>
+class ObjectPool {
+ public:
+  template <typename... Args>
+  static T* New(Args&&... args) {
+    return new (Pool::Allocate()) T(std::forward<Args>(args)...);
+  }
+
+  static void Delete(T* t) {
+    if (t == nullptr) return;
+    t->~T();
+    Pool::Deallocate(t);
+  }
+
+  // Deleter for std::unique_ptr<T, ObjectPool<T>::Deleter>.
+  struct Deleter {
+    void operator()(T* t) const { ObjectPool<T>::Delete(t); }
+  };
+
+ private:
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "ObjectPool does not support over-aligned types");
+  // Round up to 16 bytes so that types of similar size share a pool.
+  typedef SizeClassPool<(sizeof(T) + 15) & ~static_cast<size_t>(15)> Pool;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ObjectPool);
+};
+
+}  // namespace mr
+#endif  // CORE_BASE_OBJECT_POOL_H_
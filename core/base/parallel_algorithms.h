@@ -0,0 +1,245 @@
+// Parallel sort, reduce, scan and transform over array slices, run on a
+// thread::ThreadPool.
+//
+// Each call splits its input into contiguous blocks of at least
+// kMinBlockSize elements, at most a few per thread, and returns once all
+// of them are done.  Inputs smaller than one block, or pools with a
+// single thread, are processed inline on the calling thread.
+//
+// Example:
+//   std::vector<uint64_t> keys = ...;
+//   ParallelSort(pool, gtl::MutableArraySlice<uint64_t>(&keys));
+//   uint64_t total = ParallelReduce(pool, gtl::ArraySlice<uint64_t>(keys),
+//                                   uint64_t{0}, std::plus<uint64_t>());
+
+#ifndef CORE_BASE_PARALLEL_ALGORITHMS_H_
+#define CORE_BASE_PARALLEL_ALGORITHMS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "core/base/array_slice.h"
+#include "core/base/logging.h"
+#include "core/base/threadpool.h"
+
+namespace mr {
+namespace thread {
+
+namespace parallel_internal {
+
+// Smallest block handed to a thread.
+static const size_t kMinBlockSize = 1 << 12;
+// Blocks per thread; more than one evens out blocks that run slower.
+static const int kBlocksPerThread = 4;
+// Samples taken per bucket when picking sample sort splitters.
+static const size_t kOversampling = 32;
+
+inline size_t NumBlocks(const ThreadPool* pool, size_t n) {
+  const size_t max_blocks =
+      static_cast<size_t>(pool->NumThreads()) * kBlocksPerThread;
+  return std::max<size_t>(1, std::min(max_blocks, n / kMinBlockSize));
+}
+
+// Calls fn(i) for every i in [0, count), each as a separate unit of work.
+inline void ForEachIndex(ThreadPool* pool, size_t count,
+                         const std::function<void(size_t)>& fn) {
+  if (count == 1) {
+    fn(0);
+    return;
+  }
+  // A cost this high makes ParallelFor hand out one index at a time.
+  const int64_t kCostPerIndex = 1 << 20;
+  pool->ParallelFor(count, kCostPerIndex, [&fn](int64_t first, int64_t last) {
+    for (int64_t i = first; i < last; ++i) fn(i);
+  });
+}
+
+// Cuts [0, n) into "num_blocks" contiguous blocks of nearly equal size
+// and calls fn(b, first, last) for each.
+inline void ForEachBlock(
+    ThreadPool* pool, size_t n, size_t num_blocks,
+    const std::function<void(size_t, size_t, size_t)>& fn) {
+  ForEachIndex(pool, num_blocks, [n, num_blocks, &fn](size_t b) {
+    const size_t size = n / num_blocks;
+    const size_t rest = n % num_blocks;
+    const size_t first = size * b + std::min(b, rest);
+    fn(b, first, first + size + (b < rest ? 1 : 0));
+  });
+}
+
+}  // namespace parallel_internal
+
+// out[i] = fn(in[i]) for every i.  "in" and "out" have the same size and
+// may be the same array.
+template <typename T, typename U, typename F>
+void ParallelTransform(ThreadPool* pool, gtl::ArraySlice<T> in,
+                       gtl::MutableArraySlice<U> out, F fn) {
+  CHECK_EQ(in.size(), out.size());
+  const size_t n = in.size();
+  const size_t num_blocks = parallel_internal::NumBlocks(pool, n);
+  parallel_internal::ForEachBlock(
+      pool, n, num_blocks, [&](size_t b, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      out[i] = fn(in[i]);
+    }
+  });
+}
+
+// Folds "in" with the associative "op", starting from "identity", which
+// must satisfy op(identity, x) == x.  The grouping of the operations is
+// unspecified, so "op" need not be commutative but must be associative.
+template <typename T, typename R, typename Op>
+R ParallelReduce(ThreadPool* pool, gtl::ArraySlice<T> in, R identity,
+                 Op op) {
+  const size_t n = in.size();
+  const size_t num_blocks = parallel_internal::NumBlocks(pool, n);
+  std::vector<R> partial(num_blocks, identity);
+  parallel_internal::ForEachBlock(
+      pool, n, num_blocks, [&](size_t b, size_t first, size_t last) {
+    R acc = identity;
+    for (size_t i = first; i < last; ++i) {
+      acc = op(std::move(acc), in[i]);
+    }
+    partial[b] = std::move(acc);
+  });
+  R result = identity;
+  for (R& r : partial) result = op(std::move(result), std::move(r));
+  return result;
+}
+
+// Inclusive prefix fold: out[i] = op(in[0], ..., in[i]), with the same
+// requirements on "op" and "identity" as ParallelReduce.  "in" and "out"
+// have the same size and may be the same array.  Reads every element
+// twice: once to total each block, once to scan it from its offset.
+template <typename T, typename Op>
+void ParallelScan(ThreadPool* pool, gtl::ArraySlice<T> in,
+                  gtl::MutableArraySlice<T> out, T identity, Op op) {
+  CHECK_EQ(in.size(), out.size());
+  const size_t n = in.size();
+  const size_t num_blocks = parallel_internal::NumBlocks(pool, n);
+  // offset[b] is the fold of every block before b.
+  std::vector<T> offset(num_blocks, identity);
+  if (num_blocks > 1) {
+    std::vector<T> total(num_blocks, identity);
+    parallel_internal::ForEachBlock(
+        pool, n, num_blocks, [&](size_t b, size_t first, size_t last) {
+      if (b + 1 == num_blocks) return;  // No block comes after it.
+      T acc = identity;
+      for (size_t i = first; i < last; ++i) {
+        acc = op(std::move(acc), in[i]);
+      }
+      total[b] = std::move(acc);
+    });
+    for (size_t b = 1; b < num_blocks; ++b) {
+      offset[b] = op(offset[b - 1], total[b - 1]);
+    }
+  }
+  parallel_internal::ForEachBlock(
+      pool, n, num_blocks, [&](size_t b, size_t first, size_t last) {
+    T acc = offset[b];
+    for (size_t i = first; i < last; ++i) {
+      acc = op(std::move(acc), in[i]);
+      out[i] = acc;
+    }
+  });
+}
+
+// Sorts "data" by "less", not stably, with a parallel sample sort:
+//  1. a sorted sample of the input picks splitters between buckets;
+//  2. every block finds the bucket of each of its elements and counts
+//     them, and the counts give each (bucket, block) pair its range;
+//  3. blocks move their elements into those ranges of a scratch array,
+//     so each bucket is contiguous, in block order;
+//  4. buckets are sorted independently and moved back.
+// Uses scratch space of one T and one uint32_t per element; T must be
+// default-constructible and movable.  Runs of equal keys land in one
+// bucket, so heavily duplicated inputs parallelize less.
+template <typename T, typename Compare>
+void ParallelSort(ThreadPool* pool, gtl::MutableArraySlice<T> data,
+                  Compare less) {
+  const size_t n = data.size();
+  const size_t num_blocks = parallel_internal::NumBlocks(pool, n);
+  if (num_blocks == 1) {
+    std::sort(data.begin(), data.end(), less);
+    return;
+  }
+  const size_t num_buckets = num_blocks;
+
+  // 1. Splitters: every kOversampling-th element of an evenly strided,
+  // sorted sample.
+  std::vector<T> sample;
+  const size_t sample_size = num_buckets * parallel_internal::kOversampling;
+  sample.reserve(sample_size);
+  for (size_t i = 0; i < sample_size; ++i) {
+    sample.push_back(data[i * (n / sample_size) + (n / sample_size) / 2]);
+  }
+  std::sort(sample.begin(), sample.end(), less);
+  std::vector<T> splitters;
+  splitters.reserve(num_buckets - 1);
+  for (size_t i = 1; i < num_buckets; ++i) {
+    splitters.push_back(sample[i * parallel_internal::kOversampling]);
+  }
+  sample.clear();
+
+  // 2. Bucket of every element, and counts[block * num_buckets + bucket].
+  std::vector<uint32_t> bucket_of(n);
+  std::vector<size_t> counts(num_blocks * num_buckets, 0);
+  parallel_internal::ForEachBlock(
+      pool, n, num_blocks, [&](size_t b, size_t first, size_t last) {
+    size_t* count = &counts[b * num_buckets];
+    for (size_t i = first; i < last; ++i) {
+      const uint32_t bucket = static_cast<uint32_t>(
+          std::upper_bound(splitters.begin(), splitters.end(), data[i],
+                           less) -
+          splitters.begin());
+      bucket_of[i] = bucket;
+      ++count[bucket];
+    }
+  });
+
+  // Turn counts into start offsets, bucket-major, block-minor.
+  std::vector<size_t> bucket_begin(num_buckets + 1, 0);
+  size_t offset = 0;
+  for (size_t k = 0; k < num_buckets; ++k) {
+    bucket_begin[k] = offset;
+    for (size_t b = 0; b < num_blocks; ++b) {
+      const size_t c = counts[b * num_buckets + k];
+      counts[b * num_buckets + k] = offset;
+      offset += c;
+    }
+  }
+  bucket_begin[num_buckets] = offset;
+  DCHECK_EQ(n, offset);
+
+  // 3. Scatter.
+  std::vector<T> scratch(n);
+  parallel_internal::ForEachBlock(
+      pool, n, num_blocks, [&](size_t b, size_t first, size_t last) {
+    size_t* next = &counts[b * num_buckets];
+    for (size_t i = first; i < last; ++i) {
+      scratch[next[bucket_of[i]]++] = std::move(data[i]);
+    }
+  });
+
+  // 4. Sort buckets and move them back.
+  parallel_internal::ForEachIndex(pool, num_buckets, [&](size_t k) {
+    const auto first = scratch.begin() + bucket_begin[k];
+    const auto last = scratch.begin() + bucket_begin[k + 1];
+    std::sort(first, last, less);
+    std::move(first, last, data.begin() + bucket_begin[k]);
+  });
+}
+
+template <typename T>
+void ParallelSort(ThreadPool* pool, gtl::MutableArraySlice<T> data) {
+  ParallelSort(pool, data, std::less<T>());
+}
+
+}  // namespace thread
+}  // namespace mr
+#endif  // CORE_BASE_PARALLEL_ALGORITHMS_H_
@@ -0,0 +1,256 @@
+// Coroutine tasks that run on a ThreadPool (C++20).
+//
+// A Task<T> is a lazily started coroutine producing a T.  Inside one,
+//   co_await other_task     runs another Task and yields its value,
+//   co_await future         suspends until a Future<T> is ready and
+//                           yields it (check its status()),
+//   co_await ResumeOn(pool) moves the rest of the coroutine to "pool".
+// A suspended coroutine holds no thread, and its state lives in one heap
+// frame rather than on a stack of its own, so a handler with many
+// sequential asynchronous steps reads like straight-line code:
+//
+//   Task<Status> HandleRequest(ThreadPool* pool, Request request) {
+//     co_await ResumeOn(pool);
+//     Future<string> data = co_await ReadAsync(request.fname());
+//     CO_RETURN_IF_ERROR(data.status());
+//     Future<Status> sent = co_await SendAsync(Process(data.value()));
+//     co_return sent.status();
+//   }
+//
+//   Future<Status> done = Start(pool, HandleRequest(pool, request));
+//
+// Take coroutine parameters by value, never by reference: a Task only
+// starts later, after the caller's arguments may be gone, and references
+// in its frame would dangle.  Pointers must outlive the Task.
+//
+// Anything that completes a Promise (a callback from an RPC or file
+// read) is awaitable through its Future.  The header is empty unless the
+// compiler supports coroutines (-std=c++20); the rest of the tree keeps
+// building as C++11.
+
+#ifndef CORE_BASE_TASK_H_
+#define CORE_BASE_TASK_H_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define MR_HAVE_COROUTINES 1
+
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+#include "core/base/future.h"
+#include "core/base/logging.h"
+#include "core/base/macros.h"
+#include "core/base/manual_constructor.h"
+#include "core/base/status.h"
+#include "core/base/threadpool.h"
+
+// RETURN_IF_ERROR for coroutines returning Task<Status>.
+#define CO_RETURN_IF_ERROR(expr)           \
+  do {                                     \
+    const ::mr::Status _status = (expr);   \
+    if (!_status.ok()) co_return _status;  \
+  } while (0)
+
+namespace mr {
+namespace thread {
+
+template <typename T = void>
+class Task;
+
+namespace task_internal {
+
+struct PromiseBase {
+  // Tasks start when first awaited (or passed to Start()).
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  // When the task finishes, the coroutine awaiting it resumes on the same
+  // thread, without growing the stack.
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<P> handle) noexcept {
+      std::coroutine_handle<> next = handle.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { LOG(FATAL) << "Exception escaped a Task"; }
+
+  std::coroutine_handle<> continuation;
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+  Promise() : has_value(false) {}
+  ~Promise() {
+    if (has_value) value.Destroy();
+  }
+
+  Task<T> get_return_object();
+
+  template <typename U>
+  void return_value(U&& v) {
+    value.Init(std::forward<U>(v));
+    has_value = true;
+  }
+
+  ManualConstructor<T> value;
+  bool has_value;
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+  Task<void> get_return_object();
+  void return_void() {}
+};
+
+// The coroutine behind Start() and Spawn(); it destroys itself when done.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return Detached(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { LOG(FATAL) << "Exception escaped a Task"; }
+  };
+};
+
+}  // namespace task_internal
+
+template <typename T>
+class Task {
+ public:
+  typedef task_internal::Promise<T> promise_type;
+  typedef std::coroutine_handle<promise_type> Handle;
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  // Awaiting a task runs it on the awaiting thread until it first
+  // suspends; the awaiter resumes once the task finishes.
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  T await_resume() {
+    DCHECK(handle_.done());
+    if constexpr (!std::is_void<T>::value) {
+      return std::move(*handle_.promise().value);
+    }
+  }
+
+ private:
+  friend struct task_internal::Promise<T>;
+  explicit Task(Handle handle) : handle_(handle) {}
+
+  Handle handle_;
+
+  Task(const Task&) = delete;
+  void operator=(const Task&) = delete;
+};
+
+namespace task_internal {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+}  // namespace task_internal
+
+// co_await ResumeOn(pool) continues the coroutine on a worker of "pool".
+class ResumeOn {
+ public:
+  explicit ResumeOn(ThreadPool* pool) : pool_(pool) {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    pool_->Schedule([handle]() { handle.resume(); });
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  ThreadPool* const pool_;
+};
+
+// co_await future suspends until "future" is ready and yields it.  The
+// coroutine resumes on the thread that completed the promise; await
+// ResumeOn() afterwards to move back to a pool.
+template <typename T>
+class FutureAwaiter {
+ public:
+  explicit FutureAwaiter(Future<T> future) : future_(std::move(future)) {}
+
+  bool await_ready() const { return future_.ready(); }
+  void await_suspend(std::coroutine_handle<> handle) {
+    future_.OnReady(nullptr, [handle](const Future<T>&) { handle.resume(); });
+  }
+  Future<T> await_resume() { return std::move(future_); }
+
+ private:
+  Future<T> future_;
+};
+
+template <typename T>
+FutureAwaiter<T> operator co_await(Future<T> future) {
+  return FutureAwaiter<T>(std::move(future));
+}
+
+// Runs "task" on "pool" and returns the future of its result.
+template <typename T>
+Future<T> Start(ThreadPool* pool, Task<T> task) {
+  Promise<T> promise;
+  Future<T> future = promise.GetFuture();
+  [](ThreadPool* pool, Task<T> task,
+     Promise<T> promise) -> task_internal::Detached {
+    co_await ResumeOn(pool);
+    promise.Set(co_await std::move(task));
+  }(pool, std::move(task), promise);
+  return future;
+}
+
+// Runs "task" on "pool"; the future becomes ready when it finishes.
+inline Future<void> Start(ThreadPool* pool, Task<void> task) {
+  Promise<void> promise;
+  Future<void> future = promise.GetFuture();
+  [](ThreadPool* pool, Task<void> task,
+     Promise<void> promise) -> task_internal::Detached {
+    co_await ResumeOn(pool);
+    co_await std::move(task);
+    promise.Set();
+  }(pool, std::move(task), promise);
+  return future;
+}
+
+// Runs "task" on "pool" without waiting for it.
+inline void Spawn(ThreadPool* pool, Task<void> task) {
+  [](ThreadPool* pool, Task<void> task) -> task_internal::Detached {
+    co_await ResumeOn(pool);
+    co_await std::move(task);
+  }(pool, std::move(task));
+}
+
+}  // namespace thread
+}  // namespace mr
+
+#endif  // __cpp_impl_coroutine
+#endif  // CORE_BASE_TASK_H_
@@ -1,7 +1,10 @@
 #ifndef CORE_BASE_THREAD_COST_MODEL_H_
 #define CORE_BASE_THREAD_COST_MODEL_H_
 
+#include <stdint.h>
+
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 
 namespace eigen {
@@ -75,5 +78,54 @@ class CostModel {
   }        
 };
 
+// Learns the cost per unit of one ParallelFor call site from the time its
+// earlier invocations took, instead of relying on a guess from the caller.
+// Keep one per call site (e.g. a function-level static) and pass it to
+// every invocation; it is safe to share between threads.
+//
+// Costs are in the cycles CostModel works with.  Measured time is turned
+// into cycles at a nominal kCyclesPerNanosecond, which only needs to be
+// close: CostModel's constants are approximations of the same order.
+class CostEstimator {
+ public:
+  static constexpr double kCyclesPerNanosecond = 3.0;
+  // Weight of a new measurement in the running estimate.
+  static constexpr double kSmoothing = 0.25;
+
+  // "initial_cycles_per_unit" is used until the first measurement.
+  explicit CostEstimator(double initial_cycles_per_unit = 1000)
+    : cycles_per_unit_(initial_cycles_per_unit), samples_(0) {}
+
+  OpCost cost() const {
+    return OpCost(0, 0, cycles_per_unit_.load(std::memory_order_relaxed));
+  }
+
+  // Number of invocations measured so far.
+  uint64_t samples() const {
+    return samples_.load(std::memory_order_relaxed);
+  }
+
+  // Records that "units" units took "nanos" of thread time in total.  The
+  // first measurement replaces the initial guess; later ones are blended
+  // in with weight kSmoothing.
+  void Update(double units, double nanos) {
+    if (units <= 0) return;
+    const double measured =
+        std::max(1.0, nanos * kCyclesPerNanosecond / units);
+    const bool first = samples_.fetch_add(1, std::memory_order_relaxed) == 0;
+    double current = cycles_per_unit_.load(std::memory_order_relaxed);
+    double next;
+    do {
+      next = first ? measured
+                   : current + kSmoothing * (measured - current);
+    } while (!cycles_per_unit_.compare_exchange_weak(
+        current, next, std::memory_order_relaxed));
+  }
+
+ private:
+  std::atomic<double> cycles_per_unit_;
+  std::atomic<uint64_t> samples_;
+};
+
 } // namespace eigen
 #endif // CORE_BASE_THREAD_COST_MODEL_H_
@@ -6,6 +6,7 @@
 #include "core/base/thread/cost_model.h"
 
 #include <algorithm>
+#include <atomic>
 
 namespace eigen {
 
@@ -56,6 +57,11 @@ class Barrier {
     cv_.notify_all();
   }
 
+  // Whether every Notify() has happened; never blocks.
+  bool Done() const {
+    return (state_.load(std::memory_order_acquire) >> 1) == 0;
+  }
+
   void Wait() {
     unsigned int v = state_.fetch_or(1, std::memory_order_acq_rel);
     if ((v >> 1) == 0) return;
@@ -104,6 +110,24 @@ static inline void wait_until_ready(SyncType* n) {
   } 
 } 
 
+// Waits for "sync" to be notified.  If the caller is a worker of "pool",
+// it runs the pool's queued tasks in the meantime instead of blocking.
+// A worker that blocks while the tasks it waits for sit in its own queue
+// depends on other workers to run them, and nested ParallelFor calls
+// from every worker at once would deadlock.  The caller blocks only once
+// the pool has no queued task left, when everything "sync" waits for is
+// already running on other threads.
+//
+// A task run this way runs on the stack of the waiting one, so state
+// keyed by CurrentThreadId() may be entered again before it is released.
+template <typename SyncType>
+static inline void WaitAndHelp(SyncType* sync, ThreadPoolInterface* pool) {
+  while (!sync->Done()) {
+    if (!pool->TryRunPendingTask()) break;
+  }
+  sync->Wait();
+}
+
 //////////////
 class ThreadPoolDevice {
  public:
@@ -192,20 +216,44 @@ class ThreadPoolDevice {
         } 
       } 
     } 
-    Barrier barrier(static_cast<unsigned int>(block_count));
-    std::function<void(Index, Index)> handleRange;
-    handleRange = [=, &handleRange, &barrier, &f](Index first, Index last) {
-      if (last - first <= block_size) {
-        f(first, last);
-        barrier.Notify();
-        return;
+    // Blocks are claimed from one shared counter by the calling thread
+    // and by up to NumThreads() - 1 helpers.  Each helper is a single
+    // closure capturing one pointer, so scheduling allocates nothing, and
+    // a helper that starts after all blocks are claimed just returns.
+    const int num_helpers =
+        static_cast<int>(std::min<Index>(block_count, NumThreads())) - 1;
+    struct Shared {
+      Shared(Index n, Index block_size, Index block_count, int num_helpers,
+             const std::function<void(Index, Index)>* f)
+        : n(n), block_size(block_size), block_count(block_count), f(f),
+          next(0), barrier(static_cast<unsigned int>(num_helpers)) {}
+
+      void RunBlocks() {
+        for (;;) {
+          const Index block = next.fetch_add(1, std::memory_order_relaxed);
+          if (block >= block_count) return;
+          const Index first = block * block_size;
+          (*f)(first, std::min(n, first + block_size));
+        }
       }
-      Index mid = first + divup((last - first) / 2, block_size) * block_size;
-      pool_->Schedule([=, &handleRange]() { handleRange(mid, last); });
-      pool_->Schedule([=, &handleRange]() { handleRange(first, mid); });
+
+      const Index n;
+      const Index block_size;
+      const Index block_count;
+      const std::function<void(Index, Index)>* const f;
+      std::atomic<Index> next;
+      Barrier barrier;  // Counts helpers, not blocks.
     };
-    handleRange(0, n);
-    barrier.Wait();
+    Shared shared(n, block_size, block_count, num_helpers, &f);
+    Shared* const s = &shared;
+    for (int i = 0; i < num_helpers; ++i) {
+      pool_->Schedule([s]() {
+        s->RunBlocks();
+        s->barrier.Notify();
+      });
+    }
+    shared.RunBlocks();
+    WaitAndHelp(&shared.barrier, pool_);
   }
 
   void ParallelFor(Index n, const OpCost& cost,
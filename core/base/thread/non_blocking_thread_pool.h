@@ -5,6 +5,9 @@
 #include "core/base/thread/event_count.h"
 #include "core/base/thread/run_queue.h"
 #include "core/base/thread/max_size_vector.h"
+#include "core/base/thread/thread_pool_stats.h"
+
+#include <chrono>
 
 namespace eigen {
 
@@ -20,11 +23,13 @@ class NonBlockingThreadPoolTempl : public ThreadPoolInterface {
           queues_(num_threads),
           coprimes_(num_threads),
           waiters_(num_threads),
+          counters_(num_threads),
           blocked_(0),
           spinning_(0),
           done_(false),
           ec_(waiters_) {
       waiters_.resize(num_threads);
+      counters_.resize(num_threads);
   
       for (int i = 1; i <= num_threads; i++) {
         unsigned a = i; 
@@ -56,8 +61,14 @@ class NonBlockingThreadPoolTempl : public ThreadPoolInterface {
       for (size_t i = 0; i < threads_.size(); i++) delete queues_[i];
     } 
     
-void Schedule(std::function<void()> fn) {
-      Task t = env_.CreateTask(std::move(fn));
+    void Schedule(std::function<void()> fn) {
+      ScheduleTask(env_.CreateTask(std::move(fn)));
+    }
+
+    // Enqueues a task made by the environment.  Lets an environment whose
+    // CreateTask() takes something cheaper than a std::function skip
+    // building one.
+    void ScheduleTask(Task t) {
       PerThread* pt = GetPerThread();
       if (pt->pool == this) {
         Queue* q = queues_[pt->thread_id];
@@ -85,10 +96,83 @@ if (pt->pool == this) {
         return -1; 
       } 
     } 
-        
+
+    bool TryRunPendingTask() final {
+      PerThread* pt = GetPerThread();
+      if (pt->pool != this) return false;
+      WorkerCounters* c = &counters_[pt->thread_id];
+      Task t = queues_[pt->thread_id]->PopFront();
+      while (!t.f) {
+        t = Steal(c);
+        // PopBack() gives up on a contended queue, so only stop once
+        // every queue looks empty.
+        if (!t.f && NonEmptyQueueIndex() == -1) return false;
+      }
+      env_.ExecuteTask(t);
+      WorkerCounters::Add(&c->tasks_executed, 1);
+      return true;
+    }
+
+    // Aggregates the per-worker counters.  Cheap enough to call while
+    // the pool is busy; counters of different workers are not read at
+    // exactly the same instant.
+    void GetStats(ThreadPoolStats* stats) const {
+      stats->workers.resize(counters_.size());
+      stats->total = ThreadPoolStats::Worker();
+      for (size_t i = 0; i < counters_.size(); ++i) {
+        counters_[i].Read(&stats->workers[i]);
+        stats->total.Add(stats->workers[i]);
+      }
+    }
+
+ protected:
+  Environment& env() { return env_; }
+
  private:
   typedef typename Environment::EnvThread Thread;
   
+  // Counters of one worker.  Only that worker writes them, so updates are
+  // plain relaxed load/store pairs rather than read-modify-writes; the
+  // padding keeps workers from sharing cache lines.
+  struct WorkerCounters {
+    std::atomic<uint64_t> tasks_executed;
+    std::atomic<uint64_t> steals_attempted;
+    std::atomic<uint64_t> steals_succeeded;
+    std::atomic<uint64_t> spin_iterations;
+    std::atomic<uint64_t> blocks;
+    std::atomic<uint64_t> blocked_nanos;
+    std::atomic<uint64_t> queue_size_samples;
+    std::atomic<uint64_t> queue_size_sum;
+    std::atomic<uint64_t> queue_size_max;
+    char pad[128 - 9 * sizeof(std::atomic<uint64_t>)];
+
+    WorkerCounters()
+        : tasks_executed(0), steals_attempted(0), steals_succeeded(0),
+          spin_iterations(0), blocks(0), blocked_nanos(0),
+          queue_size_samples(0), queue_size_sum(0), queue_size_max(0) {}
+
+    static void Add(std::atomic<uint64_t>* counter, uint64_t n) {
+      counter->store(counter->load(std::memory_order_relaxed) + n,
+                     std::memory_order_relaxed);
+    }
+
+    void Read(ThreadPoolStats::Worker* w) const {
+      w->tasks_executed = tasks_executed.load(std::memory_order_relaxed);
+      w->steals_attempted = steals_attempted.load(std::memory_order_relaxed);
+      w->steals_succeeded = steals_succeeded.load(std::memory_order_relaxed);
+      w->spin_iterations = spin_iterations.load(std::memory_order_relaxed);
+      w->blocks = blocks.load(std::memory_order_relaxed);
+      w->blocked_nanos = blocked_nanos.load(std::memory_order_relaxed);
+      w->queue_size_samples =
+          queue_size_samples.load(std::memory_order_relaxed);
+      w->queue_size_sum = queue_size_sum.load(std::memory_order_relaxed);
+      w->queue_size_max = queue_size_max.load(std::memory_order_relaxed);
+    }
+  };
+
+  // A worker samples its queue size once every this many tasks.
+  static const uint64_t kQueueSampleInterval = 64;
+
   struct PerThread {
     constexpr PerThread() : pool(NULL), rand(0), thread_id(-1) { }
     NonBlockingThreadPoolTempl* pool;  // Parent pool, or null for normal threads.
@@ -101,6 +185,7 @@ if (pt->pool == this) {
   MaxSizeVector<Queue*> queues_;
   MaxSizeVector<unsigned> coprimes_;
   MaxSizeVector<EventCount::Waiter> waiters_;
+  MaxSizeVector<WorkerCounters> counters_;
   std::atomic<unsigned> blocked_;
   std::atomic<bool> spinning_;
   std::atomic<bool> done_;
@@ -113,19 +198,22 @@ if (pt->pool == this) {
       pt->thread_id = thread_id;
       Queue* q = queues_[thread_id];
       EventCount::Waiter* waiter = &waiters_[thread_id];
+      WorkerCounters* c = &counters_[thread_id];
       for (;;) {
         Task t = q->PopFront();
         if (!t.f) {
-          t = Steal();
+          t = Steal(c);
           if (!t.f) {
             if (!spinning_ && !spinning_.exchange(true)) {
-              for (int i = 0; i < 1000 && !t.f; i++) {
-                t = Steal();
+              int i = 0;
+              for (; i < 1000 && !t.f; i++) {
+                t = Steal(c);
               } 
+              WorkerCounters::Add(&c->spin_iterations, i);
               spinning_ = false;
             } 
             if (!t.f) {
-              if (!WaitForWork(waiter, &t)) {
+              if (!WaitForWork(waiter, c, &t)) {
                 return;
               } 
             } 
@@ -133,11 +221,26 @@ if (pt->pool == this) {
         } 
         if (t.f) {
           env_.ExecuteTask(t);
+          WorkerCounters::Add(&c->tasks_executed, 1);
+          if (c->tasks_executed.load(std::memory_order_relaxed) %
+                  kQueueSampleInterval == 0) {
+            SampleQueueSize(c, q);
+          }
         } 
       } 
   } 
 
-      Task Steal() {
+    void SampleQueueSize(WorkerCounters* c, Queue* q) {
+      const uint64_t size = q->Size();
+      WorkerCounters::Add(&c->queue_size_samples, 1);
+      WorkerCounters::Add(&c->queue_size_sum, size);
+      if (size > c->queue_size_max.load(std::memory_order_relaxed)) {
+        c->queue_size_max.store(size, std::memory_order_relaxed);
+      }
+    }
+
+      Task Steal(WorkerCounters* c) {
+      WorkerCounters::Add(&c->steals_attempted, 1);
       PerThread* pt = GetPerThread();
       const size_t size = queues_.size();
       unsigned r = Rand(&pt->rand);
@@ -146,6 +249,7 @@ if (pt->pool == this) {
       for (unsigned i = 0; i < size; i++) {
         Task t = queues_[victim]->PopBack();
         if (t.f) {
+          WorkerCounters::Add(&c->steals_succeeded, 1);
           return t;
         } 
         victim += inc;
@@ -156,13 +260,16 @@ if (pt->pool == this) {
       return Task();
     }
 
-    bool WaitForWork(EventCount::Waiter* waiter, Task* t) {
+    bool WaitForWork(EventCount::Waiter* waiter, WorkerCounters* c,
+                     Task* t) {
       DCHECK(!t->f);
       ec_.Prewait(waiter);
       int victim = NonEmptyQueueIndex();
       if (victim != -1) {
         ec_.CancelWait(waiter);
         *t = queues_[victim]->PopBack();
+        WorkerCounters::Add(&c->steals_attempted, 1);
+        if (t->f) WorkerCounters::Add(&c->steals_succeeded, 1);
         return true;
       } 
       blocked_++;
@@ -175,7 +282,13 @@ if (pt->pool == this) {
         ec_.Notify(true);
         return false;
       } 
+      WorkerCounters::Add(&c->blocks, 1);
+      const auto start = std::chrono::steady_clock::now();
       ec_.CommitWait(waiter);
+      WorkerCounters::Add(
+          &c->blocked_nanos,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start).count());
       blocked_--;
       return true;
     } 
@@ -19,23 +19,26 @@ class SimpleThreadPoolTempl : public ThreadPoolInterface {
   explicit SimpleThreadPoolTempl(int num_threads, Environment env = Environment()) 
     : env_(env), threads_(num_threads), waiters_(num_threads) {
     for (int i=0; i < num_threads; ++i) {
-      threads_.push_back(env.CreatThread([this, i]() { WorkerLoop(i); }));
+      threads_.push_back(env_.CreateThread([this, i]() { WorkerLoop(i); }));
     }
   }
 
   ~SimpleThreadPoolTempl() {
-    std::unique_lock<std::mutex> l(mu_);
-    while (!pending_.empty()) {
-      empty_.wait(l);
-    }
-    exiting_ = true;
+    {
+      std::unique_lock<std::mutex> l(mu_);
+      while (!pending_.empty()) {
+        empty_.wait(l);
+      }
+      exiting_ = true;
 
-    for (auto w : waiters_) {
-      w->ready = true;
-      w->task.f = nullptr;
-      w->cv.notify_one();
+      for (auto w : waiters_) {
+        w->ready = true;
+        w->task.f = nullptr;
+        w->cv.notify_one();
+      }
     }
 
+    // The workers need mu_ to notice exiting_, so join them unlocked.
     for (auto t : threads_) {
       delete t;
     }
@@ -72,7 +75,7 @@ class SimpleThreadPoolTempl : public ThreadPoolInterface {
   }
  protected:
   void WorkerLoop(int thread_id) {
-    std::unique_ptr<std::mutex> l(mu_);
+    std::unique_lock<std::mutex> l(mu_);
     PerThread* pt = GetPerThread();
     pt->pool = this;
     pt->thread_id = thread_id;
@@ -85,7 +88,7 @@ class SimpleThreadPoolTempl : public ThreadPoolInterface {
         while (!w.ready) {
           w.cv.wait(l);
         }
-        t = w.task;
+        t = std::move(w.task);
         w.task.f = nullptr;
       } else {
         t = std::move(pending_.front());
@@ -125,7 +128,7 @@ class SimpleThreadPoolTempl : public ThreadPoolInterface {
   Environment env_;
   std::mutex mu_;
   MaxSizeVector<Thread*> threads_;
-  MaxSizeVector<Thread*> waiters_;
+  MaxSizeVector<Waiter*> waiters_;
   std::deque<Task> pending_;
   std::condition_variable empty_;
   bool exiting_ = false;
@@ -13,6 +13,12 @@ class ThreadPoolInterface {
   virtual int NumThreads() const = 0;
   virtual int CurrentThreadId() const = 0;
 
+  // Runs one queued task on the calling thread if the caller is a worker
+  // of this pool.  Returns false, without running anything, when the
+  // caller is not a worker or no queue of the pool holds a task.  Lets a
+  // worker waiting for tasks it scheduled help run them instead.
+  virtual bool TryRunPendingTask() { return false; }
+
 };
 
 } // namespace eigen
@@ -0,0 +1,83 @@
+#ifndef CORE_BASE_THREAD_THREAD_POOL_STATS_H_
+#define CORE_BASE_THREAD_THREAD_POOL_STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+namespace eigen {
+
+// A snapshot of the counters of a NonBlockingThreadPoolTempl.  Counters
+// are cumulative since the pool was created; subtract two snapshots to
+// look at an interval.
+struct ThreadPoolStats {
+  struct Worker {
+    uint64_t tasks_executed = 0;
+    // Passes over the other queues looking for work, and how many of
+    // them came back with a task.
+    uint64_t steals_attempted = 0;
+    uint64_t steals_succeeded = 0;
+    // Steal attempts made while spinning before going to sleep.
+    uint64_t spin_iterations = 0;
+    // Times the worker went to sleep in EventCount::CommitWait, and the
+    // time it spent there; a sleep is added to blocked_nanos when the
+    // worker wakes up.
+    uint64_t blocks = 0;
+    uint64_t blocked_nanos = 0;
+    // Size of the worker's own RunQueue, sampled every few tasks.
+    uint64_t queue_size_samples = 0;
+    uint64_t queue_size_sum = 0;
+    uint64_t queue_size_max = 0;
+
+    double mean_queue_size() const {
+      return queue_size_samples == 0
+                 ? 0
+                 : static_cast<double>(queue_size_sum) / queue_size_samples;
+    }
+
+    void Add(const Worker& w) {
+      tasks_executed += w.tasks_executed;
+      steals_attempted += w.steals_attempted;
+      steals_succeeded += w.steals_succeeded;
+      spin_iterations += w.spin_iterations;
+      blocks += w.blocks;
+      blocked_nanos += w.blocked_nanos;
+      queue_size_samples += w.queue_size_samples;
+      queue_size_sum += w.queue_size_sum;
+      if (w.queue_size_max > queue_size_max) queue_size_max = w.queue_size_max;
+    }
+  };
+
+  std::vector<Worker> workers;  // Indexed by thread id.
+  Worker total;                 // Sum over workers.
+
+  std::string DebugString() const {
+    std::string out;
+    char buf[256];
+    auto append = [&out, &buf](const char* name, const Worker& w) {
+      snprintf(buf, sizeof(buf),
+               "%-7s tasks=%llu steals=%llu/%llu spins=%llu blocks=%llu "
+               "blocked_ms=%.3f queue_mean=%.2f queue_max=%llu\n",
+               name, static_cast<unsigned long long>(w.tasks_executed),
+               static_cast<unsigned long long>(w.steals_succeeded),
+               static_cast<unsigned long long>(w.steals_attempted),
+               static_cast<unsigned long long>(w.spin_iterations),
+               static_cast<unsigned long long>(w.blocks),
+               w.blocked_nanos * 1e-6, w.mean_queue_size(),
+               static_cast<unsigned long long>(w.queue_size_max));
+      out += buf;
+    };
+    for (size_t i = 0; i < workers.size(); ++i) {
+      char name[32];
+      snprintf(name, sizeof(name), "#%zu", i);
+      append(name, workers[i]);
+    }
+    append("total", total);
+    return out;
+  }
+};
+
+}  // namespace eigen
+#endif  // CORE_BASE_THREAD_THREAD_POOL_STATS_H_
@@ -1,6 +1,8 @@
 #include "core/base/threadpool.h"
 #include "core/system/env.h"
 
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <thread>
 #include <vector>
@@ -9,12 +11,14 @@
 #include <condition_variable>
 
 #include "core/base/logging.h"
+#include "core/base/object_pool.h"
 
 // IF USE EIGEN_USE_THREADS
 #include "core/base/thread/device_thread_pool.h"
 #include "core/base/thread/cost_model.h"
 
 #include "core/system/context.h"
+#include "core/system/tracing.h"
 
 namespace mr {
 namespace thread {
@@ -26,13 +30,15 @@ struct EigenEnvironment {
 
   typedef mr::Thread EnvThread;
   struct TaskImpl {
-    std::function<void()> f;
+    ThreadPool::Closure f;
     Context context;
-    //Not Used Yet
+    // Nonzero if the closure was scheduled while tracing was active.
     uint64_t trace_id;
   };
+  // TaskImpls come from a thread-caching pool rather than new/delete; with
+  // the closure stored inline, a Schedule() in steady state never mallocs.
   struct Task {
-    std::unique_ptr<TaskImpl> f;
+    std::unique_ptr<TaskImpl, ObjectPool<TaskImpl>::Deleter> f;
   };
   
   Env* const env_;
@@ -50,27 +56,26 @@ struct EigenEnvironment {
     });
   }
 
-  Task CreateTask(std::function<void()> f) {
+  Task CreateTask(ThreadPool::Closure f) {
     uint64_t id = 0;
-#if 0
     if (port::Tracing::IsActive()) {
         id = port::Tracing::UniqueId();
         port::Tracing::RecordEvent(port::Tracing::EventCategory::kScheduleClosure,
                                                                       id);
     }
-#endif
       return Task{
-          std::unique_ptr<TaskImpl>(new TaskImpl{
-              std::move(f), mr::Context(mr::ContextKind::kThread), id,
-          }),
+          std::unique_ptr<TaskImpl, ObjectPool<TaskImpl>::Deleter>(
+              ObjectPool<TaskImpl>::New(TaskImpl{
+                  std::move(f), mr::Context(mr::ContextKind::kThread), id,
+              })),
       };
     }
   
   void ExecuteTask(const Task& t) {
     WithContext wc(t.f->context);
     if (t.f->trace_id != 0) {
-      //port::Tracing::ScopedActivity region(
-      //port::Tracing::EventCategory::kRunClosure, t.f->trace_id);
+      port::Tracing::ScopedActivity region(
+          port::Tracing::EventCategory::kRunClosure, t.f->trace_id);
         t.f->f();
       } else {
         t.f->f();
@@ -84,6 +89,10 @@ struct ThreadPool::Impl : eigen::ThreadPoolTempl<EigenEnvironment> {
         : eigen::ThreadPoolTempl<EigenEnvironment>(
               num_threads, EigenEnvironment(env, thread_options, name)) {}
   
+    void Schedule(ThreadPool::Closure fn) {
+      ScheduleTask(env().CreateTask(std::move(fn)));
+    }
+
     void ParallelFor(int64_t total, int64_t cost_per_unit,
                      std::function<void(int64_t, int64_t)> fn) {
       CHECK_GE(total, 0);
@@ -92,6 +101,24 @@ struct ThreadPool::Impl : eigen::ThreadPoolTempl<EigenEnvironment> {
       device.ParallelFor(total, eigen::OpCost(0, 0, cost_per_unit),
           [&fn](eigen::Index first, eigen::Index last) { fn(first, last); });
   }
+
+    void ParallelFor(int64_t total, eigen::CostEstimator* estimator,
+                     std::function<void(int64_t, int64_t)> fn) {
+      CHECK_GE(total, 0);
+      CHECK_EQ(total, (int64_t)(eigen::Index)total);
+      typedef std::chrono::steady_clock Clock;
+      std::atomic<int64_t> nanos(0);
+      eigen::ThreadPoolDevice device(this, this->NumThreads());
+      device.ParallelFor(total, estimator->cost(),
+          [&fn, &nanos](eigen::Index first, eigen::Index last) {
+            const Clock::time_point start = Clock::now();
+            fn(first, last);
+            nanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                Clock::now() - start).count(),
+                            std::memory_order_relaxed);
+          });
+      estimator->Update(total, nanos.load(std::memory_order_relaxed));
+  }
 };
   
 
@@ -109,7 +136,7 @@ ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
   
 ThreadPool::~ThreadPool() {}
   
-void ThreadPool::Schedule(std::function<void()> fn) {
+void ThreadPool::Schedule(Closure fn) {
   CHECK(fn != nullptr);
   impl_->Schedule(std::move(fn));
 } 
@@ -118,11 +145,19 @@ void ThreadPool::ParallelFor(int64_t total, int64_t cost_per_unit,
                              std::function<void(int64_t, int64_t)> fn) {
   impl_->ParallelFor(total, cost_per_unit, std::move(fn));
 } 
+
+void ThreadPool::ParallelFor(int64_t total, CostEstimator* estimator,
+                             std::function<void(int64_t, int64_t)> fn) {
+  CHECK(estimator != nullptr);
+  impl_->ParallelFor(total, estimator, std::move(fn));
+}
   
 int ThreadPool::NumThreads() const { return impl_->NumThreads(); }
   
 int ThreadPool::CurrentThreadId() const { return impl_->CurrentThreadId(); }
 
+void ThreadPool::GetStats(Stats* stats) const { impl_->GetStats(stats); }
+
 
 // IF NOT USE EIGEN_USE_THREADS
 #if 0
@@ -4,6 +4,9 @@
 #include <functional>
 #include <memory>
 #include "core/system/env.h"
+#include "core/base/inlined_function.h"
+#include "core/base/thread/cost_model.h"
+#include "core/base/thread/thread_pool_stats.h"
 #include "core/base/macros.h"
 
 namespace mr {
@@ -18,13 +21,34 @@ class ThreadPool {
 
   ~ThreadPool();
 
-  void Schedule(std::function<void()> fn);
+  // Closures passed to Schedule().  Captures of up to 48 bytes are kept
+  // inline, so scheduling them does not allocate.
+  typedef gtl::InlinedFunction<void()> Closure;
+
+  void Schedule(Closure fn);
   void ParallelFor(int64_t total,
                    int64_t cost_per_unit,
                    std::function<void(int64_t, int64_t)> fn);
+
+  // ParallelFor with a cost per unit measured by "estimator" on earlier
+  // invocations of the same call site, so the block size and number of
+  // threads follow what fn actually costs.  Every block is timed and the
+  // estimator updated when all are done.
+  //
+  //   static auto* cost = new ThreadPool::CostEstimator();
+  //   pool->ParallelFor(n, cost, [](int64_t first, int64_t last) { ... });
+  typedef eigen::CostEstimator CostEstimator;
+  void ParallelFor(int64_t total, CostEstimator* estimator,
+                   std::function<void(int64_t, int64_t)> fn);
+
   int NumThreads() const;
   int CurrentThreadId() const;
 
+  // Per-worker counters (tasks run, steals, spinning, time asleep, queue
+  // depth), aggregated when called.
+  typedef eigen::ThreadPoolStats Stats;
+  void GetStats(Stats* stats) const;
+
   struct Impl;
 
  private:
@@ -0,0 +1,310 @@
+#include "core/io/delimited_text.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "core/base/logging.h"
+#include "core/strings/byte_set.h"
+#include "core/strings/strcat.h"
+
+namespace mr {
+namespace io {
+
+namespace {
+
+// Chunks smaller than this are not worth a thread.
+static const size_t kMinChunkSize = 64 << 10;
+// Chunks per pool thread; more than one evens out chunks that parse slower.
+static const int kChunksPerThread = 4;
+
+inline const char* FindByte(const char* p, const char* limit, char c) {
+  const void* found = memchr(p, c, limit - p);
+  return found != nullptr ? static_cast<const char*>(found) : limit;
+}
+
+// Number of bytes equal to "c" in [p, limit).
+size_t CountByte(const char* p, const char* limit, char c) {
+  const strings::ByteSet set(StringPiece(&c, 1));
+  return strings::CountBytesInSet(p, limit, set);
+}
+
+// Returns the position after the first newline in [p, limit) that is not
+// inside a quoted field, given whether "p" is inside one, or "limit".
+const char* FindRecordBoundary(const char* p, const char* limit, char quote,
+                               bool quoted) {
+  if (quote == '\0') {
+    p = FindByte(p, limit, '\n');
+    return p < limit ? p + 1 : limit;
+  }
+  const str_util::ByAnyChar special(StringPiece(string{quote, '\n'}));
+  while ((p = special.Find(p, limit)) < limit) {
+    if (*p++ == quote) {
+      quoted = !quoted;
+    } else if (!quoted) {
+      return p;
+    }
+  }
+  return limit;
+}
+
+}  // namespace
+
+DelimitedTextParser::DelimitedTextParser(const DelimitedTextOptions& options)
+    : delimiter_(options.delimiter),
+      quote_(options.quote),
+      field_end_(StringPiece(string{options.delimiter, '\n'})) {
+  CHECK_NE(delimiter_, '\n');
+  CHECK_NE(quote_, '\n');
+  CHECK_NE(quote_, delimiter_);
+}
+
+DelimitedTextParser::Result DelimitedTextParser::Parse(
+    StringPiece* input, bool at_end, std::vector<StringPiece>* fields,
+    string* error) {
+  DCHECK(!input->empty());
+  fields->clear();
+  scratch_.clear();
+  escaped_.clear();
+  const char* p = input->data();
+  const char* const limit = p + input->size();
+  // Each iteration parses one field and the delimiter or newline after it.
+  while (true) {
+    if (quote_ == '\0' || p == limit || *p != quote_) {
+      const char* const end = field_end_.Find(p, limit);
+      if (end == limit && !at_end) return kNeedMore;
+      if (end < limit && *end == delimiter_) {
+        fields->push_back(StringPiece(p, end - p));
+        p = end + 1;
+        continue;
+      }
+      // The last field: drop the '\r' of "\r\n".
+      const char* field_end = end;
+      if (field_end > p && field_end[-1] == '\r') --field_end;
+      fields->push_back(StringPiece(p, field_end - p));
+      p = end < limit ? end + 1 : limit;
+      break;
+    }
+
+    // A quoted field: find the closing quote, unescaping doubled quotes.
+    const char* const start = ++p;
+    bool escaped = false;
+    while (true) {
+      const char* const q = FindByte(p, limit, quote_);
+      if (q == limit) {
+        if (!at_end) return kNeedMore;
+        *error = "unterminated quoted field";
+        return kError;
+      }
+      if (q + 1 == limit && !at_end) return kNeedMore;
+      if (q + 1 < limit && q[1] == quote_) {
+        if (!escaped) {
+          escaped_.push_back(EscapedField{fields->size(), scratch_.size(), 0});
+          escaped = true;
+        }
+        scratch_.append(p, q + 1 - p);
+        p = q + 2;
+        continue;
+      }
+      if (escaped) {
+        scratch_.append(p, q - p);
+        escaped_.back().size = scratch_.size() - escaped_.back().offset;
+      }
+      fields->push_back(StringPiece(start, q - start));
+      p = q + 1;
+      break;
+    }
+    if (p == limit) break;  // at_end, or the closing quote would be last.
+    if (*p == delimiter_) {
+      ++p;
+      continue;
+    }
+    if (*p == '\r' && p + 1 == limit) {
+      if (!at_end) return kNeedMore;
+      p = limit;
+      break;
+    }
+    if (*p == '\r' && p[1] == '\n') ++p;
+    if (*p == '\n') {
+      ++p;
+      break;
+    }
+    *error = strings::StrCat("unexpected character after quoted field ",
+                             fields->size());
+    return kError;
+  }
+
+  for (const EscapedField& e : escaped_) {
+    (*fields)[e.index] = StringPiece(scratch_.data() + e.offset, e.size);
+  }
+  input->remove_prefix(p - input->data());
+  return kRecord;
+}
+
+DelimitedTextReader::DelimitedTextReader(ZeroCopyInputStream* input,
+                                         const DelimitedTextOptions& options)
+    : input_(input), parser_(options) {}
+
+DelimitedTextReader::~DelimitedTextReader() {
+  // Leave the stream right after the last record returned.
+  if (!buffer_.empty()) input_->BackUp(buffer_.size());
+}
+
+Status DelimitedTextReader::ParseError(const string& error) const {
+  return Status(error::INVALID_ARGUMENT,
+                strings::StrCat("record ", records_read_, ": ", error));
+}
+
+bool DelimitedTextReader::FillBuffer() {
+  while (buffer_.empty()) {
+    const void* data;
+    int size;
+    if (at_end_ || !input_->Next(&data, &size)) {
+      at_end_ = true;
+      return false;
+    }
+    buffer_ = StringPiece(static_cast<const char*>(data), size);
+  }
+  return true;
+}
+
+void DelimitedTextReader::ExtendCarry() {
+  // Growing carry_ at least twofold reparses each byte of a long record a
+  // constant number of times on average.
+  const size_t min_size = 2 * carry_.size();
+  while (FillBuffer()) {
+    const char* const limit = buffer_.data() + buffer_.size();
+    const char* end = limit;
+    bool done = false;
+    if (carry_.size() + buffer_.size() >= min_size) {
+      end = FindByte(buffer_.data() + (min_size - carry_.size()), limit, '\n');
+      done = end < limit;
+      if (done) ++end;
+    }
+    carry_.append(buffer_.data(), end - buffer_.data());
+    buffer_.remove_prefix(end - buffer_.data());
+    if (done) return;
+  }
+}
+
+Status DelimitedTextReader::ReadRecord(std::vector<StringPiece>* fields) {
+  string error;
+  while (true) {
+    if (carry_pos_ == carry_.size()) {
+      // Records within one buffer are parsed in place.
+      carry_.clear();
+      carry_pos_ = 0;
+      if (!FillBuffer()) return Status(error::OUT_OF_RANGE, "end of input");
+      switch (parser_.Parse(&buffer_, false, fields, &error)) {
+        case DelimitedTextParser::kRecord:
+          ++records_read_;
+          return Status::OK;
+        case DelimitedTextParser::kNeedMore:
+          carry_.assign(buffer_.data(), buffer_.size());
+          buffer_.clear();
+          ExtendCarry();
+          break;
+        case DelimitedTextParser::kError:
+          return ParseError(error);
+      }
+    }
+    // A record that straddles buffers is completed in carry_, which may
+    // then hold the records after it too.
+    StringPiece rest(carry_.data() + carry_pos_, carry_.size() - carry_pos_);
+    switch (parser_.Parse(&rest, at_end_ && buffer_.empty(), fields,
+                          &error)) {
+      case DelimitedTextParser::kRecord:
+        carry_pos_ = carry_.size() - rest.size();
+        ++records_read_;
+        return Status::OK;
+      case DelimitedTextParser::kNeedMore:
+        carry_.erase(0, carry_pos_);
+        carry_pos_ = 0;
+        ExtendCarry();
+        break;
+      case DelimitedTextParser::kError:
+        return ParseError(error);
+    }
+  }
+}
+
+std::vector<StringPiece> SplitDelimitedTextChunks(
+    thread::ThreadPool* pool, StringPiece data, int max_chunks,
+    const DelimitedTextOptions& options) {
+  CHECK_GE(max_chunks, 1);
+  std::vector<StringPiece> chunks;
+  if (data.empty()) return chunks;
+  const size_t n = data.size();
+  const size_t num_chunks = std::max<size_t>(
+      1, std::min<size_t>(max_chunks, n / kMinChunkSize));
+  // Chunk c nominally starts at byte c * n / num_chunks.  Its real start is
+  // the first record boundary from there on, which depends on whether the
+  // nominal start is inside a quoted field: on the parity of the number of
+  // quotes before it.
+  std::vector<size_t> quotes(num_chunks, 0);
+  if (options.quote != '\0' && num_chunks > 1) {
+    // A cost this high makes ParallelFor hand out one chunk at a time.
+    const int64_t kCostPerChunk = 1 << 20;
+    pool->ParallelFor(num_chunks - 1, kCostPerChunk,
+                      [&](int64_t first, int64_t last) {
+      for (int64_t c = first; c < last; ++c) {
+        quotes[c] = CountByte(data.data() + c * n / num_chunks,
+                              data.data() + (c + 1) * n / num_chunks,
+                              options.quote);
+      }
+    });
+  }
+  const char* begin = data.data();
+  const char* const limit = data.data() + n;
+  size_t quotes_before = 0;
+  for (size_t c = 1; c < num_chunks; ++c) {
+    quotes_before += quotes[c - 1];
+    const char* const nominal = data.data() + c * n / num_chunks;
+    if (nominal < begin) continue;  // Inside the previous chunk's record.
+    const char* const boundary = FindRecordBoundary(
+        nominal, limit, options.quote, quotes_before % 2 == 1);
+    if (boundary == limit) break;
+    chunks.push_back(StringPiece(begin, boundary - begin));
+    begin = boundary;
+  }
+  chunks.push_back(StringPiece(begin, limit - begin));
+  return chunks;
+}
+
+Status ParseDelimitedTextInParallel(thread::ThreadPool* pool,
+                                    StringPiece data,
+                                    const DelimitedTextOptions& options,
+                                    const DelimitedTextRecordFn& fn) {
+  const std::vector<StringPiece> chunks = SplitDelimitedTextChunks(
+      pool, data, pool->NumThreads() * kChunksPerThread, options);
+  std::vector<Status> status(chunks.size());
+  const int64_t kCostPerChunk = 1 << 20;
+  pool->ParallelFor(chunks.size(), kCostPerChunk,
+                    [&](int64_t first, int64_t last) {
+    DelimitedTextParser parser(options);
+    std::vector<StringPiece> fields;
+    string error;
+    for (int64_t c = first; c < last; ++c) {
+      StringPiece rest = chunks[c];
+      while (!rest.empty()) {
+        const size_t offset = rest.data() - data.data();
+        if (parser.Parse(&rest, true, &fields, &error) ==
+            DelimitedTextParser::kError) {
+          status[c] = Status(error::INVALID_ARGUMENT,
+                             strings::StrCat("record at byte ", offset, ": ",
+                                             error));
+          break;
+        }
+        status[c] = fn(c, fields);
+        if (!status[c].ok()) break;
+      }
+    }
+  });
+  for (const Status& s : status) {
+    if (!s.ok()) return s;
+  }
+  return Status::OK;
+}
+
+}  // namespace io
+}  // namespace mr
@@ -0,0 +1,154 @@
+// Parsing of delimited text records: CSV, TSV and the like.
+//
+// A record is a line of fields separated by a delimiter character.  With
+// a quote character set (the default, for CSV), a field that starts with
+// it runs to the matching closing quote and may contain delimiters and
+// newlines, and a doubled quote inside stands for one quote:
+//
+//      plain,"with, comma","say ""hi""",
+//
+// is the four fields  plain | with, comma | say "hi" | (empty).  A quote
+// anywhere else is an ordinary character.  Lines end with "\n" or "\r\n".
+//
+// Fields are StringPieces into the input; only a field with doubled quotes,
+// or a record that straddles two buffers of a stream, is copied.  The
+// delimiter, quote and newline are found 16 or 32 bytes at a time (see
+// str_util::ByAnyChar), so long fields parse at memory speed.
+//
+// Example:
+//   io::DelimitedTextReader reader(&input_stream, io::DelimitedTextOptions());
+//   std::vector<StringPiece> fields;
+//   Status s;
+//   while ((s = reader.ReadRecord(&fields)).ok()) { ... }
+//   if (s.error_code() != error::OUT_OF_RANGE) return s;
+//
+// For a whole file in memory, ParseDelimitedTextInParallel() cuts it into
+// chunks of whole records and parses them on a ThreadPool.
+
+#ifndef CORE_IO_DELIMITED_TEXT_H_
+#define CORE_IO_DELIMITED_TEXT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "core/base/array_slice.h"
+#include "core/base/macros.h"
+#include "core/base/status.h"
+#include "core/base/threadpool.h"
+#include "core/io/zero_copy_stream.h"
+#include "core/strings/split.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace io {
+
+struct DelimitedTextOptions {
+  // ',' for CSV, '\t' for TSV.
+  char delimiter = ',';
+  // '\0' turns quoting off, as is usual for TSV.
+  char quote = '"';
+};
+
+// Parses the records of one contiguous piece of text.
+class DelimitedTextParser {
+ public:
+  explicit DelimitedTextParser(const DelimitedTextOptions& options);
+
+  enum Result { kRecord, kNeedMore, kError };
+
+  // Parses the record at the start of "*input" into "*fields" and removes
+  // it from "*input".  Returns kNeedMore, with "*input" unchanged, when the
+  // record may continue past the end of "*input" and "at_end" is false;
+  // kError, with "*error" set, on a malformed quoted field.  "*input" must
+  // not be empty.  The fields point into "*input", or into this parser for
+  // fields with doubled quotes, which stay valid until the next call.
+  Result Parse(StringPiece* input, bool at_end,
+               std::vector<StringPiece>* fields, string* error);
+
+ private:
+  const char delimiter_;
+  const char quote_;
+  // Finds the end of an unquoted field.
+  const str_util::ByAnyChar field_end_;
+  // Fields of the current record with doubled quotes, unescaped into
+  // scratch_, which may grow while the record is parsed.
+  struct EscapedField {
+    size_t index;
+    size_t offset;
+    size_t size;
+  };
+  string scratch_;
+  std::vector<EscapedField> escaped_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelimitedTextParser);
+};
+
+// Reads records from a ZeroCopyInputStream.
+class DelimitedTextReader {
+ public:
+  // Does not take ownership of "input".
+  DelimitedTextReader(ZeroCopyInputStream* input,
+                      const DelimitedTextOptions& options);
+  ~DelimitedTextReader();
+
+  // Reads the next record into "*fields".  The fields stay valid until the
+  // next call, or until the stream is used.  Returns OUT_OF_RANGE after the
+  // last record, and INVALID_ARGUMENT for a malformed record.
+  Status ReadRecord(std::vector<StringPiece>* fields);
+
+  // Number of records read so far.
+  int64_t records_read() const { return records_read_; }
+
+ private:
+  // Gets the next buffer from the stream if buffer_ is empty.  Returns
+  // false at the end of the stream.
+  bool FillBuffer();
+  // Moves input from buffer_ to carry_, at least doubling it, up to and
+  // including a newline or the end of the stream.
+  void ExtendCarry();
+
+  Status ParseError(const string& error) const;
+
+  ZeroCopyInputStream* const input_;
+  DelimitedTextParser parser_;
+  // Unparsed part of the last buffer returned by the stream.
+  StringPiece buffer_;
+  // Copied input, from carry_pos_ on starting with a record that
+  // straddles buffers.
+  string carry_;
+  size_t carry_pos_ = 0;
+  bool at_end_ = false;
+  int64_t records_read_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(DelimitedTextReader);
+};
+
+// Cuts "data" into at most "max_chunks" pieces of whole records, of about
+// the same size, using "pool" to count quotes.  Assumes quote characters
+// only appear in quoted fields, so that whether a position is inside a
+// quoted field follows from the number of quotes before it.
+std::vector<StringPiece> SplitDelimitedTextChunks(
+    thread::ThreadPool* pool, StringPiece data, int max_chunks,
+    const DelimitedTextOptions& options);
+
+// Called for every record of chunk "chunk"; an error stops the chunk.
+typedef std::function<Status(int chunk, gtl::ArraySlice<StringPiece> fields)>
+    DelimitedTextRecordFn;
+
+// Parses "data" in chunks (see SplitDelimitedTextChunks) on "pool".  "fn"
+// is called from several threads at once, but for the records of one
+// chunk in order, from one thread.  Returns the error of the first chunk
+// that failed, in chunk order.
+Status ParseDelimitedTextInParallel(thread::ThreadPool* pool,
+                                    StringPiece data,
+                                    const DelimitedTextOptions& options,
+                                    const DelimitedTextRecordFn& fn);
+
+}  // namespace io
+}  // namespace mr
+
+#endif  // CORE_IO_DELIMITED_TEXT_H_
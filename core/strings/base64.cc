@@ -1,9 +1,15 @@
 #include "core/strings/base64.h"
 #include "core/base/macros.h"
+#include "core/strings/byte_set.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 namespace mr {
 namespace {
 // This array must have signed type.
@@ -45,6 +51,319 @@ Status DecodeThreeChars(const char* codes, char* result) {
   result[2] = static_cast<char>(packed);
   return Status::OK;
 }
+
+Status InvalidCharacter() {
+  return Status(error::INVALID_ARGUMENT, "Invalid character found in base64.");
+}
+
+// Kernels.  An encode kernel encodes "n" bytes, a multiple of 3, into
+// 4 * n / 3 chars.  A decode kernel decodes "n" chars, a multiple of 4,
+// into 3 * n / 4 bytes, and returns how many chars it decoded: fewer than
+// "n" if it stopped at a group with padding or another character outside
+// the alphabet.  Neither reads or writes outside those ranges.
+//
+// On x86 the widest kernel the CPU supports is picked at the first call:
+// groups of 12 bytes (SSSE3) or 24 bytes (AVX2) are spread to 16 or 32
+// 6-bit indices and translated to chars with a shuffle, and chars are
+// validated and translated with range compares and packed with
+// multiply-adds, as described by Mula and Lemire ("Faster Base64 Encoding
+// and Decoding Using AVX2 Instructions", 2018).
+typedef void (*EncodeKernel)(const char* src, size_t n, char* dst);
+typedef size_t (*DecodeKernel)(const char* src, size_t n, char* dst);
+
+void EncodeScalar(const char* data, size_t n, char* current) {
+  const char* const base64_chars = kBase64UrlSafeChars;
+  const char* const end = data + n;
+  while (data < end) {
+    *current++ = base64_chars[(data[0] >> 2) & 0x3F];
+    *current++ =
+        base64_chars[((data[0] & 0x03) << 4) | ((data[1] >> 4) & 0x0F)];
+    *current++ =
+        base64_chars[((data[1] & 0x0F) << 2) | ((data[2] >> 6) & 0x03)];
+    *current++ = base64_chars[data[2] & 0x3F];
+    data += 3;
+  }
+}
+
+size_t DecodeScalar(const char* b64, size_t n, char* current) {
+  size_t decoded = 0;
+  for (; decoded < n; decoded += 4) {
+    if (!DecodeThreeChars(b64 + decoded, current).ok()) break;
+    current += 3;
+  }
+  return decoded;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MR_BASE64_SIMD 1
+
+__attribute__((target("ssse3")))
+static void EncodeSSSE3(const char* src, size_t n, char* dst) {
+  // Bytes [a b c] of each group to 32-bit lanes [b a c b], so that each
+  // 6-bit index can be shifted into its own byte.
+  const __m128i spread =
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m128i offsets = _mm_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0);
+  for (; n >= 16; n -= 12, src += 12, dst += 16) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    in = _mm_shuffle_epi8(in, spread);
+    const __m128i t0 = _mm_mulhi_epu16(
+        _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+        _mm_set1_epi32(0x04000040));
+    const __m128i t1 = _mm_mullo_epi16(
+        _mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+        _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t0, t1);
+    // 13 for 'A'-'Z', 0 for 'a'-'z', 1-10 for digits, 11 and 12 for '-'
+    // and '_': which offset to add.
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_or_si128(
+        range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices),
+                             _mm_set1_epi8(13)));
+    const __m128i chars =
+        _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), chars);
+  }
+  EncodeScalar(src, n, dst);
+}
+
+__attribute__((target("avx2")))
+static void EncodeAVX2(const char* src, size_t n, char* dst) {
+  const __m256i spread = _mm256_setr_epi8(
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i offsets = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0,
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0);
+  // Each 128-bit lane takes one group of 12 bytes.
+  for (; n >= 28; n -= 24, src += 24, dst += 32) {
+    __m256i in = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 12)), 1);
+    in = _mm256_shuffle_epi8(in, spread);
+    const __m256i t0 = _mm256_mulhi_epu16(
+        _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+        _mm256_set1_epi32(0x04000040));
+    const __m256i t1 = _mm256_mullo_epi16(
+        _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+        _mm256_set1_epi32(0x01000010));
+    const __m256i indices = _mm256_or_si256(t0, t1);
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    range = _mm256_or_si256(
+        range,
+        _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices),
+                         _mm256_set1_epi8(13)));
+    const __m256i chars =
+        _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), chars);
+  }
+  EncodeSSSE3(src, n, dst);
+}
+
+__attribute__((target("ssse3")))
+static size_t DecodeSSSE3(const char* src, size_t n, char* dst) {
+  const char* const start = src;
+  // Stores 16 bytes for 12, so keep two groups' worth of room.
+  for (; n >= 24; n -= 16, src += 16, dst += 12) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    // Bytes of 0x80 and up are negative and fall in no range.
+    const __m128i upper =
+        _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), in));
+    const __m128i lower =
+        _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), in));
+    const __m128i digit =
+        _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), in));
+    const __m128i dash = _mm_cmpeq_epi8(in, _mm_set1_epi8('-'));
+    const __m128i underscore = _mm_cmpeq_epi8(in, _mm_set1_epi8('_'));
+    const __m128i valid = _mm_or_si128(
+        _mm_or_si128(upper, lower),
+        _mm_or_si128(digit, _mm_or_si128(dash, underscore)));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) break;
+    const __m128i shift = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                     _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                     _mm_or_si128(_mm_and_si128(dash, _mm_set1_epi8(62 - '-')),
+                                  _mm_and_si128(underscore,
+                                                _mm_set1_epi8(63 - '_')))));
+    const __m128i values = _mm_add_epi8(in, shift);
+    // Four 6-bit values to 24 bits per lane, then three bytes per lane,
+    // most significant first.
+    const __m128i pairs =
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i lanes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    const __m128i out = _mm_shuffle_epi8(
+        lanes,
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+  }
+  return (src - start) + DecodeScalar(src, n, dst);
+}
+
+__attribute__((target("avx2")))
+static size_t DecodeAVX2(const char* src, size_t n, char* dst) {
+  const char* const start = src;
+  for (; n >= 40; n -= 32, src += 32, dst += 24) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    const __m256i upper =
+        _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('A' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in));
+    const __m256i lower =
+        _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in));
+    const __m256i digit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+    const __m256i dash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('-'));
+    const __m256i underscore = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('_'));
+    const __m256i valid = _mm256_or_si256(
+        _mm256_or_si256(upper, lower),
+        _mm256_or_si256(digit, _mm256_or_si256(dash, underscore)));
+    if (static_cast<uint32_t>(_mm256_movemask_epi8(valid)) != 0xFFFFFFFF) {
+      break;
+    }
+    const __m256i shift = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                        _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+        _mm256_or_si256(
+            _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+            _mm256_or_si256(
+                _mm256_and_si256(dash, _mm256_set1_epi8(62 - '-')),
+                _mm256_and_si256(underscore, _mm256_set1_epi8(63 - '_')))));
+    const __m256i values = _mm256_add_epi8(in, shift);
+    const __m256i pairs =
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    const __m256i lanes =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    const __m256i out = _mm256_shuffle_epi8(
+        lanes, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                                -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                -1, -1, -1, -1));
+    // 12 bytes at the start of each lane.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm256_castsi256_si128(out));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12),
+                     _mm256_extracti128_si256(out, 1));
+  }
+  return (src - start) + DecodeSSSE3(src, n, dst);
+}
+#endif  // __x86_64__ && __GNUC__
+
+EncodeKernel ChooseEncodeKernel() {
+#if defined(MR_BASE64_SIMD)
+  switch (strings::CpuVectorIsa()) {
+    case strings::VectorIsa::kAVX2:
+      return EncodeAVX2;
+    case strings::VectorIsa::kSSSE3:
+      return EncodeSSSE3;
+    default:
+      break;
+  }
+#endif
+  return EncodeScalar;
+}
+
+DecodeKernel ChooseDecodeKernel() {
+#if defined(MR_BASE64_SIMD)
+  switch (strings::CpuVectorIsa()) {
+    case strings::VectorIsa::kAVX2:
+      return DecodeAVX2;
+    case strings::VectorIsa::kSSSE3:
+      return DecodeSSSE3;
+    default:
+      break;
+  }
+#endif
+  return DecodeScalar;
+}
+
+void EncodeGroups(const char* src, size_t n, char* dst) {
+  static const EncodeKernel kernel = ChooseEncodeKernel();
+  kernel(src, n, dst);
+}
+
+size_t DecodeGroups(const char* src, size_t n, char* dst) {
+  static const DecodeKernel kernel = ChooseDecodeKernel();
+  return kernel(src, n, dst);
+}
+
+// Encodes the last 1 or 2 bytes of the input; returns the number of chars.
+int EncodeTail(const char* data, int n, bool with_padding, char* current) {
+  const char* const base64_chars = kBase64UrlSafeChars;
+  char* const start = current;
+  if (n == 2) {
+    *current++ = base64_chars[(data[0] >> 2) & 0x3F];
+    *current++ =
+        base64_chars[((data[0] & 0x03) << 4) | ((data[1] >> 4) & 0x0F)];
+    *current++ = base64_chars[(data[1] & 0x0F) << 2];
+    if (with_padding) {
+      *current++ = kPadChar;
+    }
+  } else if (n == 1) {
+    *current++ = base64_chars[(data[0] >> 2) & 0x3F];
+    *current++ = base64_chars[(data[0] & 0x03) << 4];
+    if (with_padding) {
+      *current++ = kPadChar;
+      *current++ = kPadChar;
+    }
+  }
+  return current - start;
+}
+
+// Streams write through the unused part of the last buffer from the
+// output stream.
+Status NextBuffer(ZeroCopyOutputStream* output, char** buffer,
+                  int* buffer_size) {
+  void* data;
+  do {
+    if (!output->Next(&data, buffer_size)) {
+      return Status(error::RESOURCE_EXHAUSTED,
+                    "Failed to write to the base64 output stream.");
+    }
+  } while (*buffer_size == 0);
+  *buffer = static_cast<char*>(data);
+  return Status::OK;
+}
+
+Status Emit(const char* data, int n, ZeroCopyOutputStream* output,
+            char** buffer, int* buffer_size) {
+  while (n > 0) {
+    if (*buffer_size == 0) {
+      RETURN_IF_ERROR(NextBuffer(output, buffer, buffer_size));
+    }
+    const int chunk = std::min(n, *buffer_size);
+    memcpy(*buffer, data, chunk);
+    data += chunk;
+    n -= chunk;
+    *buffer += chunk;
+    *buffer_size -= chunk;
+  }
+  return Status::OK;
+}
+
+void ReturnBuffer(ZeroCopyOutputStream* output, char** buffer,
+                  int* buffer_size) {
+  if (*buffer_size > 0) output->BackUp(*buffer_size);
+  *buffer = nullptr;
+  *buffer_size = 0;
+}
+
+// Whether "data" points into the storage of "s", which the whole-string
+// functions write to.
+bool Aliases(StringPiece data, const std::string& s) {
+  const char* const begin = s.data();
+  return data.data() + data.size() > begin &&
+         data.data() < begin + s.capacity();
+}
 }  // namespace
 
 Status Base64Decode(StringPiece data, 
@@ -57,27 +376,33 @@ Status Base64Decode(StringPiece data,
     decoded->clear();
     return Status::OK;
   }
+  if (PREDICT_FALSE(Aliases(data, *decoded))) {
+    std::string buffer;
+    const Status s = Base64Decode(data, &buffer);
+    decoded->swap(buffer);
+    return s;
+  }
 
   // This decoding procedure will write 3 * ceil(data.size() / 4) bytes to be
   // output buffer, then truncate if necessary. Therefore we must overestimate
   // and allocate sufficient amount. Currently max_decoded_size may overestimate
   // by up to 3 bytes.
   const size_t max_decoded_size = 3 * (data.size() / 4) + 3;
-  std::unique_ptr<char[]> buffer(new char[max_decoded_size]);
-  char* current = buffer.get();
-  if (current == nullptr) {
-    return Status(error::RESOURCE_EXHAUSTED,
-        "Failed to allocate buffer for decoded string.");
-  }
+  decoded->resize(max_decoded_size);
+  char* const start = &(*decoded)[0];
+  char* current = start;
 
   const char* b64 = data.data();
   const char* end = data.data() + data.size();
 
-  while (end - b64 > 4) {
-    RETURN_IF_ERROR(DecodeThreeChars(b64, current));
-    b64 += 4;
-    current += 3;
+  // Every group but the last has no padding.
+  const size_t body = (data.size() - 1) / 4 * 4;
+  if (DecodeGroups(b64, body, current) != body) {
+    decoded->clear();
+    return InvalidCharacter();
   }
+  b64 += body;
+  current += body / 4 * 3;
 
   if (end - b64 == 4) {
     // The data length is a multiple of 4. Check for padding.
@@ -93,6 +418,7 @@ Status Base64Decode(StringPiece data,
   const int remain = static_cast<int>(end - b64);
   if (PREDICT_FALSE(remain == 1)) {
     // We may check this condition early by checking data.size() % 4 == 1.
+    decoded->clear();
     return Status(error::INVALID_ARGUMENT,
         "Base64 string length cannot be 1 modulo 4.");
   }
@@ -102,11 +428,15 @@ Status Base64Decode(StringPiece data,
                   kBase64UrlSafeChars[0], kBase64UrlSafeChars[0]};
   // Copy tail of the input into the array, then decode.
   std::memcpy(tail, b64, remain * sizeof(*b64));
-  RETURN_IF_ERROR(DecodeThreeChars(tail, current));
+  const Status s = DecodeThreeChars(tail, current);
+  if (!s.ok()) {
+    decoded->clear();
+    return s;
+  }
   // We know how many parsed characters are valid.
   current += remain - 1;
 
-  decoded->assign(buffer.get(), current - buffer.get());
+  decoded->resize(current - start);
   return Status::OK;
 }
 
@@ -117,55 +447,176 @@ Status Base64Encode(StringPiece source,
 
 Status Base64Encode(StringPiece source, bool with_padding, 
 		    std::string* encoded) {
-  const char* const base64_chars = kBase64UrlSafeChars;
   if (encoded == nullptr) {
     return Status(error::INTERNAL, "'encoded' cannot be nullptr.");
   }
+  if (PREDICT_FALSE(Aliases(source, *encoded))) {
+    std::string buffer;
+    RETURN_IF_ERROR(Base64Encode(source, with_padding, &buffer));
+    encoded->swap(buffer);
+    return Status::OK;
+  }
+
+  const size_t groups = source.size() / 3;
+  const int tail = static_cast<int>(source.size() - 3 * groups);
+  encoded->resize(4 * groups +
+                  (tail == 0 ? 0 : with_padding ? 4 : tail + 1));
+  char* const current = &(*encoded)[0];
 
-  // max_encoded_size may overestimate by up to 4 bytes.
-  const size_t max_encoded_size = 4 * (source.size() / 3) + 4;
-  std::unique_ptr<char[]> buffer(new char[max_encoded_size]);
-  char* current = buffer.get();
-  if (current == nullptr) {
-    return Status(error::RESOURCE_EXHAUSTED,
-        "Failed to allocate buffer for encoded string.");
+  // Encode each block, then take care of the tail.
+  EncodeGroups(source.data(), 3 * groups, current);
+  EncodeTail(source.data() + 3 * groups, tail, with_padding,
+             current + 4 * groups);
+  return Status::OK;
+}
+
+Base64Encoder::Base64Encoder(bool with_padding, ZeroCopyOutputStream* output)
+    : with_padding_(with_padding), output_(output) {}
+
+Base64Encoder::~Base64Encoder() {
+  ReturnBuffer(output_, &buffer_, &buffer_size_);
+}
+
+Status Base64Encoder::Write(StringPiece data) {
+  char chars[4];
+  // Complete the group left by the last call.
+  if (num_pending_ > 0) {
+    while (num_pending_ < 3 && !data.empty()) {
+      pending_[num_pending_++] = data[0];
+      data.remove_prefix(1);
+    }
+    if (num_pending_ < 3) return Status::OK;
+    num_pending_ = 0;
+    EncodeScalar(pending_, 3, chars);
+    RETURN_IF_ERROR(Emit(chars, 4, output_, &buffer_, &buffer_size_));
+  }
+  // Encode straight into the output buffers.
+  while (data.size() >= 3) {
+    if (buffer_size_ < 4) {
+      if (buffer_size_ == 0) {
+        RETURN_IF_ERROR(NextBuffer(output_, &buffer_, &buffer_size_));
+        continue;
+      }
+      EncodeScalar(data.data(), 3, chars);
+      data.remove_prefix(3);
+      RETURN_IF_ERROR(Emit(chars, 4, output_, &buffer_, &buffer_size_));
+      continue;
+    }
+    const size_t groups = std::min<size_t>(data.size() / 3, buffer_size_ / 4);
+    EncodeGroups(data.data(), 3 * groups, buffer_);
+    data.remove_prefix(3 * groups);
+    buffer_ += 4 * groups;
+    buffer_size_ -= 4 * groups;
   }
+  memcpy(pending_, data.data(), data.size());
+  num_pending_ = data.size();
+  return Status::OK;
+}
 
-  const char* data = source.data();
-  const char* const end = source.data() + source.size();
+Status Base64Encoder::Finish() {
+  char chars[4];
+  const int n = EncodeTail(pending_, num_pending_, with_padding_, chars);
+  num_pending_ = 0;
+  RETURN_IF_ERROR(Emit(chars, n, output_, &buffer_, &buffer_size_));
+  ReturnBuffer(output_, &buffer_, &buffer_size_);
+  return Status::OK;
+}
 
-  // Encode each block.
-  while (end - data >= 3) {
-    *current++ = base64_chars[(data[0] >> 2) & 0x3F];
-    *current++ =
-        base64_chars[((data[0] & 0x03) << 4) | ((data[1] >> 4) & 0x0F)];
-    *current++ =
-        base64_chars[((data[1] & 0x0F) << 2) | ((data[2] >> 6) & 0x03)];
-    *current++ = base64_chars[data[2] & 0x3F];
+Base64Decoder::Base64Decoder(ZeroCopyOutputStream* output) : output_(output) {}
 
-    data += 3;
+Base64Decoder::~Base64Decoder() {
+  ReturnBuffer(output_, &buffer_, &buffer_size_);
+}
+
+Status Base64Decoder::DecodePending() {
+  int n = num_pending_;
+  num_pending_ = 0;
+  if (n == 4 && pending_[3] == kPadChar) {
+    // Base64 cannot have more than 2 paddings.
+    n = pending_[2] == kPadChar ? 2 : 3;
+    padded_ = true;
+  }
+  if (PREDICT_FALSE(n == 1)) {
+    return Status(error::INVALID_ARGUMENT,
+        "Base64 string length cannot be 1 modulo 4.");
   }
+  char tail[4] = {kBase64UrlSafeChars[0], kBase64UrlSafeChars[0],
+                  kBase64UrlSafeChars[0], kBase64UrlSafeChars[0]};
+  std::memcpy(tail, pending_, n);
+  char bytes[3];
+  RETURN_IF_ERROR(DecodeThreeChars(tail, bytes));
+  return Emit(bytes, n - 1, output_, &buffer_, &buffer_size_);
+}
 
-  // Take care of the tail.
-  if (end - data == 2) {
-    *current++ = base64_chars[(data[0] >> 2) & 0x3F];
-    *current++ =
-        base64_chars[((data[0] & 0x03) << 4) | ((data[1] >> 4) & 0x0F)];
-    *current++ = base64_chars[(data[1] & 0x0F) << 2];
-    if (with_padding) {
-      *current++ = kPadChar;
+Status Base64Decoder::Write(StringPiece data) {
+  // Complete the group left by the last call.
+  if (num_pending_ > 0) {
+    while (num_pending_ < 4 && !data.empty()) {
+      pending_[num_pending_++] = data[0];
+      data.remove_prefix(1);
     }
-  } else if (end - data == 1) {
-    *current++ = base64_chars[(data[0] >> 2) & 0x3F];
-    *current++ = base64_chars[(data[0] & 0x03) << 4];
-    if (with_padding) {
-      *current++ = kPadChar;
-      *current++ = kPadChar;
+    if (num_pending_ < 4) return Status::OK;
+    RETURN_IF_ERROR(DecodePending());
+  }
+  while (!data.empty()) {
+    // Only the last group may be padded.
+    if (padded_) return InvalidCharacter();
+    if (data.size() < 4) {
+      memcpy(pending_, data.data(), data.size());
+      num_pending_ = data.size();
+      break;
+    }
+    size_t groups = std::min<size_t>(data.size() / 4, buffer_size_ / 3);
+    if (groups == 0) {
+      if (buffer_size_ == 0) {
+        RETURN_IF_ERROR(NextBuffer(output_, &buffer_, &buffer_size_));
+        continue;
+      }
+      groups = 1;
+    } else {
+      // Decode straight into the output buffer.
+      const size_t decoded = DecodeGroups(data.data(), 4 * groups, buffer_);
+      data.remove_prefix(decoded);
+      buffer_ += decoded / 4 * 3;
+      buffer_size_ -= decoded / 4 * 3;
+      if (decoded == 4 * groups) continue;
     }
+    // A group that is padded, invalid, or straddles output buffers.
+    memcpy(pending_, data.data(), 4);
+    num_pending_ = 4;
+    data.remove_prefix(4);
+    RETURN_IF_ERROR(DecodePending());
   }
+  return Status::OK;
+}
 
-  encoded->assign(buffer.get(), current - buffer.get());
+Status Base64Decoder::Finish() {
+  if (num_pending_ > 0) RETURN_IF_ERROR(DecodePending());
+  ReturnBuffer(output_, &buffer_, &buffer_size_);
   return Status::OK;
 }
 
+Status Base64Encode(ZeroCopyInputStream* input, bool with_padding,
+                    ZeroCopyOutputStream* output) {
+  Base64Encoder encoder(with_padding, output);
+  const void* data;
+  int size;
+  while (input->Next(&data, &size)) {
+    RETURN_IF_ERROR(
+        encoder.Write(StringPiece(static_cast<const char*>(data), size)));
+  }
+  return encoder.Finish();
+}
+
+Status Base64Decode(ZeroCopyInputStream* input, ZeroCopyOutputStream* output) {
+  Base64Decoder decoder(output);
+  const void* data;
+  int size;
+  while (input->Next(&data, &size)) {
+    RETURN_IF_ERROR(
+        decoder.Write(StringPiece(static_cast<const char*>(data), size)));
+  }
+  return decoder.Finish();
+}
+
 }  // namespace tensorflow
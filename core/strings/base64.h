@@ -2,7 +2,9 @@
 #define TENSORFLOW_LIB_STRINGS_B64_H_
 
 #include <string>
+#include "core/base/macros.h"
 #include "core/base/status.h"
+#include "core/io/zero_copy_stream.h"
 
 namespace mr {
 
@@ -17,9 +19,70 @@ Status Base64Encode(StringPiece data,
 /// \brief Converts data from web-safe base64 encoding.
 ///
 /// See https://en.wikipedia.org/wiki/Base64
+/// On error "*decoded" is cleared.
 Status Base64Decode(StringPiece data, 
 		    std::string* decoded);
 
+/// \brief Encodes data written in pieces of any size into "output".
+///
+/// Only a partial group of up to two bytes is buffered, so a large payload
+/// is never held twice.  Finish() writes that group and returns the unused
+/// part of the last output buffer to "output".  On x86 12 or 24 bytes are
+/// encoded at a time with SSSE3 or AVX2.
+class Base64Encoder {
+ public:
+  /// Does not take ownership of "output", which must outlive Finish().
+  Base64Encoder(bool with_padding, ZeroCopyOutputStream* output);
+  ~Base64Encoder();
+
+  Status Write(StringPiece data);
+  Status Finish();
+
+ private:
+  const bool with_padding_;
+  ZeroCopyOutputStream* const output_;
+  // Unused part of the last buffer from output_.
+  char* buffer_ = nullptr;
+  int buffer_size_ = 0;
+  char pending_[3];
+  int num_pending_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(Base64Encoder);
+};
+
+/// \brief Decodes base64 written in pieces of any size into "output".
+///
+/// Accepts what Base64Decode() does: padding is optional, and only allowed
+/// at the very end.  Finish() decodes a final partial group.
+class Base64Decoder {
+ public:
+  /// Does not take ownership of "output", which must outlive Finish().
+  explicit Base64Decoder(ZeroCopyOutputStream* output);
+  ~Base64Decoder();
+
+  Status Write(StringPiece data);
+  Status Finish();
+
+ private:
+  // Decodes the (final, if shorter than four chars) group in pending_.
+  Status DecodePending();
+
+  ZeroCopyOutputStream* const output_;
+  char* buffer_ = nullptr;
+  int buffer_size_ = 0;
+  char pending_[4];
+  int num_pending_ = 0;
+  // Set by a padded group, which must be the last.
+  bool padded_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(Base64Decoder);
+};
+
+/// \brief Encode or decode everything "input" yields into "output".
+Status Base64Encode(ZeroCopyInputStream* input, bool with_padding,
+                    ZeroCopyOutputStream* output);
+Status Base64Decode(ZeroCopyInputStream* input, ZeroCopyOutputStream* output);
+
 }  // namespace mr
 
 #endif  // TENSORFLOW_LIB_STRINGS_B64_H_
@@ -0,0 +1,190 @@
+#include "core/strings/byte_set.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace mr {
+namespace strings {
+
+const int ByteSet::kMaxVectorChars;
+
+ByteSet::ByteSet(StringPiece chars) : num_chars_(0) {
+  memset(bits_, 0, sizeof(bits_));
+  for (char c : chars) {
+    if (contains(c)) continue;
+    const unsigned char u = static_cast<unsigned char>(c);
+    bits_[u >> 6] |= uint64_t{1} << (u & 63);
+    if (num_chars_ < kMaxVectorChars) chars_[num_chars_] = c;
+    ++num_chars_;
+  }
+  if (num_chars_ > kMaxVectorChars) num_chars_ = kMaxVectorChars + 1;
+}
+
+namespace {
+
+// The vector kernels take sets of 1 to kMaxVectorChars bytes.
+struct ByteSetKernels {
+  const char* (*find)(const char* p, const char* limit, const ByteSet& set);
+  size_t (*count)(const char* p, const char* limit, const ByteSet& set);
+};
+
+// Ranges shorter than one vector are scanned inline, byte by byte.
+static const ptrdiff_t kMinVectorScan = 16;
+
+inline const char* FindScalar(const char* p, const char* limit,
+                              const ByteSet& set) {
+  while (p < limit && !set.contains(*p)) ++p;
+  return p;
+}
+
+inline size_t CountScalar(const char* p, const char* limit,
+                          const ByteSet& set) {
+  size_t n = 0;
+  for (; p < limit; ++p) n += set.contains(*p);
+  return n;
+}
+
+#if defined(__SSE2__)
+// Compares 16 bytes at a time against the "n" members in "wanted".
+class MatcherSSE2 {
+ public:
+  explicit MatcherSSE2(const ByteSet& set) : n_(set.num_chars()) {
+    for (int i = 0; i < n_; ++i) wanted_[i] = _mm_set1_epi8(set.chars()[i]);
+  }
+
+  // Bit i is set if p[i] is in the set.
+  int Mask(const char* p) const {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i match = _mm_cmpeq_epi8(v, wanted_[0]);
+    for (int i = 1; i < n_; ++i) {
+      match = _mm_or_si128(match, _mm_cmpeq_epi8(v, wanted_[i]));
+    }
+    return _mm_movemask_epi8(match);
+  }
+
+ private:
+  const int n_;
+  __m128i wanted_[ByteSet::kMaxVectorChars];
+};
+
+static const char* FindSSE2(const char* p, const char* limit,
+                            const ByteSet& set) {
+  const MatcherSSE2 matcher(set);
+  for (; limit - p >= 16; p += 16) {
+    const int mask = matcher.Mask(p);
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+  return FindScalar(p, limit, set);
+}
+
+static size_t CountSSE2(const char* p, const char* limit, const ByteSet& set) {
+  const MatcherSSE2 matcher(set);
+  size_t n = 0;
+  for (; limit - p >= 16; p += 16) n += __builtin_popcount(matcher.Mask(p));
+  return n + CountScalar(p, limit, set);
+}
+#endif  // __SSE2__
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MR_BYTE_SET_AVX2 1
+// Compares 32 bytes at a time; only used when the CPU supports AVX2.
+class MatcherAVX2 {
+ public:
+  __attribute__((target("avx2"))) explicit MatcherAVX2(const ByteSet& set)
+      : n_(set.num_chars()) {
+    for (int i = 0; i < n_; ++i) {
+      wanted_[i] = _mm256_set1_epi8(set.chars()[i]);
+    }
+  }
+
+  __attribute__((target("avx2"))) uint32_t Mask(const char* p) const {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i match = _mm256_cmpeq_epi8(v, wanted_[0]);
+    for (int i = 1; i < n_; ++i) {
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi8(v, wanted_[i]));
+    }
+    return _mm256_movemask_epi8(match);
+  }
+
+ private:
+  const int n_;
+  __m256i wanted_[ByteSet::kMaxVectorChars];
+};
+
+__attribute__((target("avx2")))
+static const char* FindAVX2(const char* p, const char* limit,
+                            const ByteSet& set) {
+  const MatcherAVX2 matcher(set);
+  for (; limit - p >= 32; p += 32) {
+    const uint32_t mask = matcher.Mask(p);
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+  return FindScalar(p, limit, set);
+}
+
+__attribute__((target("avx2")))
+static size_t CountAVX2(const char* p, const char* limit, const ByteSet& set) {
+  const MatcherAVX2 matcher(set);
+  size_t n = 0;
+  for (; limit - p >= 32; p += 32) n += __builtin_popcount(matcher.Mask(p));
+  return n + CountScalar(p, limit, set);
+}
+#endif  // __x86_64__ && __GNUC__
+
+ByteSetKernels ChooseKernels() {
+#if defined(MR_BYTE_SET_AVX2)
+  if (CpuVectorIsa() == VectorIsa::kAVX2) return {FindAVX2, CountAVX2};
+#endif
+#if defined(__SSE2__)
+  return {FindSSE2, CountSSE2};
+#else
+  return {FindScalar, CountScalar};
+#endif
+}
+
+inline const ByteSetKernels& GetKernels() {
+  static const ByteSetKernels kernels = ChooseKernels();
+  return kernels;
+}
+
+inline bool UseVectors(const char* p, const char* limit, const ByteSet& set) {
+  return limit - p >= kMinVectorScan && set.num_chars() > 0 &&
+         set.num_chars() <= ByteSet::kMaxVectorChars;
+}
+
+VectorIsa ChooseVectorIsa() {
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (__builtin_cpu_supports("avx2")) return VectorIsa::kAVX2;
+  if (__builtin_cpu_supports("ssse3")) return VectorIsa::kSSSE3;
+  if (__builtin_cpu_supports("sse2")) return VectorIsa::kSSE2;
+#endif
+  return VectorIsa::kNone;
+}
+
+}  // namespace
+
+const char* FindByteInSet(const char* p, const char* limit,
+                          const ByteSet& set) {
+  if (set.num_chars() == 1) {
+    const void* d = memchr(p, set.chars()[0], limit - p);
+    return d != nullptr ? static_cast<const char*>(d) : limit;
+  }
+  if (!UseVectors(p, limit, set)) return FindScalar(p, limit, set);
+  return GetKernels().find(p, limit, set);
+}
+
+size_t CountBytesInSet(const char* p, const char* limit, const ByteSet& set) {
+  if (!UseVectors(p, limit, set)) return CountScalar(p, limit, set);
+  return GetKernels().count(p, limit, set);
+}
+
+VectorIsa CpuVectorIsa() {
+  static const VectorIsa isa = ChooseVectorIsa();
+  return isa;
+}
+
+}  // namespace strings
+}  // namespace mr
@@ -0,0 +1,62 @@
+// Vector scans for the bytes of a small set, shared by the string and text
+// routines whose inner loop is "find the next special byte" or "count the
+// special bytes": SplitPieces(), OrderedCode and DelimitedTextReader.
+//
+// Sets of up to ByteSet::kMaxVectorChars bytes are compared 16 (SSE2) or
+// 32 (AVX2) bytes at a time on x86, with the widest kernels the CPU
+// supports, picked at the first call.  Bigger sets, and ranges shorter
+// than one vector, are scanned byte by byte.
+//
+// Example:
+//   static const ByteSet kSpecial(StringPiece("\0\xff", 2));
+//   const char* p = FindByteInSet(start, limit, kSpecial);
+
+#ifndef CORE_STRINGS_BYTE_SET_H_
+#define CORE_STRINGS_BYTE_SET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace strings {
+
+// A set of byte values.
+class ByteSet {
+ public:
+  // Largest set searched with vector compares.
+  static const int kMaxVectorChars = 8;
+
+  explicit ByteSet(StringPiece chars);
+
+  bool contains(char c) const {
+    const unsigned char u = static_cast<unsigned char>(c);
+    return (bits_[u >> 6] >> (u & 63)) & 1;
+  }
+  // The distinct members, if there are at most kMaxVectorChars.
+  const char* chars() const { return chars_; }
+  int num_chars() const { return num_chars_; }
+
+ private:
+  uint64_t bits_[4];
+  char chars_[kMaxVectorChars];
+  int num_chars_;  // kMaxVectorChars + 1 for bigger sets
+};
+
+// Returns a pointer to the first byte in [p, limit) that is in "set", or
+// "limit" if there is none.
+const char* FindByteInSet(const char* p, const char* limit, const ByteSet& set);
+
+// Returns the number of bytes in [p, limit) that are in "set".
+size_t CountBytesInSet(const char* p, const char* limit, const ByteSet& set);
+
+// The widest x86 vector extension this CPU supports, for callers that pick
+// their own kernels (base64); kNone elsewhere.
+enum class VectorIsa { kNone, kSSE2, kSSSE3, kAVX2 };
+VectorIsa CpuVectorIsa();
+
+}  // namespace strings
+}  // namespace mr
+
+#endif  // CORE_STRINGS_BYTE_SET_H_
@@ -6,8 +6,12 @@
 #include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <locale>
+#include <sstream>
 #include <unordered_map>
 
 #include "core/base/logging.h"
@@ -94,6 +98,649 @@ T locale_independent_strtonum(const char* str, const char** endptr) {
   return result;
 }
 
+// Parses "str" with the stream-based parser above, which handles every
+// syntax strtod() does, but slowly.
+template <typename T>
+bool SlowStrToFloat(const char* str, T* value) {
+  const char* endptr;
+  *value = locale_independent_strtonum<T>(str, &endptr);
+  while (isspace(*endptr)) ++endptr;
+  // Ignore range errors from strtod/strtof.
+  // The values it returns on underflow and
+  // overflow are the right fallback in a
+  // robust setting.
+  return *str != '\0' && *endptr == '\0';
+}
+
+// Integer formatting.
+
+static const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+template <typename T>
+int CountDigits(T v) {
+  int n = 1;
+  while (true) {
+    if (v < 10) return n;
+    if (v < 100) return n + 1;
+    if (v < 1000) return n + 2;
+    if (v < 10000) return n + 3;
+    v /= 10000;
+    n += 4;
+  }
+}
+
+// Writes the decimal digits of "v" so that they end just before "end".
+template <typename T>
+void WriteDigitsBackward(T v, char* end) {
+  while (v >= 100) {
+    const T r = v % 100;
+    v /= 100;
+    end -= 2;
+    memcpy(end, kDigitPairs + 2 * r, 2);
+  }
+  if (v >= 10) {
+    memcpy(end - 2, kDigitPairs + 2 * v, 2);
+  } else {
+    end[-1] = static_cast<char>('0' + v);
+  }
+}
+
+template <typename T>
+char* UnsignedToBufferLeft(T v, char* buffer) {
+  char* const end = buffer + CountDigits(v);
+  WriteDigitsBackward(v, end);
+  *end = '\0';
+  return end;
+}
+
+// Floating point formatting and parsing.
+
+template <typename T>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<double> {
+  typedef uint64_t Bits;
+  static const int kMantissaBits = 52;
+  static const int kExponentBits = 11;
+  // printf("%g") precision that DoubleToBuffer() prefers.
+  static const int kDigits = DBL_DIG;
+  // Largest n for which 10^n is exact.
+  static const int kMaxExactPow10 = 22;
+};
+
+template <>
+struct FloatTraits<float> {
+  typedef uint32_t Bits;
+  static const int kMantissaBits = 23;
+  static const int kExponentBits = 8;
+  static const int kDigits = FLT_DIG;
+  static const int kMaxExactPow10 = 10;
+};
+
+static const double kExactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+typedef unsigned __int128 uint128;
+
+struct Uint128 {
+  uint64_t high;
+  uint64_t low;
+};
+
+// floor(log2(5^e)) + 1, for 0 <= e <= 3528.
+inline int Pow5Bits(int e) {
+  return static_cast<int>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)), for 0 <= e <= 1650.
+inline int Log10Pow2(int e) {
+  return static_cast<int>((static_cast<uint32_t>(e) * 78913) >> 18);
+}
+
+// floor(log10(5^e)), for 0 <= e <= 2620.
+inline int Log10Pow5(int e) {
+  return static_cast<int>((static_cast<uint32_t>(e) * 732923) >> 20);
+}
+
+// A non-negative integer of 32-bit words, least significant first: just
+// enough arithmetic to compute the tables below.
+class BigUint {
+ public:
+  // 2^bit.
+  explicit BigUint(int bit) : size_(bit / 32 + 1) {
+    CHECK_LT(bit, 32 * kMaxWords);
+    memset(words_, 0, sizeof(words_));
+    words_[bit / 32] = uint32_t{1} << (bit % 32);
+  }
+
+  void MultiplyBy5() {
+    uint64_t carry = 0;
+    for (int i = 0; i < size_; ++i) {
+      const uint64_t t = uint64_t{words_[i]} * 5 + carry;
+      words_[i] = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    if (carry != 0) {
+      CHECK_LT(size_, kMaxWords);
+      words_[size_++] = static_cast<uint32_t>(carry);
+    }
+  }
+
+  // Rounds down.
+  void DivideBy5() {
+    uint64_t remainder = 0;
+    for (int i = size_ - 1; i >= 0; --i) {
+      const uint64_t t = (remainder << 32) | words_[i];
+      words_[i] = static_cast<uint32_t>(t / 5);
+      remainder = t % 5;
+    }
+    while (size_ > 0 && words_[size_ - 1] == 0) --size_;
+  }
+
+  int BitLength() const {
+    if (size_ == 0) return 0;
+    return 32 * size_ - __builtin_clz(words_[size_ - 1]);
+  }
+
+  // Bits [shift, shift + 128) of the value; a negative "shift" shifts left.
+  Uint128 Bits128(int shift) const {
+    uint128 result = 0;
+    for (int i = 0; i < size_; ++i) {
+      const int pos = 32 * i - shift;
+      if (pos >= 128 || pos <= -32) continue;
+      const uint128 word = words_[i];
+      result |= pos >= 0 ? word << pos : word >> -pos;
+    }
+    return Uint128{static_cast<uint64_t>(result >> 64),
+                   static_cast<uint64_t>(result)};
+  }
+
+ private:
+  static const int kMaxWords = 40;
+  int size_;
+  uint32_t words_[kMaxWords];
+};
+
+// Powers of five for Ryu (Adams, "Ryu: fast float-to-string conversion",
+// PLDI 2018) and powers of ten for the Eisel-Lemire parser (Lemire, "Number
+// Parsing at a Gigabyte per Second", 2021), computed on first use instead
+// of compiled in.
+static const int kPow5Bits = 125;
+static const int kPow5InvBits = 125;
+static const int kPow5Count = 326;
+static const int kPow5InvCount = 342;
+static const int kMinPow10 = -348;
+static const int kMaxPow10 = 347;
+
+struct PowerTables {
+  PowerTables();
+
+  // 5^i, scaled to kPow5Bits bits and truncated.
+  Uint128 pow5[kPow5Count];
+  // floor(2^(Pow5Bits(i) - 1 + kPow5InvBits) / 5^i) + 1.
+  Uint128 pow5_inv[kPow5InvCount];
+  // 10^e for kMinPow10 <= e <= kMaxPow10, scaled to 128 bits and
+  // truncated, at index e - kMinPow10.
+  Uint128 pow10[kMaxPow10 - kMinPow10 + 1];
+};
+
+PowerTables::PowerTables() {
+  BigUint pow(0);
+  for (int i = 0; i <= kMaxPow10; ++i) {
+    const int bits = pow.BitLength();
+    if (i < kPow5Count) pow5[i] = pow.Bits128(bits - kPow5Bits);
+    pow10[i - kMinPow10] = pow.Bits128(bits - 128);
+    pow.MultiplyBy5();
+  }
+  // floor(2^kScale / 5^i) >> s == floor(2^(kScale - s) / 5^i), and 10^-i
+  // has the bits of 5^-i.
+  const int kScale = 1200;
+  BigUint inv(kScale);
+  for (int i = 0; i <= -kMinPow10; ++i) {
+    if (i < kPow5InvCount) {
+      Uint128 entry = inv.Bits128(kScale - (Pow5Bits(i) - 1 + kPow5InvBits));
+      if (++entry.low == 0) ++entry.high;
+      pow5_inv[i] = entry;
+    }
+    if (i > 0) pow10[-i - kMinPow10] = inv.Bits128(inv.BitLength() - 128);
+    inv.DivideBy5();
+  }
+}
+
+const PowerTables& Tables() {
+  static const PowerTables* tables = new PowerTables;
+  return *tables;
+}
+
+// (m * mul) >> j, for j >= 64.
+inline uint64_t MulShift(uint64_t m, const Uint128& mul, int j) {
+  const uint128 low = static_cast<uint128>(m) * mul.low;
+  const uint128 high = static_cast<uint128>(m) * mul.high;
+  return static_cast<uint64_t>(((low >> 64) + high) >> (j - 64));
+}
+
+inline bool MultipleOfPowerOf5(uint64_t v, int p) {
+  for (; p > 0; --p) {
+    if (v % 5 != 0) return false;
+    v /= 5;
+  }
+  return true;
+}
+
+inline bool MultipleOfPowerOf2(uint64_t v, int p) {
+  return (v & ((uint64_t{1} << p) - 1)) == 0;
+}
+
+// Sets "*digits" * 10^"*exponent" to the shortest decimal that rounds to
+// the finite, non-zero float with bits "bits", the closest one if there
+// are several.  This is Ryu's d2d(); the 125-bit tables serve floats too.
+template <typename T>
+void ShortestDecimal(typename FloatTraits<T>::Bits bits, uint64_t* digits,
+                     int* exponent) {
+  typedef FloatTraits<T> Traits;
+  const int kBias = (1 << (Traits::kExponentBits - 1)) - 1;
+  const uint64_t ieee_mantissa =
+      bits & ((uint64_t{1} << Traits::kMantissaBits) - 1);
+  const int ieee_exponent = static_cast<int>(
+      (bits >> Traits::kMantissaBits) & ((1u << Traits::kExponentBits) - 1));
+
+  // The value is m2 * 2^e2; the extra two bits make room for the bounds.
+  int e2;
+  uint64_t m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - kBias - Traits::kMantissaBits - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = ieee_exponent - kBias - Traits::kMantissaBits - 2;
+    m2 = (uint64_t{1} << Traits::kMantissaBits) | ieee_mantissa;
+  }
+  const bool accept_bounds = (m2 & 1) == 0;
+  // The halfway points to the neighbours are (mv - mm_shift - 1) and
+  // (mv + 2), times 2^e2.
+  const uint64_t mv = 4 * m2;
+  const int mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+  // Step 3: the value and bounds in decimal, vr * 10^e10 and so on.
+  const PowerTables& tables = Tables();
+  uint64_t vr, vp, vm;
+  int e10;
+  bool vm_is_trailing_zeros = false;
+  bool vr_is_trailing_zeros = false;
+  if (e2 >= 0) {
+    const int q = Log10Pow2(e2) - (e2 > 3);
+    e10 = q;
+    const int k = kPow5InvBits + Pow5Bits(q) - 1;
+    const int i = -e2 + q + k;
+    vr = MulShift(mv, tables.pow5_inv[q], i);
+    vp = MulShift(mv + 2, tables.pow5_inv[q], i);
+    vm = MulShift(mv - 1 - mm_shift, tables.pow5_inv[q], i);
+    if (q <= 21) {
+      // Only one of mv, mv + 2 and mv - 1 - mm_shift can be a multiple
+      // of 5, if any.
+      if (mv % 5 == 0) {
+        vr_is_trailing_zeros = MultipleOfPowerOf5(mv, q);
+      } else if (accept_bounds) {
+        vm_is_trailing_zeros = MultipleOfPowerOf5(mv - 1 - mm_shift, q);
+      } else {
+        vp -= MultipleOfPowerOf5(mv + 2, q);
+      }
+    }
+  } else {
+    const int q = Log10Pow5(-e2) - (-e2 > 1);
+    e10 = q + e2;
+    const int i = -e2 - q;
+    const int k = Pow5Bits(i) - kPow5Bits;
+    const int j = q - k;
+    vr = MulShift(mv, tables.pow5[i], j);
+    vp = MulShift(mv + 2, tables.pow5[i], j);
+    vm = MulShift(mv - 1 - mm_shift, tables.pow5[i], j);
+    if (q <= 1) {
+      // mv has at least two trailing zero bits.
+      vr_is_trailing_zeros = true;
+      if (accept_bounds) {
+        vm_is_trailing_zeros = mm_shift == 1;
+      } else {
+        --vp;
+      }
+    } else if (q < 63) {
+      vr_is_trailing_zeros = MultipleOfPowerOf2(mv, q);
+    }
+  }
+
+  // Step 4: drop digits while the bounds still differ.
+  int removed = 0;
+  int last_removed_digit = 0;
+  uint64_t output;
+  if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+    // Rare: exact values need round-half-even and inclusive bounds.
+    while (vp / 10 > vm / 10) {
+      vm_is_trailing_zeros &= vm % 10 == 0;
+      vr_is_trailing_zeros &= last_removed_digit == 0;
+      last_removed_digit = static_cast<int>(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    if (vm_is_trailing_zeros) {
+      while (vm % 10 == 0) {
+        vr_is_trailing_zeros &= last_removed_digit == 0;
+        last_removed_digit = static_cast<int>(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        ++removed;
+      }
+    }
+    if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+      last_removed_digit = 4;
+    }
+    output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) ||
+                   last_removed_digit >= 5);
+  } else {
+    bool round_up = false;
+    while (vp / 10 > vm / 10) {
+      round_up = vr % 10 >= 5;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    output = vr + (vr == vm || round_up);
+  }
+  *digits = output;
+  *exponent = e10 + removed;
+}
+
+// Formats "value" the way printf("%.*g") would, with the fewest digits
+// that round-trip; see DoubleToBuffer().
+template <typename T>
+char* FormatShortest(T value, char* buffer) {
+  typedef FloatTraits<T> Traits;
+  char* p = buffer;
+  if (std::isnan(value)) {
+    strcpy(buffer, std::signbit(value) ? "-nan" : "nan");
+    return buffer;
+  }
+  if (std::signbit(value)) *p++ = '-';
+  if (std::isinf(value)) {
+    strcpy(p, "inf");
+    return buffer;
+  }
+  if (value == 0) {
+    strcpy(p, "0");
+    return buffer;
+  }
+
+  typename Traits::Bits bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint64_t digits;
+  int exponent;
+  ShortestDecimal<T>(bits, &digits, &exponent);
+  while (digits % 10 == 0) {
+    digits /= 10;
+    ++exponent;
+  }
+  const int num_digits = CountDigits(digits);
+  char d[20];
+  WriteDigitsBackward(digits, d + num_digits);
+
+  // %g switches to scientific notation when the exponent of the first
+  // digit is below -4 or not below the precision.
+  const int precision =
+      num_digits <= Traits::kDigits ? Traits::kDigits : Traits::kDigits + 2;
+  const int x = exponent + num_digits - 1;
+  if (x < -4 || x >= precision) {
+    *p++ = d[0];
+    if (num_digits > 1) {
+      *p++ = '.';
+      memcpy(p, d + 1, num_digits - 1);
+      p += num_digits - 1;
+    }
+    *p++ = 'e';
+    *p++ = x < 0 ? '-' : '+';
+    const uint32_t abs_x = x < 0 ? -x : x;
+    if (abs_x < 10) *p++ = '0';
+    UnsignedToBufferLeft(abs_x, p);
+    return buffer;
+  }
+  if (x < 0) {
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -x - 1);
+    p += -x - 1;
+    memcpy(p, d, num_digits);
+    p += num_digits;
+  } else if (num_digits <= x + 1) {
+    memcpy(p, d, num_digits);
+    p += num_digits;
+    memset(p, '0', x + 1 - num_digits);
+    p += x + 1 - num_digits;
+  } else {
+    memcpy(p, d, x + 1);
+    p += x + 1;
+    *p++ = '.';
+    memcpy(p, d + x + 1, num_digits - x - 1);
+    p += num_digits - x - 1;
+  }
+  *p = '\0';
+  return buffer;
+}
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Eight ASCII digits at a time, as in Lemire's paper.  The byte order of
+// a loaded word is little-endian.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static const bool kSwarDigits = true;
+#else
+static const bool kSwarDigits = false;
+#endif
+
+inline bool IsEightDigits(uint64_t v) {
+  return ((v & 0xF0F0F0F0F0F0F0F0) |
+          (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+inline uint64_t ParseEightDigits(uint64_t v) {
+  const uint64_t kMask = 0x000000FF000000FF;
+  const uint64_t kMul1 = 0x000F424000000064;  // 100 + (1000000 << 32)
+  const uint64_t kMul2 = 0x0000271000000001;  // 1 + (10000 << 32)
+  v -= 0x3030303030303030;
+  v = (v * 10) + (v >> 8);
+  return (((v & kMask) * kMul1) + (((v >> 16) & kMask) * kMul2)) >> 32;
+}
+
+// At most this many significant digits fit a uint64_t.
+static const int kMaxMantissaDigits = 19;
+
+// Appends the digits at "*p" to "*mantissa", which has "*num_digits"
+// significant digits, skipping leading zeros.  Returns the number of
+// digits consumed, or -1 past kMaxMantissaDigits significant digits.
+int ConsumeDigits(const char** p, const char* limit, uint64_t* mantissa,
+                  int* num_digits) {
+  const char* s = *p;
+  if (*num_digits == 0) {
+    while (s < limit && *s == '0') ++s;
+  }
+  while (kSwarDigits && limit - s >= 8 &&
+         *num_digits <= kMaxMantissaDigits - 8) {
+    uint64_t v;
+    memcpy(&v, s, 8);
+    if (!IsEightDigits(v)) break;
+    *mantissa = *mantissa * 100000000 + ParseEightDigits(v);
+    *num_digits += 8;
+    s += 8;
+  }
+  for (; s < limit && IsDigit(*s); ++s) {
+    if (*num_digits == kMaxMantissaDigits) return -1;
+    *mantissa = *mantissa * 10 + (*s - '0');
+    ++*num_digits;
+  }
+  const int consumed = s - *p;
+  *p = s;
+  return consumed;
+}
+
+// A number in plain decimal notation, mantissa * 10^exponent.
+struct Decimal {
+  uint64_t mantissa;
+  int64_t exponent;
+  bool negative;
+};
+
+// Parses [p, limit) as [+-]digits[.digits][(e|E)[+-]digits] with optional
+// whitespace around it.  Returns false for anything else, including more
+// than kMaxMantissaDigits significant digits.
+bool ParseDecimal(const char* p, const char* limit, Decimal* d) {
+  while (p < limit && isspace(*p)) ++p;
+  while (limit > p && isspace(limit[-1])) --limit;
+  d->negative = false;
+  if (p < limit && (*p == '-' || *p == '+')) d->negative = *p++ == '-';
+  d->mantissa = 0;
+  d->exponent = 0;
+  int num_digits = 0;
+  int consumed = ConsumeDigits(&p, limit, &d->mantissa, &num_digits);
+  if (consumed < 0) return false;
+  bool any_digits = consumed > 0;
+  if (p < limit && *p == '.') {
+    ++p;
+    consumed = ConsumeDigits(&p, limit, &d->mantissa, &num_digits);
+    if (consumed < 0) return false;
+    d->exponent = -consumed;
+    any_digits |= consumed > 0;
+  }
+  if (!any_digits) return false;
+  if (p < limit && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exponent = false;
+    if (p < limit && (*p == '-' || *p == '+')) {
+      negative_exponent = *p++ == '-';
+    }
+    if (p == limit || !IsDigit(*p)) return false;
+    int64_t e = 0;
+    for (; p < limit && IsDigit(*p); ++p) {
+      if (e < 100000) e = e * 10 + (*p - '0');
+    }
+    d->exponent += negative_exponent ? -e : e;
+  }
+  return p == limit;
+}
+
+// Eisel-Lemire: rounds mantissa * 10^exp10 from a 128-bit product with a
+// truncated power of ten.  Returns false when the product cannot decide
+// the rounding, and for subnormal and infinite results.
+template <typename T>
+bool EiselLemire(uint64_t mantissa, int64_t exp10, bool negative, T* value) {
+  typedef FloatTraits<T> Traits;
+  typedef typename Traits::Bits Bits;
+  const int kShift = 64 - Traits::kMantissaBits - 3;
+  const uint64_t kMask = (uint64_t{1} << kShift) - 1;
+  const int kBias = (1 << (Traits::kExponentBits - 1)) - 1;
+  if (exp10 < kMinPow10 || exp10 > kMaxPow10) return false;
+
+  // Normalize.
+  const int clz = __builtin_clzll(mantissa);
+  mantissa <<= clz;
+  uint64_t exp2 = static_cast<uint64_t>(((217706 * exp10) >> 16) + 64 + kBias -
+                                        clz);
+
+  // Multiply, with the low half of the power only when the high half
+  // leaves the rounding open.
+  const Uint128& pow = Tables().pow10[exp10 - kMinPow10];
+  const uint128 x = static_cast<uint128>(mantissa) * pow.high;
+  uint64_t x_hi = static_cast<uint64_t>(x >> 64);
+  uint64_t x_lo = static_cast<uint64_t>(x);
+  if ((x_hi & kMask) == kMask && x_lo + mantissa < mantissa) {
+    const uint128 y = static_cast<uint128>(mantissa) * pow.low;
+    const uint64_t y_hi = static_cast<uint64_t>(y >> 64);
+    const uint64_t y_lo = static_cast<uint64_t>(y);
+    uint64_t merged_hi = x_hi;
+    const uint64_t merged_lo = x_lo + y_hi;
+    if (merged_lo < x_lo) ++merged_hi;
+    if ((merged_hi & kMask) == kMask && merged_lo + 1 == 0 &&
+        y_lo + mantissa < mantissa) {
+      return false;
+    }
+    x_hi = merged_hi;
+    x_lo = merged_lo;
+  }
+
+  // Keep one bit more than the mantissa, then round half to even.
+  const uint64_t msb = x_hi >> 63;
+  uint64_t m = x_hi >> (msb + kShift);
+  exp2 -= 1 ^ msb;
+  if (x_lo == 0 && (x_hi & kMask) == 0 && (m & 3) == 1) return false;
+  m += m & 1;
+  m >>= 1;
+  if (m >> (Traits::kMantissaBits + 1) > 0) {
+    m >>= 1;
+    ++exp2;
+  }
+  const uint64_t kMaxExp2 = (uint64_t{1} << Traits::kExponentBits) - 1;
+  if (exp2 - 1 >= kMaxExp2 - 1) return false;
+
+  Bits bits = static_cast<Bits>((exp2 << Traits::kMantissaBits) |
+                                (m & ((uint64_t{1} << Traits::kMantissaBits) -
+                                      1)));
+  if (negative) bits |= Bits{1} << (8 * sizeof(Bits) - 1);
+  memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+// Parses [p, limit) like SlowStrToFloat(), or returns false for syntax and
+// values left to it: hex, "inf", "nan", long mantissas, subnormals and
+// overflow.
+template <typename T>
+bool ParseFast(const char* p, const char* limit, T* value) {
+  typedef FloatTraits<T> Traits;
+  Decimal d;
+  if (!ParseDecimal(p, limit, &d)) return false;
+  if (d.mantissa == 0) {
+    *value = d.negative ? -T(0) : T(0);
+    return true;
+  }
+  // Clinger's fast path: with an exact mantissa and power of ten, one
+  // multiplication or division rounds correctly.
+  if (d.mantissa <= (uint64_t{1} << (Traits::kMantissaBits + 1)) &&
+      d.exponent >= -Traits::kMaxExactPow10 &&
+      d.exponent <= Traits::kMaxExactPow10) {
+    T v = static_cast<T>(d.mantissa);
+    if (d.exponent < 0) {
+      v /= static_cast<T>(kExactPowersOfTen[-d.exponent]);
+    } else {
+      v *= static_cast<T>(kExactPowersOfTen[d.exponent]);
+    }
+    *value = d.negative ? -v : v;
+    return true;
+  }
+  return EiselLemire(d.mantissa, d.exponent, d.negative, value);
+}
+
+template <typename T>
+size_t ParseColumn(gtl::ArraySlice<StringPiece> column,
+                   gtl::MutableArraySlice<T> values,
+                   bool (*parse)(StringPiece, T*)) {
+  CHECK_EQ(column.size(), values.size());
+  for (size_t i = 0; i < column.size(); ++i) {
+    if (!parse(column[i], &values[i])) return i;
+  }
+  return column.size();
+}
+
 }  // namespace
 
 namespace strings {
@@ -111,14 +758,7 @@ char* FastInt32ToBufferLeft(int32_t i, char* buffer) {
 }
 
 char* FastUInt32ToBufferLeft(uint32_t i, char* buffer) {
-  char* start = buffer;
-  do {
-    *buffer++ = ((i % 10) + '0');
-    i /= 10;
-  } while (i > 0);
-  *buffer = 0;
-  std::reverse(start, buffer);
-  return buffer;
+  return UnsignedToBufferLeft(i, buffer);
 }
 
 char* FastInt64ToBufferLeft(int64_t i, char* buffer) {
@@ -131,46 +771,15 @@ char* FastInt64ToBufferLeft(int64_t i, char* buffer) {
 }
 
 char* FastUInt64ToBufferLeft(uint64_t i, char* buffer) {
-  char* start = buffer;
-  do {
-    *buffer++ = ((i % 10) + '0');
-    i /= 10;
-  } while (i > 0);
-  *buffer = 0;
-  std::reverse(start, buffer);
-  return buffer;
+  // 32-bit divisions are cheaper; most values fit.
+  if (i <= std::numeric_limits<uint32_t>::max()) {
+    return UnsignedToBufferLeft(static_cast<uint32_t>(i), buffer);
+  }
+  return UnsignedToBufferLeft(i, buffer);
 }
 
-static const double kDoublePrecisionCheckMax = DBL_MAX / 1.000000000000001;
-
 char* DoubleToBuffer(double value, char* buffer) {
-  // DBL_DIG is 15 for IEEE-754 doubles, which are used on almost all
-  // platforms these days.  Just in case some system exists where DBL_DIG
-  // is significantly larger -- and risks overflowing our buffer -- we have
-  // this assert.
-  static_assert(DBL_DIG < 20, "DBL_DIG is too big");
-
-  bool full_precision_needed = true;
-  if (std::abs(value) <= kDoublePrecisionCheckMax) {
-    int snprintf_result =
-        snprintf(buffer, kFastToBufferSize, "%.*g", DBL_DIG, value);
-
-    // The snprintf should never overflow because the buffer is significantly
-    // larger than the precision we asked for.
-    DCHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
-
-    full_precision_needed =
-        locale_independent_strtonum<double>(buffer, NULL) != value;
-  }
-
-  if (full_precision_needed) {
-    int snprintf_result =
-        snprintf(buffer, kFastToBufferSize, "%.*g", DBL_DIG + 2, value);
-
-    // Should never overflow; see above.
-    DCHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
-  }
-  return buffer;
+  return FormatShortest(value, buffer);
 }
 
 namespace {
@@ -186,12 +795,12 @@ void SkipSpaces(StringPiece* str) {
 bool safe_strto64(StringPiece str, int64_t* value) {
   SkipSpaces(&str);
 
-  int64_t vlimit = std::numeric_limits<int64_t>::max(); //kint64max;
+  int64_t vlimit = kint64max;
   int sign = 1;
   if (str.Consume("-")) {
     sign = -1;
     // Different limit for positive and negative integers.
-    vlimit = std::numeric_limits<int64_t>::max(); //kint64min;
+    vlimit = kint64min;
   }
 
   if (!isdigit(SafeFirstChar(str))) return false;
@@ -296,50 +905,42 @@ bool safe_strtou32(StringPiece str, uint32_t* value) {
 }
 
 bool safe_strtof(const char* str, float* value) {
-  const char* endptr;
-  *value = locale_independent_strtonum<float>(str, &endptr);
-  while (isspace(*endptr)) ++endptr;
-  // Ignore range errors from strtod/strtof.
-  // The values it returns on underflow and
-  // overflow are the right fallback in a
-  // robust setting.
-  return *str != '\0' && *endptr == '\0';
+  return ParseFast(str, str + strlen(str), value) || SlowStrToFloat(str, value);
 }
 
 bool safe_strtod(const char* str, double* value) {
-  const char* endptr;
-  *value = locale_independent_strtonum<double>(str, &endptr);
-  while (isspace(*endptr)) ++endptr;
-  // Ignore range errors from strtod/strtof.
-  // The values it returns on underflow and
-  // overflow are the right fallback in a
-  // robust setting.
-  return *str != '\0' && *endptr == '\0';
+  return ParseFast(str, str + strlen(str), value) || SlowStrToFloat(str, value);
 }
 
-char* FloatToBuffer(float value, char* buffer) {
-  // FLT_DIG is 6 for IEEE-754 floats, which are used on almost all
-  // platforms these days.  Just in case some system exists where FLT_DIG
-  // is significantly larger -- and risks overflowing our buffer -- we have
-  // this assert.
-  static_assert(FLT_DIG < 10, "FLT_DIG is too big");
+bool safe_strtof(StringPiece str, float* value) {
+  if (ParseFast(str.data(), str.data() + str.size(), value)) return true;
+  if (memchr(str.data(), '\0', str.size()) != nullptr) return false;
+  return SlowStrToFloat(str.ToString().c_str(), value);
+}
 
-  int snprintf_result =
-      snprintf(buffer, kFastToBufferSize, "%.*g", FLT_DIG, value);
+bool safe_strtod(StringPiece str, double* value) {
+  if (ParseFast(str.data(), str.data() + str.size(), value)) return true;
+  if (memchr(str.data(), '\0', str.size()) != nullptr) return false;
+  return SlowStrToFloat(str.ToString().c_str(), value);
+}
+
+size_t ParseInt64s(gtl::ArraySlice<StringPiece> column,
+                   gtl::MutableArraySlice<int64_t> values) {
+  return ParseColumn(column, values, safe_strto64);
+}
 
-  // The snprintf should never overflow because the buffer is significantly
-  // larger than the precision we asked for.
-  DCHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
+size_t ParseFloats(gtl::ArraySlice<StringPiece> column,
+                   gtl::MutableArraySlice<float> values) {
+  return ParseColumn(column, values, safe_strtof);
+}
 
-  float parsed_value;
-  if (!safe_strtof(buffer, &parsed_value) || parsed_value != value) {
-    snprintf_result =
-        snprintf(buffer, kFastToBufferSize, "%.*g", FLT_DIG + 2, value);
+size_t ParseDoubles(gtl::ArraySlice<StringPiece> column,
+                    gtl::MutableArraySlice<double> values) {
+  return ParseColumn(column, values, safe_strtod);
+}
 
-    // Should never overflow; see above.
-    DCHECK(snprintf_result > 0 && snprintf_result < kFastToBufferSize);
-  }
-  return buffer;
+char* FloatToBuffer(float value, char* buffer) {
+  return FormatShortest(value, buffer);
 }
 
 std::string FpToString(uint64_t fp) {
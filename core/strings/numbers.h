@@ -1,7 +1,11 @@
 #ifndef TENSORFLOW_LIB_STRINGS_NUMBERS_H_
 #define TENSORFLOW_LIB_STRINGS_NUMBERS_H_
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
 
+#include "core/base/array_slice.h"
 #include "core/strings/string_piece.h"
 
 namespace mr {
@@ -9,11 +13,17 @@ namespace strings {
 
 static const int kFastToBufferSize = 32;
 
+// These write the decimal digits and a terminating NUL and return a pointer
+// to the NUL.  Digits are produced two at a time from a 200-byte table.
 char* FastInt32ToBufferLeft(int32_t i, char* buffer);    // at least 12 bytes
 char* FastUInt32ToBufferLeft(uint32_t i, char* buffer);  // at least 12 bytes
 char* FastInt64ToBufferLeft(int64_t i, char* buffer);    // at least 22 bytes
 char* FastUInt64ToBufferLeft(uint64_t i, char* buffer);  // at least 22 bytes
 
+// Write the shortest decimal string that parses back to exactly "i", in
+// the style of printf's "%g" with DBL_DIG (FLT_DIG) digits when that many
+// suffice and two more otherwise: "0.1", "1e+20", "3.0000000000000004".
+// "buffer" must have room for kFastToBufferSize bytes; returns "buffer".
 char* DoubleToBuffer(double i, char* buffer);
 char* FloatToBuffer(float i, char* buffer);
 
@@ -29,8 +39,24 @@ bool safe_strtou32(StringPiece str, uint32_t* value);
 bool safe_strto64(StringPiece str, int64_t* value);
 bool safe_strtou64(StringPiece str, uint64_t* value);
 
+// Parse a number with optional surrounding whitespace, rounding correctly.
+// Out-of-range values become +/-inf or 0.  Hex, "inf" and "nan" are also
+// accepted.
 bool safe_strtof(const char* str, float* value);
 bool safe_strtod(const char* str, double* value);
+bool safe_strtof(StringPiece str, float* value);
+bool safe_strtod(StringPiece str, double* value);
+
+// Parse a column of numbers, such as one field of many delimited text
+// records, as the safe_strto* functions above do.  "values" must have the
+// size of "column".  Return the number of leading entries that parsed;
+// parsing stops at the first that does not.
+size_t ParseInt64s(gtl::ArraySlice<StringPiece> column,
+                   gtl::MutableArraySlice<int64_t> values);
+size_t ParseFloats(gtl::ArraySlice<StringPiece> column,
+                   gtl::MutableArraySlice<float> values);
+size_t ParseDoubles(gtl::ArraySlice<StringPiece> column,
+                    gtl::MutableArraySlice<double> values);
 
 // Converts from an int64_t representing a number of bytes to a
 // human readable string representing the same number.
@@ -2,7 +2,12 @@
 
 #include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
+
+#include "core/strings/byte_set.h"
 #include "core/strings/string_piece.h"
 #include "core/base/logging.h"
 
@@ -121,58 +126,85 @@ inline static void AppendBytes(string* dest, const char* src, size_t len) {
 
 inline bool IsSpecialByte(char c) { return ((unsigned char)(c + 1)) < 2; }
 
-// Return a pointer to the first byte in the range "[start..limit)"
-// whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
-// exists in the range, returns "limit".
-inline const char* SkipToNextSpecialByte(const char* start, const char* limit) {
-  // If these constants were ever changed, this routine needs to change
+// Finding and counting special bytes is the inner loop of both encoding and
+// decoding.  Ranges shorter than one vector are scanned inline, byte by
+// byte; longer ones with the vector kernels of byte_set.h.
+static const ptrdiff_t kMinVectorScan = 16;
+
+static const ByteSet& SpecialBytes() {
+  // If these constants were ever changed, this set needs to change
   DCHECK_EQ(kEscape1, 0);
   DCHECK_EQ(kEscape2 & 0xffu, 255u);
-  const char* p = start;
+  static const ByteSet* const kSpecial =
+      new ByteSet(StringPiece("\0\xff", 2));
+  return *kSpecial;
+}
+
+inline const char* SkipToNextSpecialByte(const char* p, const char* limit) {
+  if (limit - p >= kMinVectorScan) {
+    return FindByteInSet(p, limit, SpecialBytes());
+  }
   while (p < limit && !IsSpecialByte(*p)) {
     p++;
   }
   return p;
 }
 
+inline size_t CountSpecialBytes(const char* p, const char* limit) {
+  if (limit - p >= kMinVectorScan) {
+    return CountBytesInSet(p, limit, SpecialBytes());
+  }
+  size_t n = 0;
+  for (; p < limit; ++p) n += IsSpecialByte(*p);
+  return n;
+}
+
 // Expose SkipToNextSpecialByte for testing purposes
 const char* OrderedCode::TEST_SkipToNextSpecialByte(const char* start,
                                                     const char* limit) {
   return SkipToNextSpecialByte(start, limit);
 }
 
+static const char kEscape1_Null[2] = {kEscape1, kNullCharacter};
+static const char kEscape2_FF[2] = {kEscape2, kFFCharacter};
+
 // Helper routine to encode "s" and append to "*dest", escaping special
-// characters.
-inline static void EncodeStringFragment(string* dest, StringPiece s) {
+// characters, followed by the "suffix_len" bytes at "suffix".  Counts the
+// escapes first so that "*dest" grows at most once.
+inline static void EncodeStringFragment(string* dest, StringPiece s,
+                                        const char* suffix,
+                                        size_t suffix_len) {
   const char* p = s.data();
   const char* limit = p + s.size();
+  const char* first_special = SkipToNextSpecialByte(p, limit);
+  const size_t specials = CountSpecialBytes(first_special, limit);
+  const size_t needed = dest->size() + s.size() + specials + suffix_len;
+  if (needed > dest->capacity()) {
+    // Keep growth geometric for callers appending many strings.
+    dest->reserve(std::max(needed, 2 * dest->capacity()));
+  }
+
   const char* copy_start = p;
-  while (true) {
-    p = SkipToNextSpecialByte(p, limit);
-    if (p >= limit) break;  // No more special characters that need escaping
-    char c = *(p++);
+  p = first_special;
+  while (p < limit) {
+    const char c = *(p++);
     DCHECK(IsSpecialByte(c));
+    AppendBytes(dest, copy_start, p - copy_start - 1);
     if (c == kEscape1) {
-      AppendBytes(dest, copy_start, p - copy_start - 1);
-      dest->push_back(kEscape1);
-      dest->push_back(kNullCharacter);
-      copy_start = p;
+      AppendBytes(dest, kEscape1_Null, 2);
     } else {
       assert(c == kEscape2);
-      AppendBytes(dest, copy_start, p - copy_start - 1);
-      dest->push_back(kEscape2);
-      dest->push_back(kFFCharacter);
-      copy_start = p;
+      AppendBytes(dest, kEscape2_FF, 2);
     }
+    copy_start = p;
+    p = SkipToNextSpecialByte(p, limit);
   }
-  if (p > copy_start) {
-    AppendBytes(dest, copy_start, p - copy_start);
-  }
+  AppendBytes(dest, copy_start, limit - copy_start);
+  AppendBytes(dest, suffix, suffix_len);
 }
 
 void OrderedCode::WriteString(string* dest, StringPiece s) {
-  EncodeStringFragment(dest, s);
-  AppendBytes(dest, kEscape1_Separator, 2);
+  EncodeStringFragment(dest, s, kEscape1_Separator, 2);
 }
 
 void OrderedCode::WriteNumIncreasing(string* dest, uint64_t val) {
@@ -416,10 +448,12 @@ static uint64_t LoadBigEndian64(const char* src) {
   return result;
 }
 
-void OrderedCode::WriteSignedNumIncreasing(string* dest, int64_t val) {
-  const uint64_t x = val < 0 ? ~val : val;
-  if (x < 64) {  // fast path for encoding length == 1
-    *dest += kLengthToHeaderBits[1][0] ^ val;
+// Writes the "len" == SignedEncodingLength(val) bytes encoding "val" at
+// "dst".
+static inline void EncodeSignedNumIncreasing(char* dst, int64_t val,
+                                             int len) {
+  if (len == 1) {
+    dst[0] = kLengthToHeaderBits[1][0] ^ val;
     return;
   }
   // buf = val in network byte order, sign extended to 10 bytes
@@ -429,12 +463,23 @@ void OrderedCode::WriteSignedNumIncreasing(string* dest, int64_t val) {
   };
   StoreBigEndian64(buf + 2, val);
   static_assert(sizeof(buf) == kMaxSigned64Length, "max length size mismatch");
-  const int len = SignedEncodingLength(x);
-  DCHECK_GE(len, 2);
   char* const begin = buf + sizeof(buf) - len;
   begin[0] ^= kLengthToHeaderBits[len][0];
   begin[1] ^= kLengthToHeaderBits[len][1];  // ok because len >= 2
-  dest->append(begin, len);
+  memcpy(dst, begin, len);
+}
+
+void OrderedCode::WriteSignedNumIncreasing(string* dest, int64_t val) {
+  const uint64_t x = val < 0 ? ~val : val;
+  if (x < 64) {  // fast path for encoding length == 1
+    *dest += kLengthToHeaderBits[1][0] ^ val;
+    return;
+  }
+  char buf[kMaxSigned64Length];
+  const int len = SignedEncodingLength(val);
+  DCHECK_GE(len, 2);
+  EncodeSignedNumIncreasing(buf, val, len);
+  dest->append(buf, len);
 }
 
 bool OrderedCode::ReadSignedNumIncreasing(StringPiece* src, int64_t* result) {
@@ -480,5 +525,135 @@ bool OrderedCode::ReadSignedNumIncreasing(StringPiece* src, int64_t* result) {
   return true;
 }
 
+// Length of the WriteNumIncreasing() encoding of "val": a length byte
+// and the value without leading zero bytes.
+static inline int NumIncreasingLength(uint64_t val) {
+  return 1 + (Log2Floor64(val) + 8) / 8;
+}
+
+static inline char* EncodeNumIncreasing(char* dst, uint64_t val) {
+  const int len = NumIncreasingLength(val) - 1;
+  *dst++ = static_cast<char>(len);
+  for (int i = len - 1; i >= 0; --i) *dst++ = (val >> (8 * i)) & 0xff;
+  return dst;
+}
+
+// Like EncodeStringFragment() with the separator as suffix, but into
+// "dst", which has room for the whole encoding.
+static inline char* EncodeString(char* dst, StringPiece s) {
+  const char* p = s.data();
+  const char* limit = p + s.size();
+  const char* copy_start = p;
+  while ((p = SkipToNextSpecialByte(p, limit)) < limit) {
+    const char c = *(p++);
+    memcpy(dst, copy_start, p - copy_start - 1);
+    dst += p - copy_start - 1;
+    *dst++ = c;
+    *dst++ = (c == kEscape1) ? kNullCharacter : kFFCharacter;
+    copy_start = p;
+  }
+  memcpy(dst, copy_start, limit - copy_start);
+  dst += limit - copy_start;
+  *dst++ = kEscape1;
+  *dst++ = kSeparator;
+  return dst;
+}
+
+void OrderedCode::WriteKeys(gtl::ArraySlice<Column> columns, string* dest,
+                            std::vector<size_t>* offsets) {
+  const size_t n = columns.empty() ? 0 : columns[0].size();
+  for (const Column& column : columns) CHECK_EQ(n, column.size());
+
+  // First pass: (*offsets)[i + 1] = encoded size of key i, one column at
+  // a time so each column is read sequentially.
+  offsets->assign(n + 1, 0);
+  size_t* const size = offsets->data() + 1;
+  for (const Column& column : columns) {
+    switch (column.type_) {
+      case Column::kString: {
+        const StringPiece* values =
+            static_cast<const StringPiece*>(column.values_);
+        for (size_t i = 0; i < n; ++i) {
+          const char* p = values[i].data();
+          size[i] += values[i].size() +
+                     CountSpecialBytes(p, p + values[i].size()) + 2;
+        }
+        break;
+      }
+      case Column::kNumIncreasing: {
+        const uint64_t* values = static_cast<const uint64_t*>(column.values_);
+        for (size_t i = 0; i < n; ++i) {
+          size[i] += NumIncreasingLength(values[i]);
+        }
+        break;
+      }
+      case Column::kSignedNumIncreasing: {
+        const int64_t* values = static_cast<const int64_t*>(column.values_);
+        for (size_t i = 0; i < n; ++i) {
+          size[i] += SignedEncodingLength(values[i]);
+        }
+        break;
+      }
+    }
+  }
+  (*offsets)[0] = dest->size();
+  for (size_t i = 0; i < n; ++i) size[i] += (*offsets)[i];
+  dest->resize((*offsets)[n]);
+
+  // Second pass: encode key by key into the space sized above.
+  char* const base = &(*dest)[0];
+  char* p = base + (*offsets)[0];
+  for (size_t i = 0; i < n; ++i) {
+    for (const Column& column : columns) {
+      switch (column.type_) {
+        case Column::kString:
+          p = EncodeString(p,
+                           static_cast<const StringPiece*>(column.values_)[i]);
+          break;
+        case Column::kNumIncreasing:
+          p = EncodeNumIncreasing(
+              p, static_cast<const uint64_t*>(column.values_)[i]);
+          break;
+        case Column::kSignedNumIncreasing: {
+          const int64_t val = static_cast<const int64_t*>(column.values_)[i];
+          const int len = SignedEncodingLength(val);
+          EncodeSignedNumIncreasing(p, val, len);
+          p += len;
+          break;
+        }
+      }
+    }
+    DCHECK_EQ(base + (*offsets)[i + 1], p);
+  }
+}
+
+// Big-endian value of the "n" <= 8 bytes at "p", padded with zero bytes
+// to 8.
+static inline uint64_t LoadBigEndianPrefix(const char* p, size_t n) {
+  if (n >= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+  }
+  char buf[8] = {0};
+  memcpy(buf, p, n);
+  return LoadBigEndian64(buf);
+}
+
+uint64_t OrderedCode::KeyPrefix64(StringPiece key) {
+  return LoadBigEndianPrefix(key.data(), key.size());
+}
+
+void OrderedCode::KeyPrefix128(StringPiece key, uint64_t* high,
+                               uint64_t* low) {
+  *high = LoadBigEndianPrefix(key.data(), key.size());
+  *low = key.size() > 8
+             ? LoadBigEndianPrefix(key.data() + 8, key.size() - 8)
+             : 0;
+}
+
 }  // namespace strings
 }  // namespace tensorflow
@@ -23,15 +23,19 @@
 #ifndef TENSORFLOW_LIB_STRINGS_ORDERED_CODE_H__
 #define TENSORFLOW_LIB_STRINGS_ORDERED_CODE_H__
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
+#include <vector>
 
+#include "core/base/array_slice.h"
 #include "core/base/macros.h"
+#include "core/strings/string_piece.h"
 
 using std::string;
 
 namespace mr {
-class StringPiece;
-
 namespace strings {
 
 class OrderedCode {
@@ -44,6 +48,45 @@ class OrderedCode {
   static void WriteNumIncreasing(string* dest, uint64_t num);
   static void WriteSignedNumIncreasing(string* dest, int64_t num);
 
+  // -------------------------------------------------------------------
+  // Batch encoding of composite keys stored column by column.  A Column
+  // refers to (does not copy) one value per key, all encoded with the
+  // same routine; the caller keeps the values alive during WriteKeys().
+  class Column {
+   public:
+    static Column Strings(gtl::ArraySlice<StringPiece> values) {
+      return Column(kString, values.data(), values.size());
+    }
+    static Column NumIncreasing(gtl::ArraySlice<uint64_t> values) {
+      return Column(kNumIncreasing, values.data(), values.size());
+    }
+    static Column SignedNumIncreasing(gtl::ArraySlice<int64_t> values) {
+      return Column(kSignedNumIncreasing, values.data(), values.size());
+    }
+
+    size_t size() const { return size_; }
+
+   private:
+    friend class OrderedCode;
+    enum Type { kString, kNumIncreasing, kSignedNumIncreasing };
+
+    Column(Type type, const void* values, size_t size)
+        : type_(type), values_(values), size_(size) {}
+
+    Type type_;
+    const void* values_;
+    size_t size_;
+  };
+
+  // Appends N keys to "*dest", where N is the size of every column, and
+  // key i is what writing row i of each column in order with the
+  // routines above would produce.  Key i occupies bytes
+  // [(*offsets)[i], (*offsets)[i + 1]) of "*dest"; "*offsets" is
+  // replaced with N + 1 offsets.  Sizes every key first, so "*dest" is
+  // resized once and no per-key strings are built.
+  static void WriteKeys(gtl::ArraySlice<Column> columns, string* dest,
+                        std::vector<size_t>* offsets);
+
   // -------------------------------------------------------------------
   // Decoding routines: these extract an item earlier encoded using
   // the corresponding WriteXXX() routines above.  The item is read
@@ -56,6 +99,18 @@ class OrderedCode {
   static bool ReadNumIncreasing(StringPiece* src, uint64_t* result);
   static bool ReadSignedNumIncreasing(StringPiece* src, int64_t* result);
 
+  // -------------------------------------------------------------------
+  // Normalized-key prefixes: the first 8 (or 16) bytes of "key",
+  // zero-padded, as a big-endian integer.  Works for any byte string,
+  // including keys built with the routines above.  A smaller prefix means
+  // a smaller key, so sorts can compare prefixes, which fit in the sort
+  // entries, and look at the full keys only when the prefixes are equal.
+  // Equal prefixes with one key at most 8 (or 16) bytes long mean the
+  // shorter key is the smaller one.
+  static uint64_t KeyPrefix64(StringPiece key);
+  // Bytes [0, 8) go to "*high" and bytes [8, 16) to "*low".
+  static void KeyPrefix128(StringPiece key, uint64_t* high, uint64_t* low);
+
   // Helper for testing: corrupt "*str" by changing the kth item separator
   // in the string.
   static void TEST_Corrupt(string* str, int k);
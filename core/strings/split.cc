@@ -0,0 +1,20 @@
+#include "core/strings/split.h"
+
+namespace mr {
+namespace str_util {
+
+const char* ByString::Find(const char* p, const char* limit) const {
+  const size_t n = delim_.size();
+  const char first = delim_[0];
+  while (limit - p >= static_cast<ptrdiff_t>(n)) {
+    const void* d = memchr(p, first, limit - p - n + 1);
+    if (d == nullptr) break;
+    p = static_cast<const char*>(d);
+    if (memcmp(p + 1, delim_.data() + 1, n - 1) == 0) return p;
+    ++p;
+  }
+  return limit;
+}
+
+}  // namespace str_util
+}  // namespace mr
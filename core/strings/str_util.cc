@@ -1,8 +1,16 @@
 #include "core/strings/str_util.h"
 
 #include <ctype.h>
+#include <string.h>
 #include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "core/base/stl_util.h"
 #include "core/strings/numbers.h"
+#include "core/strings/split.h"
 #include "core/strings/stringprintf.h"
 
 namespace mr {
@@ -10,48 +18,89 @@ namespace str_util {
 
 static char hex_char[] = "0123456789abcdef";
 
-string CEscape(const string& src) {
-  string dest;
+namespace {  // Private helpers for CEscape().
 
-  for (unsigned char c : src) {
-    switch (c) {
-      case '\n':
-        dest.append("\\n");
-        break;
-      case '\r':
-        dest.append("\\r");
-        break;
-      case '\t':
-        dest.append("\\t");
-        break;
-      case '\"':
-        dest.append("\\\"");
-        break;
-      case '\'':
-        dest.append("\\'");
-        break;
-      case '\\':
-        dest.append("\\\\");
-        break;
-      default:
-        // Note that if we emit \xNN and the src character after that is a hex
-        // digit then that digit must be escaped too to prevent it being
-        // interpreted as part of the character code by C.
-        if ((c >= 0x80) || !isprint(c)) {
-          dest.append("\\");
-          dest.push_back(hex_char[c / 64]);
-          dest.push_back(hex_char[(c % 64) / 8]);
-          dest.push_back(hex_char[c % 8]);
-        } else {
-          dest.push_back(c);
-          break;
-        }
-    }
+inline bool NeedsCEscape(unsigned char c) {
+  return c < ' ' || c >= 0x7f || c == '\"' || c == '\'' || c == '\\';
+}
+
+// Returns the first character in [p, end) that CEscape() escapes, or end.
+const char* FindCEscapeChar(const char* p, const char* end) {
+#if defined(__SSE2__)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i double_quote = _mm_set1_epi8('\"');
+  const __m128i single_quote = _mm_set1_epi8('\'');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; end - p >= 16; p += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // Bytes from 0x80 up are negative, so the signed compare against ' '
+    // finds them along with the control characters.
+    const __m128i escaped = _mm_or_si128(
+        _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del)),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, double_quote),
+                                  _mm_cmpeq_epi8(v, single_quote)),
+                     _mm_cmpeq_epi8(v, backslash)));
+    const int mask = _mm_movemask_epi8(escaped);
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+#endif
+  for (; p < end; ++p) {
+    if (NeedsCEscape(*p)) return p;
+  }
+  return end;
+}
+
+void AppendCEscapedChar(unsigned char c, string* dest) {
+  switch (c) {
+    case '\n':
+      dest->append("\\n");
+      break;
+    case '\r':
+      dest->append("\\r");
+      break;
+    case '\t':
+      dest->append("\\t");
+      break;
+    case '\"':
+      dest->append("\\\"");
+      break;
+    case '\'':
+      dest->append("\\'");
+      break;
+    case '\\':
+      dest->append("\\\\");
+      break;
+    default:
+      // Octal rather than \xNN, which would swallow a hex digit after it.
+      const char octal[4] = {'\\', hex_char[c / 64], hex_char[(c % 64) / 8],
+                             hex_char[c % 8]};
+      dest->append(octal, 4);
   }
+}
+
+}  // namespace
 
+string CEscape(StringPiece src) {
+  string dest;
+  CEscapeAndAppend(src, &dest);
   return dest;
 }
 
+void CEscapeAndAppend(StringPiece src, string* dest) {
+  const char* p = src.data();
+  const char* const end = p + src.size();
+  // Enough when little needs escaping, the common case.
+  dest->reserve(dest->size() + src.size());
+  while (true) {
+    const char* const escaped = FindCEscapeChar(p, end);
+    dest->append(p, escaped - p);
+    if (escaped == end) break;
+    AppendCEscapedChar(*escaped, dest);
+    p = escaped + 1;
+  }
+}
+
 namespace {  // Private helpers for CUnescape().
 
 inline bool is_octal_digit(unsigned char c) { return c >= '0' && c <= '7'; }
@@ -76,13 +125,16 @@ bool CUnescapeInternal(StringPiece source, char* dest,
   const char* end = source.end();
   const char* last_byte = end - 1;
 
-  // Small optimization for case where source = dest and there's no escaping
-  while (p == d && p < end && *p != '\\') p++, d++;
-
   while (p < end) {
-    if (*p != '\\') {
-      *d++ = *p++;
-    } else {
+    // Copy the run up to the next backslash at once; in place, a run
+    // before the first escape stays where it is.
+    const void* found = memchr(p, '\\', end - p);
+    const char* const run_end =
+        found != nullptr ? static_cast<const char*>(found) : end;
+    if (d != p) memmove(d, p, run_end - p);
+    d += run_end - p;
+    p = run_end;
+    if (p < end) {
       if (++p > last_byte) {  // skip past the '\\'
         if (error) *error = "String cannot end with \\";
         return false;
@@ -184,7 +236,7 @@ bool CUnescapeInternal(StringPiece source, char* dest,
 }  // namespace
 
 bool CUnescape(StringPiece source, string* dest, string* error) {
-  dest->resize(source.size());
+  gtl::STLStringResizeUninitialized(dest, source.size());
   string::size_type dest_size;
   if (!CUnescapeInternal(source, const_cast<char*>(dest->data()), &dest_size,
                          error)) {
@@ -194,6 +246,15 @@ bool CUnescape(StringPiece source, string* dest, string* error) {
   return true;
 }
 
+bool CUnescapeInPlace(string* s, string* error) {
+  string::size_type size;
+  if (!CUnescapeInternal(*s, const_cast<char*>(s->data()), &size, error)) {
+    return false;
+  }
+  s->erase(size);
+  return true;
+}
+
 void StripTrailingWhitespace(string* s) {
   string::size_type i;
   for (i = s->size(); i > 0 && isspace((*s)[i - 1]); --i) {
@@ -201,22 +262,63 @@ void StripTrailingWhitespace(string* s) {
   s->resize(i);
 }
 
-// Return lower-cased version of s.
-string Lowercase(StringPiece s) {
-  string result(s.data(), s.size());
-  for (char& c : result) {
-    c = tolower(c);
+namespace {
+
+// Flips the case of the 26 ASCII letters starting at "first" as it copies
+// "size" characters from "src" to "dest", which may be the same.
+void FlipCase(const char* src, size_t size, char first, char* dest) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Adding 0x80 - first maps the letters, and only them, to the 26 smallest
+  // signed bytes.
+  const __m128i shift = _mm_set1_epi8(static_cast<char>(0x80 - first));
+  const __m128i limit = _mm_set1_epi8(static_cast<char>(0x80 + 26));
+  const __m128i flip = _mm_set1_epi8(0x20);
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i letters = _mm_cmplt_epi8(_mm_add_epi8(v, shift), limit);
+    if (src == dest && _mm_movemask_epi8(letters) == 0) continue;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_xor_si128(v, _mm_and_si128(letters, flip)));
+  }
+#endif
+  for (; i < size; ++i) {
+    const char c = src[i];
+    dest[i] = static_cast<unsigned char>(c - first) < 26 ? c ^ 0x20 : c;
   }
+}
+
+string FlipCase(StringPiece s, char first) {
+  string result;
+  gtl::STLStringResizeUninitialized(&result, s.size());
+  FlipCase(s.data(), s.size(), first, &result[0]);
   return result;
 }
 
+}  // namespace
+
+// Return lower-cased version of s.
+string Lowercase(StringPiece s) { return FlipCase(s, 'A'); }
+
 // Return upper-cased version of s.
-string Uppercase(StringPiece s) {
-  string result(s.data(), s.size());
-  for (char& c : result) {
-    c = toupper(c);
-  }
-  return result;
+string Uppercase(StringPiece s) { return FlipCase(s, 'a'); }
+
+void LowercaseInPlace(string* s) {
+  FlipCase(s->data(), s->size(), 'A', &(*s)[0]);
+}
+
+void UppercaseInPlace(string* s) {
+  FlipCase(s->data(), s->size(), 'a', &(*s)[0]);
+}
+
+char* LowercaseToBuffer(StringPiece s, char* buffer) {
+  FlipCase(s.data(), s.size(), 'A', buffer);
+  return buffer + s.size();
+}
+
+char* UppercaseToBuffer(StringPiece s, char* buffer) {
+  FlipCase(s.data(), s.size(), 'a', buffer);
+  return buffer + s.size();
 }
 
 void TitlecaseString(string* s, StringPiece delimiters) {
@@ -311,8 +413,7 @@ bool ConsumeNonWhitespace(StringPiece* s, StringPiece* val) {
 bool SplitAndParseAsInts(StringPiece text, char delim,
                          std::vector<int32_t>* result) {
   result->clear();
-  std::vector<string> num_strings = Split(text, delim);
-  for (const auto& s : num_strings) {
+  for (StringPiece s : SplitPieces(text, delim)) {
     int32_t num;
     if (!strings::safe_strto32(s, &num)) return false;
     result->push_back(num);
@@ -16,7 +16,13 @@ namespace str_util {
 
 // Returns a version of 'src' where unprintable characters have been
 // escaped using C-style escape sequences.
-string CEscape(const string& src);
+//
+// Runs of characters that need no escaping are found 16 at a time and
+// copied whole.
+string CEscape(StringPiece src);
+
+// Appends CEscape(src) to "*dest".
+void CEscapeAndAppend(StringPiece src, string* dest);
 
 // Copies "source" to "dest", rewriting C-style escape sequences --
 // '\n', '\r', '\\', '\ooo', etc -- to their ASCII equivalents.
@@ -27,6 +33,10 @@ string CEscape(const string& src);
 // NOTE: Does not support \u or \U!
 bool CUnescape(StringPiece source, string* dest, string* error);
 
+// Like CUnescape(), but rewrites "*s" itself, which never grows.  On error
+// "*s" is left partly unescaped.
+bool CUnescapeInPlace(string* s, string* error);
+
 // Removes any trailing whitespace from "*s".
 void StripTrailingWhitespace(string* s);
 
@@ -58,11 +68,25 @@ bool ConsumeNonWhitespace(StringPiece* s, StringPiece* val);
 bool ConsumePrefix(StringPiece* s, StringPiece expected);
 
 // Return lower-cased version of s.
+//
+// Only ASCII letters change case, as with tolower() in the "C" locale.  On
+// x86 16 characters are converted at a time.
 string Lowercase(StringPiece s);
 
 // Return upper-cased version of s.
 string Uppercase(StringPiece s);
 
+// Change the case of "*s" itself.  Vectors of characters without letters to
+// change are not written back.
+void LowercaseInPlace(string* s);
+void UppercaseInPlace(string* s);
+
+// Write the s.size() characters of Lowercase(s) or Uppercase(s) to
+// "buffer", without a terminating NUL, and return the position after them.
+// "buffer" may be s.data().
+char* LowercaseToBuffer(StringPiece s, char* buffer);
+char* UppercaseToBuffer(StringPiece s, char* buffer);
+
 // Capitalize first character of each word in "*s".  "delimiters" is a
 // set of characters that can be used as word boundaries.
 void TitlecaseString(string* s, StringPiece delimiters);
@@ -1,6 +1,7 @@
 #include "core/strings/strcat.h"
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -14,21 +15,47 @@ namespace strings {
 
 AlphaNum gEmptyAlphaNum("");
 
+// Widens the number that starts at "begin" by writing "fill" before it
+// until it is "width" wide, and returns its new start.
+static char *PadLeft(char *begin, char *end, ptrdiff_t width, char fill) {
+  while (end - begin < width) *--begin = fill;
+  return begin;
+}
+
+static ptrdiff_t PadWidth(PadSpec spec) {
+  return spec >= SPACE_PAD_2 ? spec - SPACE_PAD_2 + 2 : spec;
+}
+
 AlphaNum::AlphaNum(Hex hex) {
   char *const end = &digits_[kFastToBufferSize];
   char *writer = end;
   uint64_t value = hex.value;
-  uint64_t width = hex.spec;
-  // We accomplish minimum width by OR'ing in 0x10000 to the user's value,
-  // where 0x10000 is the smallest hex number that is as wide as the user
-  // asked for.
-  uint64_t mask = ((static_cast<uint64_t>(1) << (width - 1) * 4)) | value;
   static const char hexdigits[] = "0123456789abcdef";
   do {
     *--writer = hexdigits[value & 0xF];
     value >>= 4;
-    mask >>= 4;
-  } while (mask != 0);
+  } while (value != 0);
+  writer = PadLeft(writer, end, PadWidth(hex.spec),
+                   hex.spec >= SPACE_PAD_2 ? ' ' : '0');
+  piece_.set(writer, end - writer);
+}
+
+AlphaNum::AlphaNum(Dec dec) {
+  char *const end = &digits_[kFastToBufferSize];
+  char *writer = end;
+  uint64_t value = dec.value;
+  do {
+    *--writer = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  const ptrdiff_t width = PadWidth(dec.spec);
+  if (dec.spec >= SPACE_PAD_2) {
+    if (dec.neg) *--writer = '-';
+    writer = PadLeft(writer, end, width, ' ');
+  } else {
+    writer = PadLeft(writer, end, width - dec.neg, '0');
+    if (dec.neg) *--writer = '-';
+  }
   piece_.set(writer, end - writer);
 }
 
@@ -29,6 +29,22 @@ enum PadSpec {
   ZERO_PAD_14,
   ZERO_PAD_15,
   ZERO_PAD_16,
+
+  SPACE_PAD_2,
+  SPACE_PAD_3,
+  SPACE_PAD_4,
+  SPACE_PAD_5,
+  SPACE_PAD_6,
+  SPACE_PAD_7,
+  SPACE_PAD_8,
+  SPACE_PAD_9,
+  SPACE_PAD_10,
+  SPACE_PAD_11,
+  SPACE_PAD_12,
+  SPACE_PAD_13,
+  SPACE_PAD_14,
+  SPACE_PAD_15,
+  SPACE_PAD_16,
 };
 
 struct Hex {
@@ -49,6 +65,25 @@ struct Hex {
   }
 };
 
+// Formats an integer in decimal, padded on the left to the width "spec"
+// asks for, e.g. StrCat(Dec(7, ZERO_PAD_3)) is "007" and
+// StrCat(Dec(-7, SPACE_PAD_4)) is "  -7".  The sign counts toward the width
+// and goes before zero padding: Dec(-7, ZERO_PAD_3) is "-07".
+struct Dec {
+  uint64_t value;
+  enum PadSpec spec;
+  bool neg;
+  template <class Int>
+  explicit Dec(Int v, PadSpec s = NO_PAD)
+      : spec(s), neg(v < 0) {
+    static_assert(
+        sizeof(v) == 1 || sizeof(v) == 2 || sizeof(v) == 4 || sizeof(v) == 8,
+        "Unknown integer type");
+    // Negate in unsigned arithmetic so the minimum value works.
+    value = neg ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+  }
+};
+
 class AlphaNum {
  public:
   // No bool ctor -- bools convert to an integral type.
@@ -73,6 +108,7 @@ class AlphaNum {
       : piece_(digits_, strlen(DoubleToBuffer(f, digits_))) {}
 
   AlphaNum(Hex hex);  // NOLINT(runtime/explicit)
+  AlphaNum(Dec dec);  // NOLINT(runtime/explicit)
 
   AlphaNum(const char *c_str) : piece_(c_str) {}   // NOLINT(runtime/explicit)
   AlphaNum(const StringPiece &pc) : piece_(pc) {}  // NOLINT(runtime/explicit)
@@ -163,10 +199,11 @@ string StrCat(const AlphaNum &a, const AlphaNum &b, const AlphaNum &c,
 //    string s = "foo";
 //    StrAppend(&s, s);
 //
-//    Note: while StrCat supports appending up to 26 arguments, StrAppend
-//    is currently limited to 9.  That's rarely an issue except when
-//    automatically transforming StrCat to StrAppend, and can easily be
-//    worked around as consecutive calls to StrAppend are quite efficient.
+//    Like StrCat, StrAppend takes any number of arguments and grows
+//    "dest" once for all of them, so one call with many pieces beats a
+//    sequence of calls.  To build many short-lived strings, such as keys
+//    or log lines, without a heap allocation each, see StringBuilder in
+//    string_builder.h.
 // ----------------------------------------------------------------------
 
 void StrAppend(string *dest, const AlphaNum &a);
@@ -0,0 +1,26 @@
+#include "core/strings/string_builder.h"
+
+#include <algorithm>
+
+namespace mr {
+namespace strings {
+
+// Room for a typical key without a second buffer.
+static const size_t kMinCapacity = 32;
+
+StringBuilder::StringBuilder(Arena* arena, size_t capacity) : arena_(arena) {
+  if (capacity > 0) Grow(capacity);
+}
+
+void StringBuilder::Grow(size_t min_capacity) {
+  const size_t capacity =
+      std::max(min_capacity, std::max(2 * capacity_, kMinCapacity));
+  // Characters need no alignment, which saves the padding.
+  char* const data = arena_->AllocAligned(capacity, 1);
+  if (size_ > 0) memcpy(data, data_, size_);
+  data_ = data;
+  capacity_ = capacity;
+}
+
+}  // namespace strings
+}  // namespace mr
@@ -0,0 +1,105 @@
+// StringBuilder concatenates strings and numbers into memory from an Arena.
+//
+// Each StrCat() result is a heap allocation, which dominates the cost of
+// the many short-lived strings a task builds on its hot path: shuffle keys,
+// file names, log lines.  A StringBuilder writes into a buffer carved out
+// of a caller-owned Arena instead, and the arena takes all of them back at
+// once on Reset():
+//
+//   Arena arena(8192);
+//   for (const Record& r : records) {
+//     StringBuilder key(&arena);
+//     key.Append(r.table(), "/", Hex(r.id(), ZERO_PAD_16), "/", r.shard());
+//     Emit(key.piece());
+//     if (arena.BytesAllocated() > kMaxScratch) arena.Reset();
+//   }
+//
+// Append() takes any mix of arguments StrCat() accepts, padding directives
+// included, and sizes the buffer once per call.  When the buffer is full it
+// moves to one twice as large; the old one stays in the arena until
+// Reset(), so pass an initial capacity when the size is known.
+//
+// The builder and its piece() must not outlive the arena or survive its
+// Reset().  Like StrAppend, Append() must not be passed pieces of the
+// builder's own contents.
+
+#ifndef CORE_STRINGS_STRING_BUILDER_H_
+#define CORE_STRINGS_STRING_BUILDER_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <initializer_list>
+#include <string>
+
+#include "core/base/arena.h"
+#include "core/base/macros.h"
+#include "core/strings/strcat.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+namespace strings {
+
+class StringBuilder {
+ public:
+  // Does not take ownership of "arena".  Nothing is allocated until the
+  // first Append() unless "capacity" is nonzero.
+  explicit StringBuilder(Arena* arena, size_t capacity = 0);
+
+  template <typename... AV>
+  StringBuilder& Append(const AlphaNum& a, const AV&... args) {
+    AppendPieces({a.Piece(), static_cast<const AlphaNum&>(args).Piece()...});
+    return *this;
+  }
+
+  void push_back(char c) {
+    if (PREDICT_FALSE(size_ == capacity_)) Grow(size_ + 1);
+    data_[size_++] = c;
+  }
+
+  // Keeps the buffer for the next string.
+  void clear() { size_ = 0; }
+
+  // Drops characters from the end.
+  void Truncate(size_t size) {
+    DCHECK_LE(size, size_);
+    size_ = size;
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return capacity_; }
+
+  // Valid until the next Append() or push_back() that grows the buffer.
+  StringPiece piece() const { return StringPiece(data_, size_); }
+  string ToString() const { return string(data_, size_); }
+
+ private:
+  void AppendPieces(std::initializer_list<StringPiece> pieces) {
+    size_t total_size = size_;
+    for (const StringPiece piece : pieces) total_size += piece.size();
+    if (PREDICT_FALSE(total_size > capacity_)) Grow(total_size);
+    char* out = data_ + size_;
+    for (const StringPiece piece : pieces) {
+      memcpy(out, piece.data(), piece.size());
+      out += piece.size();
+    }
+    size_ = total_size;
+  }
+
+  // Moves the contents to a buffer of at least "min_capacity" bytes.
+  void Grow(size_t min_capacity);
+
+  Arena* const arena_;
+  char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(StringBuilder);
+};
+
+}  // namespace strings
+}  // namespace mr
+
+#endif  // CORE_STRINGS_STRING_BUILDER_H_
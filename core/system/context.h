@@ -1,26 +1,59 @@
 #ifndef CORE_SYSTEM_CONTEXT_H_
 #define CORE_SYSTEM_CONTEXT_H_
 
-namespace mr {
+#include <stdint.h>
 
+namespace mr {
 
 enum class ContextKind {
+  // Initial state with default (empty) values.
   kDefault,
+  // Initial state inherited from the creating or scheduling thread.
   kThread,
 };
 
+// Context is a container for request-specific information that should be
+// passed to threads that perform related work.  A thread pool captures the
+// Context of the thread calling Schedule() and installs it, with
+// WithContext, on the worker that runs the closure.  For now it carries
+// the trace id of the activity (see port::Tracing) that was running when
+// the work was scheduled, which links a closure to its parent in traces.
 class Context {
  public:
   Context() {}
-  Context(const ContextKind kind) { (void)kind; }
+  explicit Context(const ContextKind kind) {
+    if (kind == ContextKind::kThread) *this = *Current();
+  }
+
+  // Id of the traced activity this context belongs to; 0 if none.
+  uint64_t trace_id() const { return trace_id_; }
+  void set_trace_id(uint64_t trace_id) { trace_id_ = trace_id; }
+
+  // The context of the calling thread.
+  static Context* Current() {
+    static thread_local Context current;
+    return &current;
+  }
+
+ private:
+  uint64_t trace_id_ = 0;
 };
-  
+
+// Installs "x" as the context of the calling thread for the lifetime of
+// the WithContext, restoring the previous one afterwards.
 class WithContext {
  public:
-  explicit WithContext(const Context& x) {(void)x; }
-  ~WithContext() {}
-};
+  explicit WithContext(const Context& x) : saved_(*Context::Current()) {
+    *Context::Current() = x;
+  }
+  ~WithContext() { *Context::Current() = saved_; }
 
+ private:
+  const Context saved_;
+
+  WithContext(const WithContext&) = delete;
+  void operator=(const WithContext&) = delete;
+};
 
-}
+}  // namespace mr
 #endif // CORE_SYSTEM_CONTEXT_H_
@@ -145,6 +145,8 @@ class Thread {
 struct ThreadOptions {
   size_t stack_size = 0;
   size_t guard_size = 0;
+  // CPUs the thread may run on; empty means any.
+  std::vector<int> cpu_affinity;
 };
 
 Status ReadFileToString(Env* env, const string& fname, string* data);
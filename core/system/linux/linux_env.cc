@@ -1,7 +1,9 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -22,13 +24,29 @@ namespace mr {
 
 namespace {
 
+// Restricts the calling thread to "cpus".
+void SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    LOG(WARNING) << "sched_setaffinity failed: " << strerror(errno);
+  }
+}
+
 class StdThread : public Thread {
  public:
-  // name and thread_options are both ignored.
+  // name, stack_size and guard_size are ignored.
   StdThread(const ThreadOptions& thread_options, const string& name,
             std::function<void()> fn)
-      : thread_(fn) {
-    (void) thread_options;
+      : thread_(thread_options.cpu_affinity.empty()
+                    ? std::thread(fn)
+                    : std::thread([thread_options, fn]() {
+                        SetCurrentThreadAffinity(thread_options.cpu_affinity);
+                        fn();
+                      })) {
     (void) name;
   }
   ~StdThread() { thread_.join(); }
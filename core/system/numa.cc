@@ -0,0 +1,147 @@
+#include "core/system/numa.h"
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "core/base/logging.h"
+#include "core/strings/numbers.h"
+#include "core/strings/split.h"
+#include "core/strings/str_util.h"
+
+namespace mr {
+
+namespace {
+
+static const char kSysNodeDir[] = "/sys/devices/system/node";
+
+bool ReadSmallFile(const std::string& fname, std::string* contents) {
+  FILE* f = fopen(fname.c_str(), "r");
+  if (f == nullptr) return false;
+  contents->clear();
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) contents->append(buf, n);
+  fclose(f);
+  return true;
+}
+
+// Parses the "Node N MemTotal: X kB" line of a node's meminfo.
+int64_t ParseMemTotal(StringPiece meminfo) {
+  for (StringPiece rest : str_util::SplitPieces(meminfo, '\n')) {
+    const size_t pos = rest.find("MemTotal:");
+    if (pos == StringPiece::npos) continue;
+    rest.remove_prefix(pos + strlen("MemTotal:"));
+    str_util::RemoveLeadingWhitespace(&rest);
+    uint64_t kb;
+    if (str_util::ConsumeLeadingDigits(&rest, &kb)) {
+      return static_cast<int64_t>(kb) << 10;
+    }
+  }
+  return 0;
+}
+
+// CPUs in the affinity mask of this process.
+std::vector<int> UsableCpus() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long cpu = 0; cpu < std::max(n, 1L); ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+  }
+  return cpus;
+}
+
+std::vector<NumaNode> ReadNumaNodes(const std::string& dir,
+                                    const std::vector<int>* usable) {
+  std::vector<NumaNode> nodes;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) return nodes;
+  while (struct dirent* entry = readdir(d)) {
+    StringPiece name(entry->d_name);
+    int32_t id;
+    if (!str_util::ConsumePrefix(&name, "node") ||
+        !strings::safe_strto32(name, &id)) {
+      continue;
+    }
+    const std::string node_dir = dir + "/" + entry->d_name;
+    std::string contents;
+    NumaNode node;
+    node.id = id;
+    if (!ReadSmallFile(node_dir + "/cpulist", &contents) ||
+        !ParseCpuList(contents, &node.cpus)) {
+      continue;
+    }
+    if (usable != nullptr) {
+      std::vector<int> cpus;
+      std::set_intersection(node.cpus.begin(), node.cpus.end(),
+                            usable->begin(), usable->end(),
+                            std::back_inserter(cpus));
+      node.cpus.swap(cpus);
+    }
+    if (node.cpus.empty()) continue;
+    if (ReadSmallFile(node_dir + "/meminfo", &contents)) {
+      node.memory_bytes = ParseMemTotal(contents);
+    }
+    nodes.push_back(node);
+  }
+  closedir(d);
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+  return nodes;
+}
+
+}  // namespace
+
+bool ParseCpuList(StringPiece list, std::vector<int>* cpus) {
+  cpus->clear();
+  str_util::RemoveWhitespaceContext(&list);
+  if (list.empty()) return true;
+  for (StringPiece piece : str_util::SplitPieces(list, ',')) {
+    uint64_t first, last;
+    if (!str_util::ConsumeLeadingDigits(&piece, &first)) return false;
+    last = first;
+    if (str_util::ConsumePrefix(&piece, "-") &&
+        !str_util::ConsumeLeadingDigits(&piece, &last)) {
+      return false;
+    }
+    if (!piece.empty() || last < first || last >= (1 << 20)) return false;
+    for (uint64_t cpu = first; cpu <= last; ++cpu) {
+      cpus->push_back(static_cast<int>(cpu));
+    }
+  }
+  std::sort(cpus->begin(), cpus->end());
+  cpus->erase(std::unique(cpus->begin(), cpus->end()), cpus->end());
+  return true;
+}
+
+std::vector<NumaNode> GetNumaNodes(const std::string& sys_node_dir) {
+  return ReadNumaNodes(sys_node_dir, nullptr);
+}
+
+std::vector<NumaNode> GetNumaNodes() {
+  const std::vector<int> usable = UsableCpus();
+  std::vector<NumaNode> nodes = ReadNumaNodes(kSysNodeDir, &usable);
+  if (nodes.empty()) {
+    NumaNode node;
+    node.cpus = usable;
+    node.memory_bytes = static_cast<int64_t>(sysconf(_SC_PHYS_PAGES)) *
+                        sysconf(_SC_PAGESIZE);
+    nodes.push_back(node);
+  }
+  return nodes;
+}
+
+}  // namespace mr
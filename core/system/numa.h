@@ -0,0 +1,37 @@
+// Discovers the NUMA layout of the local machine from
+// /sys/devices/system/node.
+
+#ifndef MR_CORE_SYSTEM_NUMA_H_
+#define MR_CORE_SYSTEM_NUMA_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "core/strings/string_piece.h"
+
+namespace mr {
+
+struct NumaNode {
+  int id = 0;
+  // CPUs of this node that the process may run on, ascending.
+  std::vector<int> cpus;
+  // MemTotal of the node; 0 if unknown.
+  int64_t memory_bytes = 0;
+};
+
+// Returns the NUMA nodes that have at least one usable CPU, ordered by id.
+// Machines without NUMA information in /sys are reported as a single node
+// 0 holding every usable CPU and all physical memory.
+std::vector<NumaNode> GetNumaNodes();
+
+// Same, reading the node directories under "sys_node_dir" instead of
+// /sys/devices/system/node and ignoring the process affinity mask.
+std::vector<NumaNode> GetNumaNodes(const std::string& sys_node_dir);
+
+// Parses a kernel cpulist such as "0-3,8,10-11" into "*cpus".
+bool ParseCpuList(StringPiece list, std::vector<int>* cpus);
+
+}  // namespace mr
+#endif  // MR_CORE_SYSTEM_NUMA_H_
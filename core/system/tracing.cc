@@ -0,0 +1,213 @@
+#include "core/system/tracing.h"
+
+#include <stdarg.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "core/strings/stringprintf.h"
+#include "core/system/env.h"
+
+namespace mr {
+namespace port {
+
+namespace {
+
+uint64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Event {
+  uint64_t start_nanos;
+  uint64_t end_nanos;  // Equal to start_nanos for point events.
+  uint64_t id;
+  uint64_t parent;
+  Tracing::EventCategory category;
+  bool scoped;
+};
+
+// The ring buffer of one thread.  Only that thread writes it.
+struct ThreadBuffer {
+  explicit ThreadBuffer(int tid) : tid(tid), next(0) {}
+
+  void Append(const Event& e) {
+    const uint64_t n = next.load(std::memory_order_relaxed);
+    events[n % Tracing::kEventsPerThread] = e;
+    next.store(n + 1, std::memory_order_release);
+  }
+
+  const int tid;
+  // Number of events ever appended; the last kEventsPerThread are kept.
+  std::atomic<uint64_t> next;
+  Event events[Tracing::kEventsPerThread];
+};
+
+// Buffers outlive their threads so that their events can be exported
+// later.  A thread that exits puts its buffer on the free list, and the
+// next new thread reuses it, so short-lived threads do not add up.
+struct Registry {
+  std::mutex mu;
+  std::vector<ThreadBuffer*> buffers;
+  std::vector<ThreadBuffer*> free_buffers;
+  uint64_t start_nanos = 0;
+};
+
+Registry* GetRegistry() {
+  static Registry* registry = new Registry;
+  return registry;
+}
+
+// Returns the buffer of its thread to the Registry when the thread exits.
+struct BufferOwner {
+  ~BufferOwner() {
+    if (buffer == nullptr) return;
+    Registry* r = GetRegistry();
+    std::lock_guard<std::mutex> l(r->mu);
+    r->free_buffers.push_back(buffer);
+  }
+
+  ThreadBuffer* buffer = nullptr;
+};
+
+ThreadBuffer* GetThreadBuffer() {
+  static thread_local BufferOwner owner;
+  if (PREDICT_FALSE(owner.buffer == nullptr)) {
+    Registry* r = GetRegistry();
+    std::lock_guard<std::mutex> l(r->mu);
+    if (!r->free_buffers.empty()) {
+      owner.buffer = r->free_buffers.back();
+      r->free_buffers.pop_back();
+    } else {
+      owner.buffer = new ThreadBuffer(static_cast<int>(r->buffers.size()) + 1);
+      r->buffers.push_back(owner.buffer);
+    }
+  }
+  return owner.buffer;
+}
+
+void AppendEvent(std::string* out, bool* first, const char* fmt, ...)
+    PRINTF_ATTRIBUTE(3, 4);
+
+void AppendEvent(std::string* out, bool* first, const char* fmt, ...) {
+  if (!*first) out->append(",\n");
+  *first = false;
+  va_list ap;
+  va_start(ap, fmt);
+  strings::Appendv(out, fmt, ap);
+  va_end(ap);
+}
+
+}  // namespace
+
+std::atomic<bool> Tracing::active_(false);
+std::atomic<uint64_t> Tracing::next_id_(1);
+const int Tracing::kEventsPerThread;
+
+const char* Tracing::EventCategoryString(EventCategory category) {
+  switch (category) {
+    case EventCategory::kScheduleClosure:
+      return "ScheduleClosure";
+    case EventCategory::kRunClosure:
+      return "RunClosure";
+  }
+  return "Unknown";
+}
+
+void Tracing::Start() {
+  Registry* r = GetRegistry();
+  std::lock_guard<std::mutex> l(r->mu);
+  for (ThreadBuffer* b : r->buffers) b->next.store(0);
+  r->start_nanos = NowNanos();
+  active_.store(true);
+}
+
+void Tracing::Stop() { active_.store(false); }
+
+void Tracing::RecordEvent(EventCategory category, uint64_t id) {
+  if (!IsActive()) return;
+  const uint64_t now = NowNanos();
+  GetThreadBuffer()->Append(
+      Event{now, now, id, Context::Current()->trace_id(), category, false});
+}
+
+Tracing::ScopedActivity::ScopedActivity(EventCategory category, uint64_t id)
+    : category_(category), id_(id), parent_(0), start_nanos_(0) {
+  if (!IsActive()) return;
+  Context* context = Context::Current();
+  parent_ = context->trace_id();
+  context->set_trace_id(id_);
+  start_nanos_ = NowNanos();
+}
+
+Tracing::ScopedActivity::~ScopedActivity() {
+  if (start_nanos_ == 0) return;
+  GetThreadBuffer()->Append(
+      Event{start_nanos_, NowNanos(), id_, parent_, category_, true});
+  Context::Current()->set_trace_id(parent_);
+}
+
+std::string Tracing::ExportChromeTrace() {
+  Registry* r = GetRegistry();
+  std::lock_guard<std::mutex> l(r->mu);
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  bool first = true;
+  for (const ThreadBuffer* b : r->buffers) {
+    const uint64_t end = b->next.load(std::memory_order_acquire);
+    if (end == 0) continue;
+    AppendEvent(&out, &first,
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"thread %d\"}}",
+                b->tid, b->tid);
+    const uint64_t begin =
+        end > static_cast<uint64_t>(kEventsPerThread) ? end - kEventsPerThread
+                                                      : 0;
+    for (uint64_t i = begin; i < end; ++i) {
+      const Event& e = b->events[i % kEventsPerThread];
+      if (e.start_nanos < r->start_nanos) continue;
+      const double ts = (e.start_nanos - r->start_nanos) / 1e3;
+      const char* name = EventCategoryString(e.category);
+      const unsigned long long id = e.id;
+      const unsigned long long parent = e.parent;
+      if (e.scoped) {
+        AppendEvent(&out, &first,
+                    "{\"name\":\"%s\",\"cat\":\"pool\",\"ph\":\"X\","
+                    "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"id\":%llu,\"parent\":%llu}}",
+                    name, ts, (e.end_nanos - e.start_nanos) / 1e3, b->tid, id,
+                    parent);
+      } else {
+        AppendEvent(&out, &first,
+                    "{\"name\":\"%s\",\"cat\":\"pool\",\"ph\":\"i\","
+                    "\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"id\":%llu,\"parent\":%llu}}",
+                    name, ts, b->tid, id, parent);
+      }
+      // Arrows from each Schedule() to the run of its closure.
+      if (e.category == EventCategory::kScheduleClosure) {
+        AppendEvent(&out, &first,
+                    "{\"name\":\"closure\",\"cat\":\"flow\",\"ph\":\"s\","
+                    "\"id\":%llu,\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                    id, ts, b->tid);
+      } else if (e.category == EventCategory::kRunClosure) {
+        AppendEvent(&out, &first,
+                    "{\"name\":\"closure\",\"cat\":\"flow\",\"ph\":\"f\","
+                    "\"bp\":\"e\",\"id\":%llu,\"ts\":%.3f,\"pid\":1,"
+                    "\"tid\":%d}",
+                    id, ts, b->tid);
+      }
+    }
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+Status Tracing::WriteChromeTrace(Env* env, const std::string& fname) {
+  return WriteStringToFile(env, fname, ExportChromeTrace());
+}
+
+}  // namespace port
+}  // namespace mr
@@ -0,0 +1,89 @@
+// Low-overhead tracing of thread pool activity.
+//
+// While tracing is active, events are appended to a ring buffer owned by
+// the recording thread, so recording never takes a lock.  When a buffer
+// wraps, its oldest events are overwritten.  ExportChromeTrace() turns
+// the buffers into the JSON accepted by chrome://tracing and Perfetto:
+// every run of a closure becomes a slice, and a flow arrow connects it to
+// the Schedule() call that queued it.
+//
+// Example:
+//   port::Tracing::Start();
+//   ... run the workload ...
+//   port::Tracing::Stop();
+//   RETURN_IF_ERROR(port::Tracing::WriteChromeTrace(env, "/tmp/trace.json"));
+
+#ifndef CORE_SYSTEM_TRACING_H_
+#define CORE_SYSTEM_TRACING_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "core/base/macros.h"
+#include "core/base/status.h"
+#include "core/system/context.h"
+
+namespace mr {
+
+class Env;
+
+namespace port {
+
+class Tracing {
+ public:
+  enum class EventCategory {
+    kScheduleClosure = 0,
+    kRunClosure = 1,
+  };
+  static const char* EventCategoryString(EventCategory category);
+
+  // Events kept per thread; older ones are overwritten.
+  static const int kEventsPerThread = 1 << 14;
+
+  static bool IsActive() { return active_.load(std::memory_order_relaxed); }
+
+  // Starts recording, discarding anything recorded before.
+  static void Start();
+  static void Stop();
+
+  // A process-unique, nonzero id for an activity.
+  static uint64_t UniqueId() {
+    return next_id_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Records a point event of "category" about activity "id".  The parent
+  // is the trace id of the calling thread's Context.
+  static void RecordEvent(EventCategory category, uint64_t id);
+
+  // Records the lifetime of a scoped activity as a slice.  Closures
+  // scheduled while it runs have it as their parent.
+  class ScopedActivity {
+   public:
+    ScopedActivity(EventCategory category, uint64_t id);
+    ~ScopedActivity();
+
+   private:
+    const EventCategory category_;
+    const uint64_t id_;
+    uint64_t parent_;
+    uint64_t start_nanos_;
+    DISALLOW_COPY_AND_ASSIGN(ScopedActivity);
+  };
+
+  // Chrome trace event JSON of everything recorded so far.  Call after
+  // Stop(): events recorded concurrently with the export may be torn.
+  static std::string ExportChromeTrace();
+  static Status WriteChromeTrace(Env* env, const std::string& fname);
+
+ private:
+  static std::atomic<bool> active_;
+  static std::atomic<uint64_t> next_id_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(Tracing);
+};
+
+}  // namespace port
+}  // namespace mr
+#endif  // CORE_SYSTEM_TRACING_H_
@@ -0,0 +1,141 @@
+#include "cr/cpu_device.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+
+#include "core/strings/strcat.h"
+
+namespace mr {
+
+namespace {
+
+// Formats "cpus" (ascending) as a kernel cpulist, e.g. "0-3,8".
+string CpuListString(const std::vector<int>& cpus) {
+  string result;
+  for (size_t i = 0; i < cpus.size();) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+    if (!result.empty()) result += ",";
+    strings::StrAppend(&result, cpus[i]);
+    if (j > i) strings::StrAppend(&result, "-", cpus[j]);
+    i = j + 1;
+  }
+  return result;
+}
+
+uint64_t NewIncarnation() {
+  static std::mutex mu;
+  static std::mt19937_64* rng = new std::mt19937_64(std::random_device()());
+  std::lock_guard<std::mutex> l(mu);
+  uint64_t incarnation;
+  do {
+    incarnation = (*rng)();
+  } while (incarnation == 0);
+  return incarnation;
+}
+
+}  // namespace
+
+CPUDevice::CPUDevice(Env* env, const DeviceAttributes& attributes,
+                     int num_threads, const ThreadOptions& thread_options)
+    : Device(env, attributes),
+      workers_(new thread::ThreadPool(env, thread_options, "cpu_device",
+                                      num_threads)) {
+  cpu_worker_threads_.num_threads = num_threads;
+  cpu_worker_threads_.workers = workers_.get();
+  set_cpu_worker_threads(&cpu_worker_threads_);
+}
+
+CPUDevice::~CPUDevice() {
+  // Joins the workers before the rest of the device goes away.
+  workers_.reset();
+}
+
+void CPUDevice::RunKernelsAsync(std::vector<OpKernel*> kernels,
+                                DoneCallback done) {
+  workers_->Schedule([this, kernels, done]() {
+    for (OpKernel* kernel : kernels) {
+      OpKernelContext context(this);
+      Compute(kernel, &context);
+      if (!context.status().ok()) {
+        done(context.status());
+        return;
+      }
+    }
+    done(Status::OK);
+  });
+}
+
+Status CPUDevice::RunKernels(const std::vector<OpKernel*>& kernels) {
+  std::mutex mu;
+  std::condition_variable cv;
+  bool finished = false;
+  Status status;
+  RunKernelsAsync(kernels, [&mu, &cv, &finished, &status](const Status& s) {
+    std::lock_guard<std::mutex> l(mu);
+    status = s;
+    finished = true;
+    cv.notify_all();
+  });
+  std::unique_lock<std::mutex> l(mu);
+  cv.wait(l, [&finished]() { return finished; });
+  return status;
+}
+
+//////////////////////////
+
+DeviceAttributes CPUDeviceFactory::BuildAttributes(const string& name,
+                                                   const NumaNode& node) {
+  DeviceAttributes attributes;
+  attributes.set_name(name);
+  attributes.set_device_type("CPU");
+  attributes.set_memory_limit(node.memory_bytes);
+  // The proto only distinguishes two buses; devices on any further node
+  // are not local to either.
+  attributes.set_bus_adjacency(node.id == 0   ? BUS_0
+                               : node.id == 1 ? BUS_1
+                                              : BUS_ANY);
+  attributes.set_incarnation(NewIncarnation());
+  attributes.set_physical_device_desc(strings::StrCat(
+      "numa_node: ", node.id, ", cpus: ", CpuListString(node.cpus)));
+  return attributes;
+}
+
+Status CPUDeviceFactory::CreateDevices(const SessionOptions& options,
+                                       const string& name_prefix,
+                                       std::vector<Device*>* devices) {
+  return CreateDevices(options, name_prefix, GetNumaNodes(), devices);
+}
+
+Status CPUDeviceFactory::CreateDevices(const SessionOptions& options,
+                                       const string& name_prefix,
+                                       const std::vector<NumaNode>& nodes,
+                                       std::vector<Device*>* devices) {
+  size_t n = nodes.size();
+  auto iter = options.config.device_count().find("CPU");
+  if (iter != options.config.device_count().end()) {
+    if (iter->second < 0) {
+      return Status(error::INVALID_ARGUMENT,
+                    strings::StrCat("Bad CPU device count ", iter->second));
+    }
+    n = std::min<size_t>(n, iter->second);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    const NumaNode& node = nodes[i];
+    if (node.cpus.empty()) {
+      return Status(error::INVALID_ARGUMENT,
+                    strings::StrCat("NUMA node ", node.id, " has no CPUs"));
+    }
+    ThreadOptions thread_options;
+    thread_options.cpu_affinity = node.cpus;
+    const string name = strings::StrCat(name_prefix, "/cpu:", i);
+    devices->push_back(new CPUDevice(options.env, BuildAttributes(name, node),
+                                     static_cast<int>(node.cpus.size()),
+                                     thread_options));
+  }
+  return Status::OK;
+}
+
+}  // namespace mr
@@ -0,0 +1,71 @@
+#ifndef CR_CPU_DEVICE_H_
+#define CR_CPU_DEVICE_H_
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cr/device.h"
+#include "core/base/macros.h"
+#include "core/base/status.h"
+#include "core/base/threadpool.h"
+#include "core/system/env.h"
+#include "core/system/numa.h"
+#include "public/session_options.h"
+
+namespace mr {
+
+// A Device that runs kernels on a pool of worker threads of its own.
+// Kernels get intra-op parallelism from OpKernelContext::ParallelFor(),
+// which spreads over the same pool.
+class CPUDevice : public Device {
+ public:
+  // The workers are created with "thread_options", e.g. to pin them to the
+  // CPUs of one NUMA node.
+  CPUDevice(Env* env, const DeviceAttributes& attributes, int num_threads,
+            const ThreadOptions& thread_options);
+  ~CPUDevice() override;
+
+  typedef std::function<void(const Status&)> DoneCallback;
+
+  // Runs "kernels" one after another on a worker thread, stopping at the
+  // first one that fails, then calls "done" with its status.  The kernels
+  // must outlive the call to "done".
+  void RunKernelsAsync(std::vector<OpKernel*> kernels, DoneCallback done);
+
+  // Blocking version of RunKernelsAsync().
+  Status RunKernels(const std::vector<OpKernel*>& kernels);
+
+ private:
+  std::unique_ptr<thread::ThreadPool> workers_;
+  CpuWorkerThreads cpu_worker_threads_;
+  DISALLOW_COPY_AND_ASSIGN(CPUDevice);
+};
+
+// Creates the CPU devices of this process: one CPUDevice per NUMA node,
+// with as many worker threads as the node has CPUs, all pinned to them.
+class CPUDeviceFactory {
+ public:
+  // Appends the new devices, owned by the caller, to "*devices".  They are
+  // named name_prefix + "/cpu:<i>".  options.config.device_count["CPU"],
+  // if set, caps how many are created.
+  static Status CreateDevices(const SessionOptions& options,
+                              const string& name_prefix,
+                              std::vector<Device*>* devices);
+
+  // Same, for an explicit NUMA layout.
+  static Status CreateDevices(const SessionOptions& options,
+                              const string& name_prefix,
+                              const std::vector<NumaNode>& nodes,
+                              std::vector<Device*>* devices);
+
+  // The DeviceAttributes of a CPU device named "name" running on "node".
+  static DeviceAttributes BuildAttributes(const string& name,
+                                          const NumaNode& node);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(CPUDeviceFactory);
+};
+
+}  // namespace mr
+#endif  // CR_CPU_DEVICE_H_
@@ -3,7 +3,10 @@
 namespace mr {
 
 Device::Device(Env* env, const DeviceAttributes& device_attributes)
-  : DeviceBase(env), device_attributes_(device_attributes) {}
+  : DeviceBase(env),
+    device_attributes_(device_attributes),
+    allocator_(new TrackingAllocator(device_attributes.name(), cpu_allocator(),
+                                     device_attributes.memory_limit())) {}
 
 Device::~Device() {}
 
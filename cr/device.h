@@ -3,7 +3,9 @@
 #include <memory>
 #include <string>
 
+#include "framework/allocator.h"
 #include "framework/device_base.h"
+#include "framework/op_kernel.h"
 #include "protobuf/device_attributes.pb.h"
 #include "core/base/macros.h"
 
@@ -24,12 +26,19 @@ class Device : public DeviceBase {
     return device_attributes_;
   }
 
-  virtual void Compute() {
-    LOG(INFO) << "TODO(wqx): Compute";
+  // Accounts every allocation against attributes().memory_limit(); a
+  // memory_limit of 0 means no limit.
+  Allocator* GetAllocator() const override { return allocator_.get(); }
+
+  // Runs "op_kernel" on the calling thread.  Errors are reported through
+  // context->status().
+  virtual void Compute(OpKernel* op_kernel, OpKernelContext* context) {
+    op_kernel->Compute(context);
   }
 
  private:
   const DeviceAttributes device_attributes_;
+  const std::unique_ptr<TrackingAllocator> allocator_;
   DISALLOW_COPY_AND_ASSIGN(Device);
 };
 
@@ -0,0 +1,79 @@
+#include "cr/device_mgr.h"
+
+#include "cr/cpu_device.h"
+#include "core/base/logging.h"
+#include "core/strings/strcat.h"
+
+namespace mr {
+
+DeviceMgr::DeviceMgr(const std::vector<Device*>& devices) : devices_(devices) {
+  for (Device* d : devices_) {
+    const string& name = d->name();
+    CHECK(device_map_.emplace(StringPiece(name), d).second)
+        << "Duplicate device " << name;
+    const size_t slash = name.rfind('/');
+    if (slash != string::npos && slash + 1 < name.size()) {
+      // A short name shared by several devices resolves to the first.
+      device_map_.emplace(StringPiece(name).substr(slash + 1), d);
+    }
+    ++device_type_counts_[d->device_type()];
+  }
+}
+
+DeviceMgr::~DeviceMgr() {
+  for (Device* d : devices_) delete d;
+}
+
+Status DeviceMgr::NewLocal(const SessionOptions& options,
+                           const string& name_prefix,
+                           std::unique_ptr<DeviceMgr>* device_mgr) {
+  std::vector<Device*> devices;
+  Status s = CPUDeviceFactory::CreateDevices(options, name_prefix, &devices);
+  if (!s.ok()) {
+    for (Device* d : devices) delete d;
+    return s;
+  }
+  device_mgr->reset(new DeviceMgr(devices));
+  return Status::OK;
+}
+
+void DeviceMgr::ListDeviceAttributes(
+    std::vector<DeviceAttributes>* attributes) const {
+  attributes->reserve(attributes->size() + devices_.size());
+  for (Device* d : devices_) attributes->push_back(d->attributes());
+}
+
+std::vector<Device*> DeviceMgr::ListDevicesOnBus(BusAdjacency bus) const {
+  std::vector<Device*> result;
+  for (Device* d : devices_) {
+    if (d->attributes().bus_adjacency() == bus) result.push_back(d);
+  }
+  return result;
+}
+
+Status DeviceMgr::LookupDevice(StringPiece name, Device** device) const {
+  auto iter = device_map_.find(name);
+  if (iter == device_map_.end()) {
+    return Status(error::INVALID_ARGUMENT,
+                  strings::StrCat(name, " unknown device."));
+  }
+  *device = iter->second;
+  return Status::OK;
+}
+
+int DeviceMgr::NumDeviceType(const string& type) const {
+  auto iter = device_type_counts_.find(type);
+  return iter == device_type_counts_.end() ? 0 : iter->second;
+}
+
+string DeviceMgr::DebugString() const {
+  string out;
+  for (Device* d : devices_) {
+    strings::StrAppend(&out, d->name(), " (", d->device_type(), ", ",
+                       BusAdjacency_Name(d->attributes().bus_adjacency()),
+                       ", ", d->attributes().physical_device_desc(), ")\n");
+  }
+  return out;
+}
+
+}  // namespace mr
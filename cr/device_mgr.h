@@ -0,0 +1,63 @@
+#ifndef CR_DEVICE_MGR_H_
+#define CR_DEVICE_MGR_H_
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cr/device.h"
+#include "core/base/macros.h"
+#include "core/base/status.h"
+#include "core/strings/string_piece.h"
+#include "protobuf/device_attributes.pb.h"
+#include "public/session_options.h"
+
+namespace mr {
+
+// Owns the local devices of a worker and finds them by name.
+//
+// Example:
+//   std::unique_ptr<DeviceMgr> device_mgr;
+//   RETURN_IF_ERROR(DeviceMgr::NewLocal(options,
+//       "/job:localhost/replica:0/task:0", &device_mgr));
+//   master_env.local_devices = device_mgr->ListDevices();
+//   Device* cpu0;
+//   RETURN_IF_ERROR(device_mgr->LookupDevice("cpu:0", &cpu0));
+class DeviceMgr {
+ public:
+  // Takes ownership of "devices".
+  explicit DeviceMgr(const std::vector<Device*>& devices);
+  ~DeviceMgr();
+
+  // Creates a DeviceMgr holding one CPU device per local NUMA node, see
+  // CPUDeviceFactory.
+  static Status NewLocal(const SessionOptions& options,
+                         const string& name_prefix,
+                         std::unique_ptr<DeviceMgr>* device_mgr);
+
+  std::vector<Device*> ListDevices() const { return devices_; }
+  void ListDeviceAttributes(std::vector<DeviceAttributes>* attributes) const;
+
+  // Devices that sit on "bus", i.e. the NUMA node placement should keep
+  // their data on.
+  std::vector<Device*> ListDevicesOnBus(BusAdjacency bus) const;
+
+  // Finds a device by its full name or by the short name after the last
+  // '/', e.g. "cpu:0".  O(1).
+  Status LookupDevice(StringPiece name, Device** device) const;
+
+  int NumDeviceType(const string& type) const;
+
+  string DebugString() const;
+
+ private:
+  const std::vector<Device*> devices_;
+  // Keys point into the names held by the devices.
+  std::unordered_map<StringPiece, Device*, StringPieceHash> device_map_;
+  std::unordered_map<string, int> device_type_counts_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeviceMgr);
+};
+
+}  // namespace mr
+#endif  // CR_DEVICE_MGR_H_
@@ -8,6 +8,7 @@
 namespace mr {
 
 class Device;
+class DeviceMgr;
 class Env;
 class MasterSessionInterface;
 class WorkerCacheInterface;
@@ -16,6 +17,8 @@ struct MasterEnv {
  Env* env = nullptr;
  WorkerCacheInterface* worker_cache = nullptr;
  std::vector<Device*> local_devices;
+ // Owns local_devices and looks them up by name.
+ const DeviceMgr* device_mgr = nullptr;
 
  std::function<MasterSessionInterface*(const SessionOptions&,
 		                       MasterEnv*,
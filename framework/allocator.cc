@@ -0,0 +1,152 @@
+#include "framework/allocator.h"
+
+#include "core/base/mem.h"
+#include "core/strings/stringprintf.h"
+
+namespace mr {
+
+namespace {
+
+class CPUAllocator : public Allocator {
+ public:
+  CPUAllocator() {}
+
+  std::string Name() override { return "cpu"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return aligned_malloc(num_bytes, static_cast<int>(alignment));
+  }
+
+  void DeallocateRaw(void* ptr) override { aligned_free(ptr); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CPUAllocator);
+};
+
+// Raises "*max" to at least "value".
+void UpdateMax(std::atomic<int64_t>* max, int64_t value) {
+  int64_t current = max->load(std::memory_order_relaxed);
+  while (current < value &&
+         !max->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+std::string AllocatorStats::DebugString() const {
+  return strings::Printf(
+      "Limit:        %20lld\n"
+      "InUse:        %20lld\n"
+      "MaxInUse:     %20lld\n"
+      "NumAllocs:    %20lld\n"
+      "NumFailed:    %20lld\n"
+      "MaxAllocSize: %20lld\n",
+      static_cast<long long>(bytes_limit),
+      static_cast<long long>(bytes_in_use),
+      static_cast<long long>(max_bytes_in_use),
+      static_cast<long long>(num_allocs),
+      static_cast<long long>(num_failed_allocs),
+      static_cast<long long>(max_alloc_size));
+}
+
+const size_t Allocator::kAllocatorAlignment;
+
+Allocator::~Allocator() {}
+
+Allocator* cpu_allocator() {
+  static Allocator* a = new CPUAllocator;
+  return a;
+}
+
+TrackingAllocator::TrackingAllocator(const std::string& name,
+                                     Allocator* underlying,
+                                     int64_t bytes_limit)
+    : name_(name),
+      underlying_(underlying),
+      bytes_limit_(bytes_limit),
+      num_allocs_(0),
+      num_failed_allocs_(0),
+      bytes_in_use_(0),
+      max_bytes_in_use_(0),
+      max_alloc_size_(0) {
+  CHECK(underlying_ != nullptr);
+  CHECK_GE(bytes_limit_, 0);
+}
+
+TrackingAllocator::~TrackingAllocator() {
+  if (bytes_in_use() != 0) {
+    LOG(ERROR) << name_ << " destroyed with " << bytes_in_use()
+               << " bytes still allocated";
+  }
+}
+
+bool TrackingAllocator::Reserve(int64_t num_bytes) {
+  if (bytes_limit_ == 0) {
+    UpdateMax(&max_bytes_in_use_,
+              bytes_in_use_.fetch_add(num_bytes, std::memory_order_relaxed) +
+                  num_bytes);
+    return true;
+  }
+  int64_t current = bytes_in_use_.load(std::memory_order_relaxed);
+  do {
+    if (num_bytes > bytes_limit_ - current) return false;
+  } while (!bytes_in_use_.compare_exchange_weak(current, current + num_bytes,
+                                                std::memory_order_relaxed));
+  UpdateMax(&max_bytes_in_use_, current + num_bytes);
+  return true;
+}
+
+void* TrackingAllocator::AllocateInternal(size_t alignment, size_t num_bytes,
+                                          bool log_refusal) {
+  DCHECK_EQ(0, alignment & (alignment - 1)) << alignment;
+  if (alignment < sizeof(Header)) alignment = sizeof(Header);
+  // The header sits in the padding in front of the user pointer.
+  const size_t offset = (sizeof(Header) + alignment - 1) & ~(alignment - 1);
+  if (num_bytes > static_cast<size_t>(std::numeric_limits<int64_t>::max()) ||
+      !Reserve(static_cast<int64_t>(num_bytes))) {
+    num_failed_allocs_.fetch_add(1, std::memory_order_relaxed);
+    if (log_refusal) {
+      LOG(WARNING) << name_ << " ran out of memory trying to allocate "
+                   << num_bytes << " bytes; " << bytes_in_use() << " of "
+                   << bytes_limit_ << " in use";
+    }
+    return nullptr;
+  }
+  char* base =
+      static_cast<char*>(underlying_->AllocateRaw(alignment, offset + num_bytes));
+  if (base == nullptr) {
+    bytes_in_use_.fetch_sub(num_bytes, std::memory_order_relaxed);
+    num_failed_allocs_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  char* ptr = base + offset;
+  Header* header = HeaderOf(ptr);
+  header->num_bytes = num_bytes;
+  header->offset = offset;
+  num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  UpdateMax(&max_alloc_size_, static_cast<int64_t>(num_bytes));
+  return ptr;
+}
+
+void TrackingAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  const Header* header = HeaderOf(ptr);
+  bytes_in_use_.fetch_sub(header->num_bytes, std::memory_order_relaxed);
+  underlying_->DeallocateRaw(static_cast<char*>(ptr) - header->offset);
+}
+
+size_t TrackingAllocator::RequestedSize(const void* ptr) {
+  return HeaderOf(ptr)->num_bytes;
+}
+
+void TrackingAllocator::GetStats(AllocatorStats* stats) {
+  stats->num_allocs = num_allocs_.load(std::memory_order_relaxed);
+  stats->num_failed_allocs = num_failed_allocs_.load(std::memory_order_relaxed);
+  stats->bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+  stats->max_bytes_in_use = max_bytes_in_use_.load(std::memory_order_relaxed);
+  stats->max_alloc_size = max_alloc_size_.load(std::memory_order_relaxed);
+  stats->bytes_limit = bytes_limit_;
+}
+
+}  // namespace mr
@@ -0,0 +1,164 @@
+// Allocator is the interface through which devices hand out memory for
+// task data.  Every Device owns a TrackingAllocator that counts the bytes
+// in use on that device and refuses allocations that would take it past
+// DeviceAttributes::memory_limit, so one runaway task fails on its own
+// instead of taking the whole worker process down with it.
+//
+// Example:
+//   Allocator* a = device->GetAllocator();
+//   char* buf = a->Allocate<char>(n);
+//   if (buf == nullptr) {
+//     return Status(error::RESOURCE_EXHAUSTED, "...");
+//   }
+//   ...
+//   a->Deallocate(buf);
+
+#ifndef FRAMEWORK_ALLOCATOR_H_
+#define FRAMEWORK_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <limits>
+#include <string>
+
+#include "core/base/logging.h"
+#include "core/base/macros.h"
+
+namespace mr {
+
+struct AllocatorStats {
+  int64_t num_allocs = 0;         // Number of successful allocations.
+  int64_t num_failed_allocs = 0;  // Allocations refused by the limit.
+  int64_t bytes_in_use = 0;       // Bytes currently allocated.
+  int64_t max_bytes_in_use = 0;   // High watermark of bytes_in_use.
+  int64_t max_alloc_size = 0;     // Largest single allocation.
+  int64_t bytes_limit = 0;        // 0 means no limit.
+
+  std::string DebugString() const;
+};
+
+class Allocator {
+ public:
+  // Alignment of everything returned by Allocate<T>().
+  static const size_t kAllocatorAlignment = 32;
+
+  virtual ~Allocator();
+
+  virtual std::string Name() = 0;
+
+  // Returns "num_bytes" of memory aligned to "alignment" (a power of two),
+  // or nullptr if it cannot be had.
+  virtual void* AllocateRaw(size_t alignment, size_t num_bytes) = 0;
+
+  // Like AllocateRaw(), for callers that expect refusals and recover from
+  // them, such as a search for the largest buffer that fits: a refused
+  // allocation is not logged.
+  virtual void* TryAllocateRaw(size_t alignment, size_t num_bytes) {
+    return AllocateRaw(alignment, num_bytes);
+  }
+
+  // "ptr" must have come from AllocateRaw() or TryAllocateRaw() on this
+  // allocator.
+  virtual void DeallocateRaw(void* ptr) = 0;
+
+  template <typename T>
+  T* Allocate(size_t num_elements) {
+    if (num_elements > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      return nullptr;
+    }
+    return static_cast<T*>(
+        AllocateRaw(kAllocatorAlignment, num_elements * sizeof(T)));
+  }
+
+  template <typename T>
+  T* TryAllocate(size_t num_elements) {
+    if (num_elements > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      return nullptr;
+    }
+    return static_cast<T*>(
+        TryAllocateRaw(kAllocatorAlignment, num_elements * sizeof(T)));
+  }
+
+  template <typename T>
+  void Deallocate(T* ptr) {
+    if (ptr != nullptr) DeallocateRaw(ptr);
+  }
+
+  // True if RequestedSize() works.
+  virtual bool TracksAllocationSizes() { return false; }
+
+  // The "num_bytes" that "ptr" was allocated with.
+  virtual size_t RequestedSize(const void* ptr) {
+    LOG(FATAL) << Name() << " does not track allocation sizes";
+    return 0;
+  }
+
+  // Fills "*stats"; allocators that keep no statistics leave it zeroed.
+  virtual void GetStats(AllocatorStats* stats) { *stats = AllocatorStats(); }
+};
+
+// The process-wide, unlimited heap allocator.
+Allocator* cpu_allocator();
+
+// Wraps another allocator, keeps AllocatorStats for everything allocated
+// through it and fails allocations that would take bytes_in_use past
+// "bytes_limit".  Thread-safe and lock-free.
+class TrackingAllocator : public Allocator {
+ public:
+  // A "bytes_limit" of 0 means no limit.  Does not take ownership of
+  // "underlying".
+  TrackingAllocator(const std::string& name, Allocator* underlying,
+                    int64_t bytes_limit);
+  ~TrackingAllocator() override;
+
+  std::string Name() override { return name_; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateInternal(alignment, num_bytes, true);
+  }
+  void* TryAllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateInternal(alignment, num_bytes, false);
+  }
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() override { return true; }
+  size_t RequestedSize(const void* ptr) override;
+  void GetStats(AllocatorStats* stats) override;
+
+  int64_t bytes_limit() const { return bytes_limit_; }
+  int64_t bytes_in_use() const {
+    return bytes_in_use_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Stored just in front of every pointer handed out.
+  struct Header {
+    size_t num_bytes;
+    size_t offset;  // From the underlying allocation to the user pointer.
+  };
+
+  static Header* HeaderOf(const void* ptr) {
+    return reinterpret_cast<Header*>(
+               const_cast<char*>(static_cast<const char*>(ptr))) -
+           1;
+  }
+
+  void* AllocateInternal(size_t alignment, size_t num_bytes,
+                         bool log_refusal);
+  bool Reserve(int64_t num_bytes);
+
+  const std::string name_;
+  Allocator* const underlying_;
+  const int64_t bytes_limit_;
+
+  std::atomic<int64_t> num_allocs_;
+  std::atomic<int64_t> num_failed_allocs_;
+  std::atomic<int64_t> bytes_in_use_;
+  std::atomic<int64_t> max_bytes_in_use_;
+  std::atomic<int64_t> max_alloc_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(TrackingAllocator);
+};
+
+}  // namespace mr
+#endif  // FRAMEWORK_ALLOCATOR_H_
@@ -1,7 +1,11 @@
 #include "framework/device_base.h"
 
+#include "framework/allocator.h"
+
 namespace mr {
 
 DeviceBase::~DeviceBase() {}
 
+Allocator* DeviceBase::GetAllocator() const { return cpu_allocator(); }
+
 } // namespace mr
@@ -9,6 +9,7 @@
 #include "core/base/logging.h"
 
 namespace mr {
+class Allocator;
 class Env;
 
 namespace thread {
@@ -44,6 +45,11 @@ class DeviceBase {
     LOG(FATAL) << "Device does not implement attributes()";
   }
 
+  // Memory for data produced on this device.  Defaults to the unlimited
+  // cpu_allocator(); devices with a memory_limit return an allocator that
+  // enforces it.
+  virtual Allocator* GetAllocator() const;
+
  private:
   Env* const env_;
   CpuWorkerThreads* cpu_worker_threads_ = nullptr;
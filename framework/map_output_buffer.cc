@@ -0,0 +1,342 @@
+#include "framework/map_output_buffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "core/base/hash.h"
+#include "core/base/logging.h"
+#include "core/base/threadpool.h"
+#include "core/strings/ordered_code.h"
+#include "framework/allocator.h"
+#include "framework/device_base.h"
+
+namespace mr {
+
+namespace {
+
+// Spill output is handed to the WritableFile in blocks of about this size.
+static const size_t kSpillBlockSize = 1 << 20;
+
+void AppendVarint32(std::string* dst, uint32_t v) {
+  char buf[5];
+  int n = 0;
+  while (v >= 0x80) {
+    buf[n++] = static_cast<char>(v | 0x80);
+    v >>= 7;
+  }
+  buf[n++] = static_cast<char>(v);
+  dst->append(buf, n);
+}
+
+bool ConsumeVarint32(StringPiece* input, uint32_t* v) {
+  uint32_t result = 0;
+  for (int shift = 0; shift <= 28 && !input->empty(); shift += 7) {
+    const uint32_t byte = static_cast<unsigned char>((*input)[0]);
+    input->remove_prefix(1);
+    result |= (byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Spill files store sizes as varint32s.
+Status CheckRecordSize(StringPiece key, StringPiece value) {
+  if (PREDICT_FALSE(key.size() > 0xffffffffu || value.size() > 0xffffffffu)) {
+    return Status(error::INVALID_ARGUMENT,
+                  "MapOutputBuffer: keys and values must be under 4 GiB");
+  }
+  return Status::OK;
+}
+
+Status AppendRecord(std::string* dst, StringPiece key, StringPiece value) {
+  RETURN_IF_ERROR(CheckRecordSize(key, value));
+  AppendVarint32(dst, static_cast<uint32_t>(key.size()));
+  AppendVarint32(dst, static_cast<uint32_t>(value.size()));
+  dst->append(key.data(), key.size());
+  dst->append(value.data(), value.size());
+  return Status::OK;
+}
+
+}  // namespace
+
+const size_t MapOutputBuffer::kMinBufferBytes;
+
+MapOutputBuffer::MapOutputBuffer(const Options& options)
+    : options_(options),
+      allocator_(options.allocator != nullptr ? options.allocator
+                                              : cpu_allocator()),
+      own_spill_counter_(0),
+      spill_counter_(&own_spill_counter_) {
+  CHECK_GE(options_.num_partitions, 1);
+  CHECK_GT(options_.buffer_bytes, 0);
+  CHECK_LE(options_.buffer_bytes, 0xffffffffu);
+  CHECK(options_.new_spill_file != nullptr);
+  index_.reserve(std::min<size_t>(options_.max_records, 1 << 16));
+}
+
+MapOutputBuffer::~MapOutputBuffer() { allocator_->Deallocate(arena_); }
+
+Status MapOutputBuffer::AllocateArena() {
+  size_t size = options_.buffer_bytes;
+  while (true) {
+    // Refusals are expected while halving; only the outcome is reported.
+    arena_ = allocator_->TryAllocate<char>(size);
+    if (arena_ != nullptr) break;
+    if (size <= kMinBufferBytes) {
+      return Status(error::RESOURCE_EXHAUSTED,
+                    "MapOutputBuffer: " + allocator_->Name() +
+                        " cannot allocate a key/value buffer");
+    }
+    size = std::max(size / 2, kMinBufferBytes);
+  }
+  if (size < options_.buffer_bytes) {
+    LOG(WARNING) << "MapOutputBuffer: buffering " << size << " of "
+                 << options_.buffer_bytes << " bytes requested";
+  }
+  arena_size_ = size;
+  return Status::OK;
+}
+
+int MapOutputBuffer::Partition(StringPiece key) const {
+  if (options_.num_partitions == 1) return 0;
+  if (options_.partitioner) {
+    const int p = options_.partitioner(key, options_.num_partitions);
+    DCHECK(p >= 0 && p < options_.num_partitions) << p;
+    return p;
+  }
+  return ReduceHash(Hash64(key), options_.num_partitions);
+}
+
+Status MapOutputBuffer::Collect(StringPiece key, StringPiece value) {
+  RETURN_IF_ERROR(CheckRecordSize(key, value));
+  const size_t record_size = key.size() + value.size();
+  const int partition = Partition(key);
+  if (PREDICT_FALSE(arena_ == nullptr)) RETURN_IF_ERROR(AllocateArena());
+  if (record_size > arena_size_) {
+    RETURN_IF_ERROR(Spill());
+    return SpillSingle(partition, key, value);
+  }
+  if (arena_used_ + record_size > arena_size_ ||
+      index_.size() >= options_.max_records) {
+    RETURN_IF_ERROR(Spill());
+  }
+  char* dst = arena_ + arena_used_;
+  memcpy(dst, key.data(), key.size());
+  memcpy(dst + key.size(), value.data(), value.size());
+  index_.push_back(IndexEntry{strings::OrderedCode::KeyPrefix64(key),
+                              static_cast<uint32_t>(partition),
+                              static_cast<uint32_t>(arena_used_),
+                              static_cast<uint32_t>(key.size()),
+                              static_cast<uint32_t>(value.size())});
+  arena_used_ += record_size;
+  return Status::OK;
+}
+
+Status MapOutputBuffer::Spill() {
+  if (index_.empty()) return Status::OK;
+  std::sort(index_.begin(), index_.end(),
+            [this](const IndexEntry& a, const IndexEntry& b) {
+              if (a.partition != b.partition) return a.partition < b.partition;
+              if (a.key_prefix != b.key_prefix) {
+                return a.key_prefix < b.key_prefix;
+              }
+              // The first min(8, key_size) bytes of both keys are equal.
+              if (a.key_size <= 8 || b.key_size <= 8) {
+                return a.key_size < b.key_size;
+              }
+              return KeySuffixOf(a) < KeySuffixOf(b);
+            });
+  Status s = WriteSpill(index_.data(), index_.data() + index_.size());
+  index_.clear();
+  arena_used_ = 0;
+  return s;
+}
+
+Status MapOutputBuffer::SpillSingle(int partition, StringPiece key,
+                                    StringPiece value) {
+  // The record cannot be copied into the arena, so write it straight from
+  // the caller's memory.
+  std::unique_ptr<WritableFile> file;
+  SpillInfo info;
+  info.spill_index = spill_counter_->fetch_add(1);
+  RETURN_IF_ERROR(options_.new_spill_file(info.spill_index, &file));
+  std::string header;
+  AppendVarint32(&header, static_cast<uint32_t>(key.size()));
+  AppendVarint32(&header, static_cast<uint32_t>(value.size()));
+  RETURN_IF_ERROR(file->Append(header));
+  RETURN_IF_ERROR(file->Append(key));
+  RETURN_IF_ERROR(file->Append(value));
+  RETURN_IF_ERROR(file->Close());
+  const uint64_t size = header.size() + key.size() + value.size();
+  info.num_records = 1;
+  info.partition_offsets.assign(options_.num_partitions + 1, size);
+  for (int p = 0; p <= partition; ++p) info.partition_offsets[p] = 0;
+  spills_.push_back(std::move(info));
+  return Status::OK;
+}
+
+Status MapOutputBuffer::WriteSpill(const IndexEntry* begin,
+                                   const IndexEntry* end) {
+  std::unique_ptr<WritableFile> file;
+  SpillInfo info;
+  info.spill_index = spill_counter_->fetch_add(1);
+  RETURN_IF_ERROR(options_.new_spill_file(info.spill_index, &file));
+  info.partition_offsets.reserve(options_.num_partitions + 1);
+
+  uint64_t written = 0;
+  std::string block;
+  block.reserve(kSpillBlockSize + 64);
+  std::vector<StringPiece> values;
+  std::string combined;
+
+  const IndexEntry* e = begin;
+  for (int p = 0; p < options_.num_partitions; ++p) {
+    info.partition_offsets.push_back(written + block.size());
+    while (e != end && e->partition == static_cast<uint32_t>(p)) {
+      const StringPiece key = KeyOf(*e);
+      const IndexEntry* run_end = e + 1;
+      if (options_.combiner) {
+        while (run_end != end && run_end->partition == e->partition &&
+               run_end->key_prefix == e->key_prefix &&
+               KeyOf(*run_end) == key) {
+          ++run_end;
+        }
+      }
+      if (run_end - e > 1) {
+        values.clear();
+        for (const IndexEntry* v = e; v != run_end; ++v) {
+          values.push_back(ValueOf(*v));
+        }
+        combined.clear();
+        options_.combiner(key, values, &combined);
+        RETURN_IF_ERROR(AppendRecord(&block, key, combined));
+      } else {
+        RETURN_IF_ERROR(AppendRecord(&block, key, ValueOf(*e)));
+      }
+      ++info.num_records;
+      e = run_end;
+      if (block.size() >= kSpillBlockSize) {
+        RETURN_IF_ERROR(file->Append(block));
+        written += block.size();
+        block.clear();
+      }
+    }
+  }
+  DCHECK(e == end);
+  if (!block.empty()) {
+    RETURN_IF_ERROR(file->Append(block));
+    written += block.size();
+  }
+  info.partition_offsets.push_back(written);
+  RETURN_IF_ERROR(file->Close());
+  spills_.push_back(std::move(info));
+  return Status::OK;
+}
+
+Status MapOutputBuffer::Flush(std::vector<SpillInfo>* spills) {
+  RETURN_IF_ERROR(Spill());
+  for (SpillInfo& info : spills_) {
+    spills->push_back(std::move(info));
+  }
+  spills_.clear();
+  return Status::OK;
+}
+
+bool MapOutputBuffer::ReadRecord(StringPiece* input, StringPiece* key,
+                                 StringPiece* value) {
+  uint32_t key_size, value_size;
+  if (!ConsumeVarint32(input, &key_size) ||
+      !ConsumeVarint32(input, &value_size) ||
+      input->size() < static_cast<size_t>(key_size) + value_size) {
+    return false;
+  }
+  key->set(input->data(), key_size);
+  value->set(input->data() + key_size, value_size);
+  input->remove_prefix(key_size + value_size);
+  return true;
+}
+
+//////////////////////////
+
+MapOutputCollector::MapOutputCollector(const DeviceBase* device,
+                                       const MapOutputBuffer::Options& options)
+    : device_(device), buffer_options_(options), spill_counter_(0) {
+  if (buffer_options_.allocator == nullptr) {
+    buffer_options_.allocator = device_->GetAllocator();
+  }
+  const int num_buffers = device_->cpu_worker_threads()->num_threads + 1;
+  in_use_.reset(new std::atomic<bool>[num_buffers]);
+  for (int i = 0; i < num_buffers; ++i) {
+    buffers_.emplace_back(NewBuffer());
+    in_use_[i] = false;
+  }
+}
+
+MapOutputCollector::~MapOutputCollector() {}
+
+MapOutputBuffer* MapOutputCollector::NewBuffer() {
+  MapOutputBuffer* buffer = new MapOutputBuffer(buffer_options_);
+  buffer->set_spill_counter(&spill_counter_);
+  return buffer;
+}
+
+MapOutputBuffer* MapOutputCollector::AcquireBuffer(size_t slot) {
+  DCHECK_LT(slot, buffers_.size());
+  if (!in_use_[slot].exchange(true, std::memory_order_acquire)) {
+    return buffers_[slot].get();
+  }
+  std::lock_guard<std::mutex> l(spare_mu_);
+  if (free_spares_.empty()) {
+    spares_.emplace_back(NewBuffer());
+    return spares_.back().get();
+  }
+  MapOutputBuffer* buffer = free_spares_.back();
+  free_spares_.pop_back();
+  return buffer;
+}
+
+void MapOutputCollector::ReleaseBuffer(size_t slot, MapOutputBuffer* buffer) {
+  if (buffer == buffers_[slot].get()) {
+    in_use_[slot].store(false, std::memory_order_release);
+    return;
+  }
+  std::lock_guard<std::mutex> l(spare_mu_);
+  free_spares_.push_back(buffer);
+}
+
+Status MapOutputCollector::ParallelCollect(int64_t total, int64_t cost_per_unit,
+                                           MapFn fn) {
+  thread::ThreadPool* workers = device_->cpu_worker_threads()->workers;
+  std::mutex mu;
+  Status status;
+  workers->ParallelFor(
+      total, cost_per_unit, [this, workers, &fn, &mu, &status](
+                                int64_t first, int64_t last) {
+        const size_t slot = workers->CurrentThreadId() + 1;
+        MapOutputBuffer* buffer = AcquireBuffer(slot);
+        Status s = fn(first, last, buffer);
+        ReleaseBuffer(slot, buffer);
+        if (!s.ok()) {
+          std::lock_guard<std::mutex> l(mu);
+          status.Update(s);
+        }
+      });
+  return status;
+}
+
+Status MapOutputCollector::Flush(std::vector<SpillInfo>* spills) {
+  for (auto& buffer : buffers_) {
+    RETURN_IF_ERROR(buffer->Flush(spills));
+  }
+  std::lock_guard<std::mutex> l(spare_mu_);
+  for (auto& buffer : spares_) {
+    RETURN_IF_ERROR(buffer->Flush(spills));
+  }
+  return Status::OK;
+}
+
+}  // namespace mr
@@ -0,0 +1,227 @@
+// MapOutputBuffer collects the (key, value) records emitted by a map task,
+// buckets them by reducer partition and spills them, sorted by key within
+// each partition, to the spill record format below.
+//
+// All record bytes live in one contiguous arena; the buffer only keeps a
+// flat array of fixed-size index entries that point into it.  A spill sorts
+// the index entries (never the bytes), optionally runs the user combiner over
+// each run of equal keys and streams the result out.
+//
+// Spill record format.  A spill file is the concatenation of the records of
+// partition 0, then partition 1, and so on.  Each record is
+//
+//      varint32 key_size | varint32 value_size | key bytes | value bytes
+//
+// SpillInfo::partition_offsets tells where each partition begins.
+//
+// Example:
+//   MapOutputBuffer::Options options;
+//   options.num_partitions = 16;
+//   options.new_spill_file = ...;
+//   MapOutputBuffer buffer(options);
+//   for (...) RETURN_IF_ERROR(buffer.Collect(key, value));
+//   std::vector<SpillInfo> spills;
+//   RETURN_IF_ERROR(buffer.Flush(&spills));
+
+#ifndef FRAMEWORK_MAP_OUTPUT_BUFFER_H_
+#define FRAMEWORK_MAP_OUTPUT_BUFFER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/base/array_slice.h"
+#include "core/base/macros.h"
+#include "core/base/status.h"
+#include "core/files/file_system.h"
+#include "core/strings/string_piece.h"
+
+namespace mr {
+
+class Allocator;
+class DeviceBase;
+
+// Describes one spill file written by a MapOutputBuffer.
+struct SpillInfo {
+  int spill_index = 0;
+  int64_t num_records = 0;
+  // partition_offsets[p] is the byte offset of the first record of
+  // partition p; partition_offsets[num_partitions] is the file size.
+  std::vector<uint64_t> partition_offsets;
+};
+
+class MapOutputBuffer {
+ public:
+  // Returns the reducer partition in [0, num_partitions) for "key".
+  typedef std::function<int(StringPiece key, int num_partitions)> Partitioner;
+
+  // Folds all "values" buffered for "key" into a single value, written
+  // to "*combined".  Must be associative: it may run on any subset of the
+  // values of a key, and again on its own output in a later spill.
+  typedef std::function<void(StringPiece key,
+                             gtl::ArraySlice<StringPiece> values,
+                             std::string* combined)> Combiner;
+
+  // Opens the file that receives spill number "spill_index".
+  typedef std::function<Status(int spill_index,
+                               std::unique_ptr<WritableFile>* file)>
+      SpillFileFactory;
+
+  struct Options {
+    int num_partitions = 1;
+
+    // Bytes of key/value data buffered before a spill is forced.
+    size_t buffer_bytes = 64 << 20;
+
+    // Where the key/value buffer comes from; defaults to cpu_allocator().
+    // If the allocator cannot spare buffer_bytes, a smaller buffer is used
+    // and spills happen sooner.  Collect() fails with RESOURCE_EXHAUSTED
+    // only when not even kMinBufferBytes can be had.
+    Allocator* allocator = nullptr;
+
+    // Number of index entries buffered before a spill is forced.
+    size_t max_records = 1 << 20;
+
+    // Defaults to ReduceHash(Hash64(key), num_partitions), which is the
+    // same in every process.
+    Partitioner partitioner;
+
+    // Optional.
+    Combiner combiner;
+
+    // Required.
+    SpillFileFactory new_spill_file;
+  };
+
+  // Smallest key/value buffer a MapOutputBuffer settles for.
+  static const size_t kMinBufferBytes = 64 << 10;
+
+  explicit MapOutputBuffer(const Options& options);
+  ~MapOutputBuffer();
+
+  // Buffers one record, spilling first if it does not fit.  A record that
+  // is larger than the whole buffer is spilled on its own.  The buffer is
+  // allocated by the first call.  Spill files cannot hold keys or values
+  // of 4 GiB or more: Collect() rejects them with INVALID_ARGUMENT, and a
+  // spill fails the same way if the combiner produces such a value.
+  Status Collect(StringPiece key, StringPiece value);
+
+  // Sorts, combines and writes everything buffered so far.  A no-op when
+  // the buffer is empty.
+  Status Spill();
+
+  // Spills what is left and moves the description of every spill written
+  // by this buffer into "*spills".
+  Status Flush(std::vector<SpillInfo>* spills);
+
+  int num_partitions() const { return options_.num_partitions; }
+  // Size of the key/value buffer; 0 until the first Collect().
+  size_t buffer_capacity() const { return arena_size_; }
+  int64_t num_buffered_records() const { return index_.size(); }
+  size_t buffered_bytes() const { return arena_used_; }
+
+  // Hands out spill numbers; buffers that share a counter never open the
+  // same spill file twice.  Defaults to a counter private to this buffer.
+  void set_spill_counter(std::atomic<int>* counter) { spill_counter_ = counter; }
+
+  // Parses one record of the spill record format from the front of
+  // "*input".  The returned pieces alias "*input".
+  static bool ReadRecord(StringPiece* input, StringPiece* key,
+                         StringPiece* value);
+
+ private:
+  // One buffered record.  Sorting these 24-byte entries is what keeps a
+  // spill cache friendly: the record bytes never move, and the key prefix
+  // settles most comparisons without reading them.
+  struct IndexEntry {
+    uint64_t key_prefix;  // OrderedCode::KeyPrefix64(key)
+    uint32_t partition;
+    uint32_t offset;
+    uint32_t key_size;
+    uint32_t value_size;
+  };
+
+  StringPiece KeyOf(const IndexEntry& e) const {
+    return StringPiece(arena_ + e.offset, e.key_size);
+  }
+  // The key bytes after those in key_prefix; key_size must exceed 8.
+  StringPiece KeySuffixOf(const IndexEntry& e) const {
+    return StringPiece(arena_ + e.offset + 8, e.key_size - 8);
+  }
+  StringPiece ValueOf(const IndexEntry& e) const {
+    return StringPiece(arena_ + e.offset + e.key_size, e.value_size);
+  }
+
+  Status AllocateArena();
+  int Partition(StringPiece key) const;
+  Status SpillSingle(int partition, StringPiece key, StringPiece value);
+  Status WriteSpill(const IndexEntry* begin, const IndexEntry* end);
+
+  const Options options_;
+  Allocator* const allocator_;
+  char* arena_ = nullptr;
+  size_t arena_size_ = 0;
+  size_t arena_used_ = 0;
+  std::vector<IndexEntry> index_;
+
+  std::atomic<int> own_spill_counter_;
+  std::atomic<int>* spill_counter_;
+  std::vector<SpillInfo> spills_;
+
+  DISALLOW_COPY_AND_ASSIGN(MapOutputBuffer);
+};
+
+// Runs a map function in parallel on the cpu worker threads of a device.
+// Every worker thread (and the calling thread) collects into its own
+// MapOutputBuffer, so Collect() never takes a lock.  Unless the options
+// name an allocator, the buffers are charged to device->GetAllocator().
+//
+// A worker waiting inside fn (e.g. on a nested ParallelFor) may run
+// another block of the same ParallelCollect before the first returns,
+// and threads outside the pool all map to one slot.  A block that finds
+// its thread's buffer taken collects into a spare buffer instead.
+class MapOutputCollector {
+ public:
+  MapOutputCollector(const DeviceBase* device,
+                     const MapOutputBuffer::Options& options);
+  ~MapOutputCollector();
+
+  // Calls fn(first, last, buffer) over blocks of [0, total) using
+  // ThreadPool::ParallelFor.  "fn" returns the first error it hit, if any;
+  // so does ParallelCollect.
+  typedef std::function<Status(int64_t first, int64_t last,
+                               MapOutputBuffer* buffer)>
+      MapFn;
+  Status ParallelCollect(int64_t total, int64_t cost_per_unit, MapFn fn);
+
+  // Flushes every per-thread buffer; see MapOutputBuffer::Flush.
+  Status Flush(std::vector<SpillInfo>* spills);
+
+ private:
+  MapOutputBuffer* AcquireBuffer(size_t slot);
+  void ReleaseBuffer(size_t slot, MapOutputBuffer* buffer);
+  MapOutputBuffer* NewBuffer();
+
+  const DeviceBase* const device_;
+  MapOutputBuffer::Options buffer_options_;
+  std::atomic<int> spill_counter_;
+  // Slot 0 belongs to threads outside the pool, slot i + 1 to worker i.
+  std::vector<std::unique_ptr<MapOutputBuffer>> buffers_;
+  // Whether a block is collecting into buffers_[slot].
+  std::unique_ptr<std::atomic<bool>[]> in_use_;
+
+  // Buffers for blocks whose slot was taken; guarded by spare_mu_.
+  std::mutex spare_mu_;
+  std::vector<std::unique_ptr<MapOutputBuffer>> spares_;
+  std::vector<MapOutputBuffer*> free_spares_;
+
+  DISALLOW_COPY_AND_ASSIGN(MapOutputCollector);
+};
+
+}  // namespace mr
+#endif  // FRAMEWORK_MAP_OUTPUT_BUFFER_H_
@@ -0,0 +1,28 @@
+#include "framework/op_kernel.h"
+
+#include "core/base/threadpool.h"
+
+namespace mr {
+
+OpKernel::~OpKernel() {}
+
+OpKernelContext::OpKernelContext(DeviceBase* device) : device_(device) {
+  CHECK(device_ != nullptr);
+}
+
+OpKernelContext::~OpKernelContext() {}
+
+void OpKernelContext::ParallelFor(int64_t total, int64_t cost_per_unit,
+                                  std::function<void(int64_t, int64_t)> fn) {
+  device_->cpu_worker_threads()->workers->ParallelFor(total, cost_per_unit,
+                                                      std::move(fn));
+}
+
+void OpKernelContext::ParallelFor(
+    int64_t total, thread::ThreadPool::CostEstimator* estimator,
+    std::function<void(int64_t, int64_t)> fn) {
+  device_->cpu_worker_threads()->workers->ParallelFor(total, estimator,
+                                                      std::move(fn));
+}
+
+}  // namespace mr
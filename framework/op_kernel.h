@@ -0,0 +1,95 @@
+// An OpKernel is one unit of computation of a task: a map function over a
+// split, a sort, a combine.  A Device runs kernels; the kernel reaches the
+// device (its allocator and worker threads) through the OpKernelContext it
+// is handed.
+//
+// Example:
+//   class SumKernel : public OpKernel {
+//    public:
+//     SumKernel() : OpKernel("sum") {}
+//     void Compute(OpKernelContext* context) override {
+//       context->ParallelFor(n, kCostPerElement, [](int64_t b, int64_t e) {
+//         ...
+//       });
+//       OP_REQUIRES_OK(context, Finish());
+//     }
+//   };
+
+#ifndef FRAMEWORK_OP_KERNEL_H_
+#define FRAMEWORK_OP_KERNEL_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+#include "core/base/macros.h"
+#include "core/base/status.h"
+#include "core/base/threadpool.h"
+#include "framework/device_base.h"
+
+namespace mr {
+
+class Allocator;
+class OpKernelContext;
+
+class OpKernel {
+ public:
+  explicit OpKernel(const std::string& name) : name_(name) {}
+  virtual ~OpKernel();
+
+  // Does the work of the kernel, reporting failure through
+  // context->SetStatus().  Runs on the thread the device picked; may use
+  // context->ParallelFor() to spread the work over the device.
+  virtual void Compute(OpKernelContext* context) = 0;
+
+  const std::string& name() const { return name_; }
+
+ private:
+  const std::string name_;
+  DISALLOW_COPY_AND_ASSIGN(OpKernel);
+};
+
+class OpKernelContext {
+ public:
+  explicit OpKernelContext(DeviceBase* device);
+  ~OpKernelContext();
+
+  DeviceBase* device() const { return device_; }
+  Env* env() const { return device_->env(); }
+  Allocator* allocator() const { return device_->GetAllocator(); }
+
+  // Intra-op parallelism: runs fn(first, last) over blocks of [0, total)
+  // on the device's cpu worker threads and returns when all are done.
+  // "cost_per_unit" is an estimate of the cycles fn spends per element.
+  void ParallelFor(int64_t total, int64_t cost_per_unit,
+                   std::function<void(int64_t, int64_t)> fn);
+  // Same, with the cost per unit learned from earlier invocations; see
+  // thread::ThreadPool::CostEstimator.
+  void ParallelFor(int64_t total, thread::ThreadPool::CostEstimator* estimator,
+                   std::function<void(int64_t, int64_t)> fn);
+
+  // Records the first error of the kernel.  Not thread-safe: call it from
+  // the thread running Compute(), not from ParallelFor blocks.
+  void SetStatus(const Status& status) { status_.Update(status); }
+  const Status& status() const { return status_; }
+
+ private:
+  DeviceBase* const device_;
+  Status status_;
+  DISALLOW_COPY_AND_ASSIGN(OpKernelContext);
+};
+
+// Sets the status of "CTX" and returns from the enclosing Compute() if
+// "STATUS" is an error.
+#define OP_REQUIRES_OK(CTX, STATUS)   \
+  do {                                \
+    const ::mr::Status _s(STATUS);    \
+    if (PREDICT_FALSE(!_s.ok())) {    \
+      (CTX)->SetStatus(_s);           \
+      return;                         \
+    }                                 \
+  } while (0)
+
+}  // namespace mr
+#endif  // FRAMEWORK_OP_KERNEL_H_
@@ -0,0 +1,9 @@
+#include "public/session_options.h"
+
+#include "core/system/env.h"
+
+namespace mr {
+
+SessionOptions::SessionOptions() : env(Env::Default()) {}
+
+} // mr
@@ -0,0 +1,91 @@
+#include "core/base/arena.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+TEST(Arena, AlignedAllocations) {
+  Arena arena(1024);
+  for (size_t alignment = 1; alignment <= 64; alignment <<= 1) {
+    for (int i = 0; i < 50; ++i) {
+      char* p = arena.AllocAligned(i % 7 + 1, alignment);
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignment);
+      memset(p, 0xab, i % 7 + 1);
+    }
+  }
+  EXPECT_GE(arena.MemoryUsage(), arena.BytesAllocated());
+}
+
+TEST(Arena, ChainsBlocksAndKeepsThemOnReset) {
+  Arena arena(4096);
+  std::vector<char*> ptrs;
+  for (int i = 0; i < 1000; ++i) {
+    char* p = arena.Alloc(100);
+    memset(p, i & 0xff, 100);
+    ptrs.push_back(p);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(static_cast<char>(i & 0xff), ptrs[i][0]);
+    EXPECT_EQ(static_cast<char>(i & 0xff), ptrs[i][99]);
+  }
+  const size_t usage = arena.MemoryUsage();
+  EXPECT_GE(usage, 100000u);
+
+  arena.Reset();
+  EXPECT_EQ(0u, arena.BytesAllocated());
+  for (int i = 0; i < 1000; ++i) arena.Alloc(100);
+  // The second round is served from the blocks kept by Reset().
+  EXPECT_EQ(usage, arena.MemoryUsage());
+}
+
+TEST(Arena, LargeAllocationsAreReleasedOnReset) {
+  Arena arena(4096);
+  char* small = arena.Alloc(16);
+  char* big = arena.Alloc(100000);
+  memset(big, 1, 100000);
+  EXPECT_GE(arena.MemoryUsage(), 100000u + 4096u);
+  // The large block did not use up the current block.
+  EXPECT_EQ(small + 16, arena.Alloc(16));
+  arena.Reset();
+  EXPECT_EQ(4096u, arena.MemoryUsage());
+}
+
+TEST(Arena, HugePages) {
+  Arena::Options options;
+  options.block_size = 4096;
+  options.use_huge_pages = true;
+  Arena arena(options);
+  char* p = arena.Alloc(1000);
+  memset(p, 7, 1000);
+  EXPECT_GE(arena.MemoryUsage(), 4096u);
+}
+
+struct Point {
+  Point(int x, int y) : x(x), y(y) {}
+  int x;
+  int y;
+};
+
+TEST(Arena, NewAndStlAllocator) {
+  Arena arena(4096);
+  Point* pt = arena.New<Point>(3, 4);
+  EXPECT_EQ(3, pt->x);
+  EXPECT_EQ(4, pt->y);
+
+  std::vector<int64_t, ArenaAllocator<int64_t>> v{
+      ArenaAllocator<int64_t>(&arena)};
+  for (int i = 0; i < 10000; ++i) v.push_back(i);
+  int64_t sum = 0;
+  for (int64_t x : v) sum += x;
+  EXPECT_EQ(10000 * 9999 / 2, sum);
+  EXPECT_EQ(ArenaAllocator<int>(&arena), v.get_allocator());
+}
+
+}  // namespace
+}  // namespace mr
@@ -0,0 +1,116 @@
+#include "core/base/inlined_function.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/base/object_pool.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace gtl {
+namespace {
+
+TEST(InlinedFunction, Empty) {
+  InlinedFunction<void()> f;
+  EXPECT_FALSE(f);
+  EXPECT_TRUE(f == nullptr);
+  std::function<void()> empty;
+  InlinedFunction<void()> g(empty);
+  EXPECT_FALSE(g);
+  void (*null_fn)() = nullptr;
+  InlinedFunction<void()> h(null_fn);
+  EXPECT_FALSE(h);
+}
+
+TEST(InlinedFunction, SmallCapturesAreInlined) {
+  int a = 1, b = 2, c = 3;
+  InlinedFunction<int(int)> f([&a, &b, &c](int x) { return a + b + c + x; });
+  EXPECT_TRUE(f.is_inlined());
+  EXPECT_EQ(16, f(10));
+
+  std::function<int(int)> sf = [](int x) { return x * 2; };
+  InlinedFunction<int(int)> g(sf);
+  EXPECT_TRUE(g.is_inlined());
+  EXPECT_EQ(8, g(4));
+}
+
+TEST(InlinedFunction, LargeCapturesGoToHeap) {
+  char big[128] = "hello";
+  InlinedFunction<std::string()> f([big]() { return std::string(big); });
+  EXPECT_FALSE(f.is_inlined());
+  EXPECT_EQ("hello", f());
+  InlinedFunction<std::string()> g(std::move(f));
+  EXPECT_FALSE(f);
+  EXPECT_EQ("hello", g());
+}
+
+struct MoveOnly {
+  std::unique_ptr<int> p;
+  int operator()() const { return *p; }
+};
+
+TEST(InlinedFunction, MoveOnlyCaptures) {
+  InlinedFunction<int()> f(MoveOnly{std::unique_ptr<int>(new int(42))});
+  EXPECT_TRUE(f.is_inlined());
+  InlinedFunction<int()> moved(std::move(f));
+  EXPECT_EQ(42, moved());
+
+  std::shared_ptr<int> shared(new int(7));
+  {
+    InlinedFunction<int()> g([shared]() { return *shared; });
+    EXPECT_EQ(2, shared.use_count());
+    InlinedFunction<int()> h;
+    h = std::move(g);
+    EXPECT_EQ(2, shared.use_count());
+    EXPECT_EQ(7, h());
+    h = nullptr;
+    EXPECT_EQ(1, shared.use_count());
+  }
+  EXPECT_EQ(1, shared.use_count());
+}
+
+struct Payload {
+  explicit Payload(int v) : value(v) { ++live; }
+  ~Payload() { --live; }
+  int value;
+  char pad[40];
+  static int live;
+};
+int Payload::live = 0;
+
+TEST(ObjectPool, ReusesSlots) {
+  Payload* a = ObjectPool<Payload>::New(1);
+  EXPECT_EQ(1, a->value);
+  EXPECT_EQ(1, Payload::live);
+  ObjectPool<Payload>::Delete(a);
+  EXPECT_EQ(0, Payload::live);
+  Payload* b = ObjectPool<Payload>::New(2);
+  EXPECT_EQ(a, b);
+  ObjectPool<Payload>::Delete(b);
+}
+
+TEST(ObjectPool, CrossThreadFree) {
+  const int kObjects = 10000;
+  std::vector<Payload*> objects;
+  for (int i = 0; i < kObjects; ++i) {
+    objects.push_back(ObjectPool<Payload>::New(i));
+  }
+  std::thread t([&objects]() {
+    for (Payload* p : objects) ObjectPool<Payload>::Delete(p);
+  });
+  t.join();
+  EXPECT_EQ(0, Payload::live);
+  for (int i = 0; i < kObjects; ++i) {
+    objects[i] = ObjectPool<Payload>::New(i);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(objects[i]) % 16);
+  }
+  for (Payload* p : objects) ObjectPool<Payload>::Delete(p);
+}
+
+}  // namespace
+}  // namespace gtl
+}  // namespace mr
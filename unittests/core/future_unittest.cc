@@ -0,0 +1,179 @@
+#include "core/base/future.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "core/base/threadpool.h"
+#include "core/system/env.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace thread {
+namespace {
+
+TEST(Future, ThenRunsOnPoolAfterSet) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  Promise<int> promise;
+  std::atomic<int> thread_id(-2);
+  Future<std::string> f =
+      promise.GetFuture()
+          .Then(&pool,
+                [&pool, &thread_id](int x) {
+                  thread_id = pool.CurrentThreadId();
+                  return x * 2;
+                })
+          .Then(&pool, [](int x) { return std::to_string(x); });
+  EXPECT_FALSE(f.ready());
+  promise.Set(21);
+  std::string value;
+  EXPECT_OK(f.Get(&value));
+  EXPECT_EQ("42", value);
+  EXPECT_GE(thread_id.load(), 0);
+}
+
+TEST(Future, ErrorSkipsContinuations) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  Promise<int> promise;
+  std::atomic<int> calls(0);
+  Future<int> f = promise.GetFuture()
+                      .Then(&pool, [&calls](int x) { return ++calls + x; })
+                      .Then(&pool, [&calls](int x) { return ++calls + x; });
+  promise.SetError(Status(error::NOT_FOUND, "no input"));
+  EXPECT_EQ(error::NOT_FOUND, f.status().error_code());
+  int value = 0;
+  EXPECT_FALSE(f.Get(&value).ok());
+  EXPECT_EQ(0, calls.load());
+}
+
+TEST(Future, ThenFlattensFutures) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  Promise<int> inner;
+  Future<int> f = MakeReadyFuture(1).Then(
+      &pool, [inner](int) { return inner.GetFuture(); });
+  Future<int> failed = MakeReadyFuture(1).Then(&pool, [](int) {
+    return MakeErrorFuture<int>(Status(error::INTERNAL, "step failed"));
+  });
+  EXPECT_EQ(error::INTERNAL, failed.status().error_code());
+  Env::Default()->SleepForMicroseconds(1000);
+  EXPECT_FALSE(f.ready());
+  inner.Set(7);
+  EXPECT_EQ(7, f.value());
+}
+
+TEST(Future, WhenAll) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  std::vector<Future<int>> futures;
+  for (int i = 0; i < 100; ++i) {
+    futures.push_back(MakeReadyFuture(i).Then(&pool, [](int x) {
+      Env::Default()->SleepForMicroseconds(10);
+      return x * x;
+    }));
+  }
+  std::vector<int> squares;
+  EXPECT_OK(WhenAll(futures).Get(&squares));
+  ASSERT_EQ(100u, squares.size());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i * i, squares[i]);
+
+  EXPECT_TRUE(WhenAll(std::vector<Future<int>>()).value().empty());
+
+  // The first error completes the result without waiting for the rest.
+  Promise<int> never;
+  Future<std::vector<int>> all = WhenAll(std::vector<Future<int>>{
+      never.GetFuture(),
+      MakeErrorFuture<int>(Status(error::ABORTED, "stop"))});
+  EXPECT_EQ(error::ABORTED, all.status().error_code());
+  never.Set(0);
+}
+
+TEST(Future, WhenAny) {
+  Promise<int> slow;
+  Promise<int> fast;
+  Future<size_t> any =
+      WhenAny(std::vector<Future<int>>{slow.GetFuture(), fast.GetFuture()});
+  EXPECT_FALSE(any.ready());
+  fast.Set(1);
+  EXPECT_EQ(1u, any.value());
+  slow.Set(0);
+  EXPECT_EQ(1u, any.value());
+
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            WhenAny(std::vector<Future<int>>()).status().error_code());
+}
+
+TEST(Future, BrokenPromise) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  Future<std::string> f;
+  {
+    Promise<int> promise;
+    Promise<int> copy = promise;
+    f = promise.GetFuture().Then(&pool,
+                                 [](int x) { return std::to_string(x); });
+  }
+  // Neither copy completed the promise.
+  EXPECT_EQ(error::ABORTED, f.status().error_code());
+
+  // A completed promise is not broken by going away.
+  Future<int> done;
+  {
+    Promise<int> promise;
+    done = promise.GetFuture();
+    promise.Set(1);
+  }
+  EXPECT_EQ(1, done.value());
+
+  // Nor is one that a moved-to handle still holds.
+  Promise<int> moved;
+  Future<int> pending = moved.GetFuture();
+  {
+    Promise<int> from = moved;
+    moved = std::move(from);
+  }
+  EXPECT_FALSE(pending.ready());
+  moved.Set(2);
+  EXPECT_EQ(2, pending.value());
+}
+
+TEST(Future, Void) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  Promise<void> written;
+  std::atomic<int> calls(0);
+  Future<int> f = written.GetFuture()
+                      .Then(&pool, [&calls]() { ++calls; })
+                      .Then(&pool, [&calls]() { return calls + 1; });
+  written.Set();
+  int value = 0;
+  EXPECT_OK(f.Get(&value));
+  EXPECT_EQ(2, value);
+
+  Future<void> logged = MakeReadyFuture(3).Then(&pool, [&calls](int x) {
+    calls += x;
+  });
+  EXPECT_OK(logged.Get());
+  EXPECT_EQ(4, calls.load());
+  EXPECT_OK(MakeReadyFuture().Get());
+
+  Promise<void> failed;
+  Future<void> after = failed.GetFuture().Then(&pool, []() {});
+  failed.SetError(Status(error::UNAVAILABLE, "disk gone"));
+  EXPECT_EQ(error::UNAVAILABLE, after.Get().error_code());
+}
+
+TEST(Future, WaitFromAnotherThread) {
+  ThreadPool pool(Env::Default(), "test", 1);
+  Promise<std::string> promise;
+  pool.Schedule([promise]() mutable {
+    Env::Default()->SleepForMicroseconds(10000);
+    promise.Set("done");
+  });
+  Future<std::string> f = promise.GetFuture();
+  f.Wait();
+  EXPECT_TRUE(f.ready());
+  EXPECT_EQ("done", f.value());
+}
+
+}  // namespace
+}  // namespace thread
+}  // namespace mr
@@ -0,0 +1,110 @@
+#include "core/base/hash.h"
+
+#include <stdint.h>
+
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+// Partitions are assigned with these, so they must never change.
+TEST(Hash64, Golden) {
+  struct {
+    const char* key;
+    uint64_t hash;
+    uint64_t seeded;  // With seed 42.
+  } const kGolden[] = {
+      {"", 0x93228a4de0eec5a2ULL, 0x2ac44db3deb05300ULL},
+      {"a", 0xaced12527fe5bff8ULL, 0x30dbb7b7a902ea66ULL},
+      {"abc", 0x989b4a209c1011c9ULL, 0xb0632d5ba93fcab5ULL},
+      {"abcd", 0x6d9a9834037410ebULL, 0xe5b66373cf3bac7fULL},
+      {"hello world!", 0xa070c479ac038445ULL, 0x235c6ce3b51d02e9ULL},
+      {"0123456789abcdef", 0x88de385a856cfb95ULL, 0x26f1de02f1a1183bULL},
+      {"0123456789abcdefg", 0x14f37288a5f8073aULL, 0xa5b441501b0f7420ULL},
+      {"The quick brown fox jumps over the lazy dog, again and again and "
+       "again.",
+       0x5f02c19838419a2eULL, 0xd80e42fa8ab5e0f5ULL},
+  };
+  for (const auto& g : kGolden) {
+    EXPECT_EQ(g.hash, Hash64(g.key)) << g.key;
+    EXPECT_EQ(g.seeded, Hash64(g.key, 42)) << g.key;
+  }
+  EXPECT_EQ(0xfa303abc2b1d7630ULL, HashInt64(0));
+  EXPECT_EQ(0x89c5d5dcf99150a7ULL, HashInt64(12345, 7));
+}
+
+TEST(Hash64, Distinct) {
+  // Every length, every single-bit change and every seed gives a new hash.
+  std::mt19937 rng(301);
+  std::string data(200, '\0');
+  for (char& c : data) c = static_cast<char>(rng());
+  std::set<uint64_t> hashes;
+  size_t count = 0;
+  for (size_t n = 0; n <= data.size(); ++n) {
+    StringPiece key(data.data(), n);
+    hashes.insert(Hash64(key));
+    hashes.insert(Hash64(key, 1));
+    count += 2;
+    for (size_t bit = 0; bit < 8 * n; bit += 7) {
+      std::string flipped(key.data(), n);
+      flipped[bit / 8] ^= 1 << (bit % 8);
+      hashes.insert(Hash64(flipped));
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, hashes.size());
+
+  // Flipping one input bit flips about half the output bits.
+  int flipped_bits = 0;
+  for (uint64_t i = 0; i < 64; ++i) {
+    flipped_bits += __builtin_popcountll(HashInt64(i) ^ HashInt64(i ^ 1));
+  }
+  EXPECT_NEAR(32 * 64, flipped_bits, 4 * 64);
+}
+
+TEST(Hash64, BatchesAndVariants) {
+  const std::vector<StringPiece> keys = {
+      "", "k", "key-0001", "a much longer key that takes the long path", "x"};
+  std::vector<uint64_t> hashes(keys.size());
+  Hash64Batch(keys, 9, &hashes);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(Hash64(keys[i], 9), hashes[i]);
+    const HashValue128 h = Hash128(keys[i], 9);
+    EXPECT_EQ(Hash64(keys[i], 9), h.low);
+    EXPECT_NE(h.low, h.high);
+  }
+
+  const std::vector<uint64_t> values = {0, 1, 2, ~0ULL};
+  HashInt64Batch(values, 3, gtl::MutableArraySlice<uint64_t>(&hashes[0], 4));
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(HashInt64(values[i], 3), hashes[i]);
+  }
+  EXPECT_NE(Hash64Combine(1, 2), Hash64Combine(2, 1));
+
+  std::unordered_set<std::string, Hasher> strings = {"a", "b"};
+  EXPECT_EQ(1, strings.count("a"));
+  std::unordered_set<int64_t, Hasher> ints = {-1, 1};
+  EXPECT_EQ(1, ints.count(-1));
+}
+
+TEST(ReduceHash, Uniform) {
+  const int kPartitions = 7;
+  std::vector<int> counts(kPartitions, 0);
+  for (int i = 0; i < 70000; ++i) {
+    const int p = ReduceHash(Hash64(std::to_string(i)), kPartitions);
+    ASSERT_GE(p, 0);
+    ASSERT_LT(p, kPartitions);
+    ++counts[p];
+  }
+  for (int c : counts) EXPECT_NEAR(10000, c, 500);
+}
+
+}  // namespace
+}  // namespace mr
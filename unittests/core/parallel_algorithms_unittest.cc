@@ -0,0 +1,113 @@
+#include "core/base/parallel_algorithms.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/base/threadpool.h"
+#include "core/system/env.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace thread {
+namespace {
+
+// Sizes below, at and well above the inline cutoff.
+const size_t kSizes[] = {0, 1, 100, 4096, 4097, 100000, 1000003};
+
+TEST(ParallelSort, MatchesStdSort) {
+  std::mt19937_64 rng(301);
+  for (int threads : {1, 4}) {
+    ThreadPool pool(Env::Default(), "test", threads);
+    for (size_t n : kSizes) {
+      for (uint64_t range : {uint64_t{16}, ~uint64_t{0}}) {
+        std::vector<uint64_t> data(n);
+        for (uint64_t& x : data) x = rng() % range;
+        std::vector<uint64_t> expected = data;
+        std::sort(expected.begin(), expected.end());
+        ParallelSort(&pool, gtl::MutableArraySlice<uint64_t>(&data));
+        ASSERT_EQ(expected, data) << "n " << n << " range " << range;
+      }
+    }
+  }
+}
+
+TEST(ParallelSort, ComparatorAndStrings) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  std::mt19937 rng(7);
+  std::vector<std::string> data(50000);
+  for (std::string& s : data) s = std::to_string(rng());
+  std::vector<std::string> expected = data;
+  std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+  ParallelSort(&pool, gtl::MutableArraySlice<std::string>(&data),
+               std::greater<std::string>());
+  EXPECT_EQ(expected, data);
+}
+
+TEST(ParallelReduce, Sum) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  for (size_t n : kSizes) {
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i) data[i] = i;
+    EXPECT_EQ(static_cast<int64_t>(n * (n - 1) / 2),
+              ParallelReduce(&pool, gtl::ArraySlice<int64_t>(data),
+                             int64_t{0}, std::plus<int64_t>()));
+  }
+}
+
+TEST(ParallelReduce, NonCommutative) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  std::vector<std::string> data(20000);
+  std::string expected;
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = std::string(1, 'a' + i % 26);
+    expected += data[i];
+  }
+  EXPECT_EQ(expected,
+            ParallelReduce(&pool, gtl::ArraySlice<std::string>(data),
+                           std::string(), std::plus<std::string>()));
+}
+
+TEST(ParallelScan, InclusivePrefixSum) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  for (size_t n : kSizes) {
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i) data[i] = i % 7;
+    std::vector<int64_t> expected(n);
+    std::partial_sum(data.begin(), data.end(), expected.begin());
+    std::vector<int64_t> out(n);
+    ParallelScan(&pool, gtl::ArraySlice<int64_t>(data),
+                 gtl::MutableArraySlice<int64_t>(&out), int64_t{0},
+                 std::plus<int64_t>());
+    EXPECT_EQ(expected, out);
+    // In place.
+    ParallelScan(&pool, gtl::ArraySlice<int64_t>(data),
+                 gtl::MutableArraySlice<int64_t>(&data), int64_t{0},
+                 std::plus<int64_t>());
+    EXPECT_EQ(expected, data);
+  }
+}
+
+TEST(ParallelTransform, Square) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  std::vector<int> data(100000);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = i;
+  std::vector<int64_t> out(data.size());
+  ParallelTransform(&pool, gtl::ArraySlice<int>(data),
+                    gtl::MutableArraySlice<int64_t>(&out),
+                    [](int x) { return int64_t{x} * x; });
+  for (size_t i = 0; i < data.size(); ++i) {
+    ASSERT_EQ(static_cast<int64_t>(i) * i, out[i]);
+  }
+}
+
+}  // namespace
+}  // namespace thread
+}  // namespace mr
@@ -0,0 +1,94 @@
+#include "core/base/task.h"
+
+#include <atomic>
+#include <string>
+
+#include "core/base/threadpool.h"
+#include "core/system/env.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace thread {
+namespace {
+
+// Coroutines need -std=c++20; under older standards there is nothing to
+// test.
+#ifdef MR_HAVE_COROUTINES
+
+Task<int> Add(int a, int b) { co_return a + b; }
+
+Task<int> Sum(int n) {
+  int total = 0;
+  for (int i = 0; i < n; ++i) total += co_await Add(i, 0);
+  co_return total;
+}
+
+TEST(Task, AwaitsTasks) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  // Each finished Task resumes its awaiter without growing the stack.
+  EXPECT_EQ(9999 * 10000 / 2, Start(&pool, Sum(10000)).value());
+}
+
+// Completes "promise" later on another thread, like an I/O callback.
+void CompleteLater(ThreadPool* io, Promise<std::string> promise,
+                   std::string value) {
+  io->Schedule([promise, value]() mutable {
+    Env::Default()->SleepForMicroseconds(1000);
+    promise.Set(value);
+  });
+}
+
+Task<Status> Pipeline(ThreadPool* pool, ThreadPool* io, int* worker) {
+  Promise<std::string> read;
+  CompleteLater(io, read, "data");
+  Future<std::string> data = co_await read.GetFuture();
+  CO_RETURN_IF_ERROR(data.status());
+  co_await ResumeOn(pool);
+  *worker = pool->CurrentThreadId();
+
+  Future<std::string> failed = co_await MakeErrorFuture<std::string>(
+      Status(error::UNAVAILABLE, "peer down"));
+  CO_RETURN_IF_ERROR(failed.status());
+  co_return Status::OK;
+}
+
+TEST(Task, AwaitsFuturesAndPropagatesErrors) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  ThreadPool io(Env::Default(), "io", 1);
+  int worker = -1;
+  Future<Status> done = Start(&pool, Pipeline(&pool, &io, &worker));
+  EXPECT_EQ(error::UNAVAILABLE, done.value().error_code());
+  EXPECT_GE(worker, 0);
+}
+
+Task<void> Increment(std::atomic<int>* counter) {
+  ++*counter;
+  co_return;
+}
+
+TEST(Task, Spawn) {
+  std::atomic<int> counter(0);
+  {
+    ThreadPool pool(Env::Default(), "test", 2);
+    for (int i = 0; i < 100; ++i) Spawn(&pool, Increment(&counter));
+  }
+  EXPECT_EQ(100, counter.load());
+}
+
+TEST(Task, StartVoid) {
+  ThreadPool pool(Env::Default(), "test", 2);
+  std::atomic<int> counter(0);
+  Future<void> done = Start(&pool, Increment(&counter));
+  EXPECT_OK(done.Get());
+  EXPECT_EQ(1, counter.load());
+}
+
+#else
+TEST(Task, NeedsCoroutines) {}
+#endif  // MR_HAVE_COROUTINES
+
+}  // namespace
+}  // namespace thread
+}  // namespace mr
@@ -1,8 +1,12 @@
 #include "core/base/threadpool.h"
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
+#include <string>
+#include <vector>
 
+#include "core/strings/strcat.h"
 #include "core/system/env.h"
 
 #include <glog/logging.h>
@@ -43,6 +47,121 @@ TEST(ThreadPool, DoWork) {
   }
 }
 
+TEST(ThreadPool, Stats) {
+  const int kThreads = 4;
+  const int kTasks = 10000;
+  ThreadPool pool(Env::Default(), "test", kThreads);
+  std::atomic<int> done(0);
+  for (int i = 0; i < kTasks; ++i) {
+    pool.Schedule([&done]() { done++; });
+  }
+  while (done.load() < kTasks) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  // Let the workers run out of work and go to sleep, then wake them.
+  Env::Default()->SleepForMicroseconds(100000);
+  for (int i = 0; i < kThreads; ++i) {
+    pool.Schedule([&done]() { done++; });
+  }
+  while (done.load() < kTasks + kThreads) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+
+  ThreadPool::Stats stats;
+  pool.GetStats(&stats);
+  ASSERT_EQ(kThreads, stats.workers.size());
+  uint64_t tasks = 0;
+  for (const auto& w : stats.workers) {
+    tasks += w.tasks_executed;
+    EXPECT_LE(w.steals_succeeded, w.steals_attempted);
+  }
+  // Tasks that could not be queued run inline on the caller.
+  EXPECT_LE(tasks, static_cast<uint64_t>(kTasks + kThreads));
+  EXPECT_EQ(tasks, stats.total.tasks_executed);
+  EXPECT_GT(stats.total.tasks_executed, 0u);
+  EXPECT_GT(stats.total.steals_attempted, 0u);
+  EXPECT_GT(stats.total.blocks, 0u);
+  EXPECT_GT(stats.total.blocked_nanos, 0u);
+
+  // One line per worker and one for the total, naming every counter.
+  const std::string debug = stats.DebugString();
+  EXPECT_EQ(kThreads + 1, std::count(debug.begin(), debug.end(), '\n'));
+  for (const char* field :
+       {"#0 ", "total ", "tasks=", "steals=", "spins=", "blocks=",
+        "blocked_ms=", "queue_mean=", "queue_max="}) {
+    EXPECT_NE(std::string::npos, debug.find(field)) << field;
+  }
+  EXPECT_NE(std::string::npos,
+            debug.find(strings::StrCat("tasks=", stats.total.tasks_executed)))
+      << debug;
+}
+
+TEST(ThreadPool, ParallelForCoversRangeOnce) {
+  for (int num_threads : {1, 2, 4}) {
+    ThreadPool pool(Env::Default(), "test", num_threads);
+    for (int64_t total : {0, 1, 7, 1000, 100000}) {
+      std::vector<std::atomic<int>> seen(total);
+      for (auto& v : seen) v = 0;
+      pool.ParallelFor(total, 1000, [&seen](int64_t first, int64_t last) {
+        ASSERT_LE(first, last);
+        for (int64_t i = first; i < last; ++i) seen[i]++;
+      });
+      for (int64_t i = 0; i < total; ++i) {
+        ASSERT_EQ(1, seen[i].load()) << "total " << total << " index " << i;
+      }
+    }
+  }
+}
+
+TEST(ThreadPool, NestedParallelForFromEveryWorker) {
+  // Every worker blocks in a nested ParallelFor whose blocks were queued
+  // on the workers themselves; waiting workers have to run them.
+  const int kThreads = 4;
+  ThreadPool pool(Env::Default(), "test", kThreads);
+  std::atomic<int64_t> sum(0);
+  std::atomic<int> done(0);
+  for (int i = 0; i < kThreads; ++i) {
+    pool.Schedule([&pool, &sum, &done]() {
+      pool.ParallelFor(1000, 100000, [&sum](int64_t first, int64_t last) {
+        sum += last - first;
+      });
+      done++;
+    });
+  }
+  while (done.load() < kThreads) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  EXPECT_EQ(kThreads * 1000, sum.load());
+}
+
+TEST(ThreadPool, ParallelForLearnsCost) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  // Far too low a guess: the first call runs inline, in a single block.
+  ThreadPool::CostEstimator estimator(1);
+  const int64_t kTotal = 64;
+  std::atomic<int> blocks(0);
+  std::atomic<int64_t> units(0);
+  auto fn = [&blocks, &units](int64_t first, int64_t last) {
+    blocks++;
+    units += last - first;
+    Env::Default()->SleepForMicroseconds(100 * (last - first));
+  };
+  pool.ParallelFor(kTotal, &estimator, fn);
+  EXPECT_EQ(1, blocks.load());
+  EXPECT_EQ(kTotal, units.load());
+  EXPECT_EQ(1u, estimator.samples());
+  // 100us per unit is about 300000 cycles.
+  EXPECT_GT(estimator.cost().compute_cycles(), 100000);
+
+  // With the measured cost the work is split over the threads.
+  blocks = 0;
+  units = 0;
+  pool.ParallelFor(kTotal, &estimator, fn);
+  EXPECT_GT(blocks.load(), 1);
+  EXPECT_EQ(kTotal, units.load());
+  EXPECT_EQ(2u, estimator.samples());
+}
+
 } // namespace thread
 
 } // namespace mr
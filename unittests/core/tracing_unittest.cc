@@ -0,0 +1,107 @@
+#include "core/system/tracing.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "core/base/threadpool.h"
+#include "core/system/context.h"
+#include "core/system/env.h"
+#include "core/strings/strcat.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace port {
+namespace {
+
+int CountOccurrences(const std::string& s, const std::string& what) {
+  int n = 0;
+  for (size_t pos = s.find(what); pos != std::string::npos;
+       pos = s.find(what, pos + 1)) {
+    ++n;
+  }
+  return n;
+}
+
+TEST(Context, WithContextRestores) {
+  EXPECT_EQ(0u, Context(ContextKind::kThread).trace_id());
+  Context c;
+  c.set_trace_id(42);
+  {
+    WithContext wc(c);
+    EXPECT_EQ(42u, Context(ContextKind::kThread).trace_id());
+    EXPECT_EQ(0u, Context(ContextKind::kDefault).trace_id());
+  }
+  EXPECT_EQ(0u, Context(ContextKind::kThread).trace_id());
+}
+
+TEST(Tracing, RecordsScheduleAndRunAcrossThreads) {
+  const int kParents = 10;
+  std::atomic<uint64_t> child_parent(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "trace", 2);
+    // Nothing is recorded while tracing is off.
+    pool.Schedule([]() {});
+
+    Tracing::Start();
+    std::atomic<int> done(0);
+    thread::ThreadPool* p = &pool;
+    for (int i = 0; i < kParents; ++i) {
+      pool.Schedule([p, i, &done, &child_parent]() {
+        const uint64_t self = Context(ContextKind::kThread).trace_id();
+        EXPECT_NE(0u, self);
+        p->Schedule([i, self, &done, &child_parent]() {
+          // The context of the parent closure travelled with the child.
+          if (i == 0) child_parent = self;
+          done++;
+        });
+        done++;
+      });
+    }
+    while (done.load() < 2 * kParents) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    Tracing::Stop();
+    pool.Schedule([]() {});
+    // Destroying the pool waits for the last runs to be recorded.
+  }
+
+  const std::string trace = Tracing::ExportChromeTrace();
+  EXPECT_EQ(0u, trace.find("{\"displayTimeUnit\""));
+  EXPECT_EQ(2 * kParents, CountOccurrences(trace, "\"name\":\"RunClosure\""));
+  EXPECT_EQ(2 * kParents,
+            CountOccurrences(trace, "\"name\":\"ScheduleClosure\""));
+  EXPECT_EQ(2 * kParents, CountOccurrences(trace, "\"ph\":\"s\""));
+  EXPECT_EQ(2 * kParents, CountOccurrences(trace, "\"ph\":\"f\""));
+  // The child was scheduled from inside its parent's run.
+  EXPECT_NE(std::string::npos,
+            trace.find(strings::StrCat("\"parent\":", child_parent.load(),
+                                       "}")));
+
+  // Start() discards earlier events.
+  Tracing::Start();
+  Tracing::Stop();
+  EXPECT_EQ(0, CountOccurrences(Tracing::ExportChromeTrace(), "RunClosure"));
+}
+
+TEST(Tracing, ReusesBuffersOfExitedThreads) {
+  Tracing::Start();
+  for (int i = 0; i < 10; ++i) {
+    std::thread t([]() {
+      Tracing::RecordEvent(Tracing::EventCategory::kScheduleClosure,
+                           Tracing::UniqueId());
+    });
+    t.join();
+  }
+  Tracing::Stop();
+  const std::string trace = Tracing::ExportChromeTrace();
+  EXPECT_EQ(10, CountOccurrences(trace, "\"name\":\"ScheduleClosure\""));
+  // Each thread took over the buffer of the one before.
+  EXPECT_EQ(1, CountOccurrences(trace, "\"name\":\"thread_name\""));
+}
+
+}  // namespace
+}  // namespace port
+}  // namespace mr
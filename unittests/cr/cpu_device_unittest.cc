@@ -0,0 +1,197 @@
+#include "cr/cpu_device.h"
+
+#include <errno.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/strings/strcat.h"
+#include "core/system/numa.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+// Sums [0, n) with ParallelFor.
+class SumKernel : public OpKernel {
+ public:
+  explicit SumKernel(int64_t n) : OpKernel("sum"), n_(n), sum_(0) {}
+
+  void Compute(OpKernelContext* context) override {
+    EXPECT_GE(context->device()->cpu_worker_threads()->workers
+                  ->CurrentThreadId(), 0);
+    context->ParallelFor(n_, 100, [this](int64_t first, int64_t last) {
+      int64_t local = 0;
+      for (int64_t i = first; i < last; ++i) local += i;
+      sum_ += local;
+    });
+  }
+
+  int64_t sum() const { return sum_; }
+
+ private:
+  const int64_t n_;
+  std::atomic<int64_t> sum_;
+};
+
+class FailingKernel : public OpKernel {
+ public:
+  FailingKernel() : OpKernel("fail") {}
+  void Compute(OpKernelContext* context) override {
+    OP_REQUIRES_OK(context, Status(error::INTERNAL, "boom"));
+    ADD_FAILURE() << "OP_REQUIRES_OK did not return";
+  }
+};
+
+NumaNode Node(int id, const std::vector<int>& cpus, int64_t memory_bytes) {
+  NumaNode node;
+  node.id = id;
+  node.cpus = cpus;
+  node.memory_bytes = memory_bytes;
+  return node;
+}
+
+TEST(CPUDevice, RunsKernelsOnWorkers) {
+  DeviceAttributes attributes =
+      CPUDeviceFactory::BuildAttributes("/cpu:0", Node(0, {0}, 0));
+  CPUDevice device(Env::Default(), attributes, 4, ThreadOptions());
+  EXPECT_EQ(4, device.cpu_worker_threads()->num_threads);
+
+  SumKernel a(100000), b(1000);
+  EXPECT_OK(device.RunKernels({&a, &b}));
+  EXPECT_EQ(100000LL * 99999 / 2, a.sum());
+  EXPECT_EQ(1000 * 999 / 2, b.sum());
+
+  FailingKernel fail;
+  SumKernel never(10);
+  Status s = device.RunKernels({&fail, &never});
+  EXPECT_EQ(error::INTERNAL, s.error_code());
+  EXPECT_EQ(0, never.sum());
+}
+
+TEST(CPUDeviceFactory, OneDevicePerNumaNode) {
+  std::vector<NumaNode> nodes = {Node(0, {0, 1, 2, 3}, 1LL << 30),
+                                 Node(1, {4, 5, 6, 7, 9}, 2LL << 30),
+                                 Node(2, {8}, 0)};
+  SessionOptions options;
+  std::vector<Device*> devices;
+  EXPECT_OK(CPUDeviceFactory::CreateDevices(
+      options, "/job:localhost/replica:0/task:0", nodes, &devices));
+  ASSERT_EQ(3, devices.size());
+  std::vector<std::unique_ptr<Device>> owned(devices.begin(), devices.end());
+
+  const DeviceAttributes& a0 = devices[0]->attributes();
+  EXPECT_EQ("/job:localhost/replica:0/task:0/cpu:0", a0.name());
+  EXPECT_EQ("CPU", a0.device_type());
+  EXPECT_EQ(1LL << 30, a0.memory_limit());
+  EXPECT_EQ(BUS_0, a0.bus_adjacency());
+  EXPECT_NE(0u, a0.incarnation());
+  EXPECT_EQ("numa_node: 0, cpus: 0-3", a0.physical_device_desc());
+  EXPECT_EQ(4, devices[0]->cpu_worker_threads()->num_threads);
+
+  const DeviceAttributes& a1 = devices[1]->attributes();
+  EXPECT_EQ("/job:localhost/replica:0/task:0/cpu:1", a1.name());
+  EXPECT_EQ(BUS_1, a1.bus_adjacency());
+  EXPECT_NE(a0.incarnation(), a1.incarnation());
+  EXPECT_EQ("numa_node: 1, cpus: 4-7,9", a1.physical_device_desc());
+  EXPECT_EQ(BUS_ANY, devices[2]->attributes().bus_adjacency());
+
+  (*options.config.mutable_device_count())["CPU"] = 1;
+  std::vector<Device*> capped;
+  EXPECT_OK(CPUDeviceFactory::CreateDevices(options, "", nodes, &capped));
+  ASSERT_EQ(1, capped.size());
+  delete capped[0];
+}
+
+TEST(CPUDeviceFactory, LocalMachine) {
+  SessionOptions options;
+  std::vector<Device*> devices;
+  EXPECT_OK(CPUDeviceFactory::CreateDevices(options, "", &devices));
+  ASSERT_GE(devices.size(), 1);
+  std::vector<std::unique_ptr<Device>> owned(devices.begin(), devices.end());
+  SumKernel kernel(1000);
+  EXPECT_OK(static_cast<CPUDevice*>(devices[0])->RunKernels({&kernel}));
+  EXPECT_EQ(1000 * 999 / 2, kernel.sum());
+}
+
+// A new directory under $TMPDIR or /tmp, deleted with everything in it at
+// the end of the scope.  path() is empty if it could not be created.
+class ScopedTempDir {
+ public:
+  explicit ScopedTempDir(const string& prefix) {
+    const char* tmp = getenv("TMPDIR");
+    string dir_template = strings::StrCat(tmp != nullptr ? tmp : "/tmp", "/",
+                                          prefix, "XXXXXX");
+    if (mkdtemp(&dir_template[0]) != nullptr) path_ = dir_template;
+  }
+  ~ScopedTempDir() {
+    if (path_.empty()) return;
+    // Children before their directory; symlinks are not followed.
+    EXPECT_EQ(0, nftw(path_.c_str(),
+                      [](const char* path, const struct stat*, int,
+                         struct FTW*) { return remove(path); },
+                      16, FTW_DEPTH | FTW_PHYS))
+        << path_ << ": " << strerror(errno);
+  }
+
+  const string& path() const { return path_; }
+
+ private:
+  string path_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTempDir);
+};
+
+void WriteFile(const string& fname, const string& contents) {
+  FILE* f = fopen(fname.c_str(), "w");
+  ASSERT_TRUE(f != nullptr);
+  fwrite(contents.data(), 1, contents.size(), f);
+  fclose(f);
+}
+
+TEST(Numa, ReadsSysTopology) {
+  std::vector<int> cpus;
+  EXPECT_TRUE(ParseCpuList("0-2,5,7-8\n", &cpus));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 5, 7, 8}), cpus);
+  EXPECT_TRUE(ParseCpuList("\n", &cpus));
+  EXPECT_TRUE(cpus.empty());
+  EXPECT_FALSE(ParseCpuList("3-1", &cpus));
+  EXPECT_FALSE(ParseCpuList("1,x", &cpus));
+
+  ScopedTempDir temp_dir("numa_test");
+  ASSERT_FALSE(temp_dir.path().empty()) << strerror(errno);
+  const string& dir = temp_dir.path();
+  mkdir((dir + "/node1").c_str(), 0755);
+  mkdir((dir + "/node0").c_str(), 0755);
+  mkdir((dir + "/node2").c_str(), 0755);
+  mkdir((dir + "/possible").c_str(), 0755);
+  WriteFile(dir + "/node0/cpulist", "0-1\n");
+  WriteFile(dir + "/node0/meminfo",
+            "Node 0 MemTotal:       1024 kB\nNode 0 MemFree: 12 kB\n");
+  WriteFile(dir + "/node1/cpulist", "2,3\n");
+  // A memory-only node is skipped.
+  WriteFile(dir + "/node2/cpulist", "\n");
+
+  std::vector<NumaNode> nodes = GetNumaNodes(dir);
+  ASSERT_EQ(2, nodes.size());
+  EXPECT_EQ(0, nodes[0].id);
+  EXPECT_EQ(std::vector<int>({0, 1}), nodes[0].cpus);
+  EXPECT_EQ(1024 * 1024, nodes[0].memory_bytes);
+  EXPECT_EQ(1, nodes[1].id);
+  EXPECT_EQ(std::vector<int>({2, 3}), nodes[1].cpus);
+  EXPECT_EQ(0, nodes[1].memory_bytes);
+
+  EXPECT_FALSE(GetNumaNodes().empty());
+}
+
+}  // namespace
+}  // namespace mr
@@ -0,0 +1,71 @@
+#include "cr/device_mgr.h"
+
+#include <vector>
+
+#include "cr/cpu_device.h"
+#include "core/system/numa.h"
+#include "dr/master_env.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+NumaNode Node(int id, const std::vector<int>& cpus) {
+  NumaNode node;
+  node.id = id;
+  node.cpus = cpus;
+  node.memory_bytes = 1 << 30;
+  return node;
+}
+
+TEST(DeviceMgr, LookupByName) {
+  SessionOptions options;
+  std::vector<Device*> devices;
+  EXPECT_OK(CPUDeviceFactory::CreateDevices(
+      options, "/job:worker/replica:0/task:1",
+      {Node(0, {0}), Node(1, {0}), Node(2, {0})}, &devices));
+  DeviceMgr mgr(devices);
+  EXPECT_EQ(3, mgr.ListDevices().size());
+  EXPECT_EQ(3, mgr.NumDeviceType("CPU"));
+  EXPECT_EQ(0, mgr.NumDeviceType("GPU"));
+
+  Device* d = nullptr;
+  EXPECT_OK(mgr.LookupDevice("/job:worker/replica:0/task:1/cpu:1", &d));
+  EXPECT_EQ(devices[1], d);
+  EXPECT_OK(mgr.LookupDevice("cpu:2", &d));
+  EXPECT_EQ(devices[2], d);
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            mgr.LookupDevice("cpu:3", &d).error_code());
+
+  std::vector<Device*> bus1 = mgr.ListDevicesOnBus(BUS_1);
+  ASSERT_EQ(1, bus1.size());
+  EXPECT_EQ(devices[1], bus1[0]);
+
+  std::vector<DeviceAttributes> attributes;
+  mgr.ListDeviceAttributes(&attributes);
+  ASSERT_EQ(3, attributes.size());
+  EXPECT_EQ(1 << 30, attributes[2].memory_limit());
+  EXPECT_EQ(BUS_ANY, attributes[2].bus_adjacency());
+  EXPECT_NE(0u, attributes[0].incarnation());
+}
+
+TEST(DeviceMgr, NewLocal) {
+  std::unique_ptr<DeviceMgr> mgr;
+  EXPECT_OK(DeviceMgr::NewLocal(SessionOptions(),
+                                "/job:localhost/replica:0/task:0", &mgr));
+  MasterEnv env;
+  env.local_devices = mgr->ListDevices();
+  env.device_mgr = mgr.get();
+  ASSERT_GE(env.local_devices.size(), 1);
+  Device* d = nullptr;
+  EXPECT_OK(env.device_mgr->LookupDevice("cpu:0", &d));
+  EXPECT_EQ(env.local_devices[0], d);
+  EXPECT_EQ(BUS_0, d->attributes().bus_adjacency());
+  EXPECT_GT(d->attributes().memory_limit(), 0);
+  LOG(INFO) << mgr->DebugString();
+}
+
+}  // namespace
+}  // namespace mr
@@ -2,6 +2,7 @@
 #include "protobuf/mr_server.pb.h"
 
 #include "core/base/logging.h"
+#include "core/strings/split.h"
 #include "core/strings/str_util.h"
 #include "core/strings/strcat.h"
 #include "core/strings/numbers.h"
@@ -20,16 +21,17 @@ Status ParseFlagsForTask(int argc, char* argv[], ServerDef* options) {
   int task_index = 0;
   int i = 1;
   while (i < argc) {
-    std::vector<std::string> kv = str_util::Split(argv[i], ',');
+    const auto kv_pieces = str_util::SplitPieces(argv[i], ',');
+    const std::vector<StringPiece> kv(kv_pieces.begin(), kv_pieces.end());
     if (kv[0] == "--cluster_spec") {
-      cluster_spec = kv[1];
+      cluster_spec = kv[1].ToString();
     } else if (kv[0] == "job_name") {
-      *options->mutable_job_name() = kv[1]; 
+      *options->mutable_job_name() = kv[1].ToString(); 
     } else if (kv[0] == "task_id") {
        strings::safe_strto32(kv[1], &task_index);
     } else {
       return Status(error::INVALID_ARGUMENT,
-		      "Commandline option error: " + kv[0]);
+		      "Commandline option error: " + kv[0].ToString());
     }
     ++i;
   }
@@ -39,12 +41,13 @@ Status ParseFlagsForTask(int argc, char* argv[], ServerDef* options) {
 
   ClusterDef* const cluster = options->mutable_cluster();
 
-  for (std::string& job_str : str_util::Split(cluster_spec, ',')) {
+  for (StringPiece job_str : str_util::SplitPieces(cluster_spec, ',')) {
     JobDef* const job_def = cluster->add_job();
-    const std::vector<std::string> job_pieces = 
-	    str_util::Split(job_str, '|');
+    const auto job_range = str_util::SplitPieces(job_str, '|');
+    const std::vector<StringPiece> job_pieces(job_range.begin(),
+					      job_range.end());
     DCHECK_EQ(2, job_pieces.size()) << job_str;
-    const std::string& job_name = job_pieces[0];
+    const std::string job_name = job_pieces[0].ToString();
     job_def->set_name(job_name);
 
     const StringPiece spec = job_pieces[1];
@@ -0,0 +1,132 @@
+#include "framework/allocator.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "cr/device.h"
+#include "core/files/file_system.h"
+#include "core/system/env.h"
+#include "framework/map_output_buffer.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+TEST(TrackingAllocator, CountsBytesAndPeak) {
+  TrackingAllocator a("test", cpu_allocator(), 0);
+  EXPECT_TRUE(a.TracksAllocationSizes());
+  std::vector<char*> ptrs;
+  for (int i = 1; i <= 10; ++i) {
+    char* p = a.Allocate<char>(i * 100);
+    ASSERT_TRUE(p != nullptr);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) %
+                      Allocator::kAllocatorAlignment);
+    EXPECT_EQ(i * 100u, a.RequestedSize(p));
+    memset(p, i, i * 100);
+    ptrs.push_back(p);
+  }
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(10, stats.num_allocs);
+  EXPECT_EQ(5500, stats.bytes_in_use);
+  EXPECT_EQ(5500, stats.max_bytes_in_use);
+  EXPECT_EQ(1000, stats.max_alloc_size);
+  EXPECT_EQ(0, stats.bytes_limit);
+
+  for (char* p : ptrs) a.Deallocate(p);
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(5500, stats.max_bytes_in_use);
+}
+
+TEST(TrackingAllocator, EnforcesLimit) {
+  TrackingAllocator a("limited", cpu_allocator(), 1000);
+  void* p = a.AllocateRaw(64, 600);
+  ASSERT_TRUE(p != nullptr);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % 64);
+  EXPECT_TRUE(a.AllocateRaw(64, 600) == nullptr);
+  void* q = a.AllocateRaw(1, 400);
+  ASSERT_TRUE(q != nullptr);
+  EXPECT_TRUE(a.AllocateRaw(1, 1) == nullptr);
+  a.DeallocateRaw(p);
+  p = a.AllocateRaw(8, 600);
+  EXPECT_TRUE(p != nullptr);
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(3, stats.num_allocs);
+  EXPECT_EQ(2, stats.num_failed_allocs);
+  EXPECT_EQ(1000, stats.bytes_in_use);
+  EXPECT_EQ(1000, stats.bytes_limit);
+  a.DeallocateRaw(p);
+  a.DeallocateRaw(q);
+  EXPECT_EQ(0, a.bytes_in_use());
+}
+
+TEST(TrackingAllocator, TryAllocateCountsRefusals) {
+  TrackingAllocator a("limited", cpu_allocator(), 1000);
+  EXPECT_TRUE(a.TryAllocate<char>(2000) == nullptr);
+  char* p = a.TryAllocate<char>(1000);
+  ASSERT_TRUE(p != nullptr);
+  EXPECT_EQ(1000, a.bytes_in_use());
+  a.Deallocate(p);
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(1, stats.num_allocs);
+  EXPECT_EQ(1, stats.num_failed_allocs);
+}
+
+TEST(Device, AllocatorUsesMemoryLimit) {
+  DeviceAttributes attributes;
+  attributes.set_name("/job:localhost/replica:0/task:0/cpu:0");
+  attributes.set_device_type("CPU");
+  attributes.set_memory_limit(1 << 20);
+  Device device(Env::Default(), attributes);
+  Allocator* a = device.GetAllocator();
+  EXPECT_EQ(attributes.name(), a->Name());
+  EXPECT_TRUE(a->Allocate<char>(2 << 20) == nullptr);
+  char* p = a->Allocate<char>(1 << 19);
+  EXPECT_TRUE(p != nullptr);
+  a->Deallocate(p);
+}
+
+class NullWritableFile : public WritableFile {
+ public:
+  Status Append(const StringPiece& data) override { return Status::OK; }
+  Status Close() override { return Status::OK; }
+  Status Flush() override { return Status::OK; }
+  Status Sync() override { return Status::OK; }
+};
+
+TEST(MapOutputBuffer, ShrinksBufferUnderMemoryLimit) {
+  TrackingAllocator a("limited", cpu_allocator(), 1 << 20);
+  MapOutputBuffer::Options options;
+  options.buffer_bytes = 4 << 20;
+  options.allocator = &a;
+  options.new_spill_file = [](int, std::unique_ptr<WritableFile>* file) {
+    file->reset(new NullWritableFile);
+    return Status::OK;
+  };
+  {
+    MapOutputBuffer buffer(options);
+    EXPECT_OK(buffer.Collect("key", "value"));
+    EXPECT_LE(buffer.buffer_capacity(), 1u << 20);
+    EXPECT_GE(buffer.buffer_capacity(), MapOutputBuffer::kMinBufferBytes);
+    EXPECT_EQ(static_cast<int64_t>(buffer.buffer_capacity()),
+              a.bytes_in_use());
+
+    // The whole limit is taken; a second buffer cannot get any memory.
+    MapOutputBuffer starved(options);
+    EXPECT_EQ(error::RESOURCE_EXHAUSTED,
+              starved.Collect("key", "value").error_code());
+  }
+  EXPECT_EQ(0, a.bytes_in_use());
+}
+
+}  // namespace
+}  // namespace mr
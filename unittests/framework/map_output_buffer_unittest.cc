@@ -0,0 +1,291 @@
+#include "framework/map_output_buffer.h"
+
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "core/base/threadpool.h"
+#include "core/strings/numbers.h"
+#include "core/strings/strcat.h"
+#include "core/system/env.h"
+#include "framework/device_base.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+class StringWritableFile : public WritableFile {
+ public:
+  explicit StringWritableFile(string* dst) : dst_(dst) {}
+  Status Append(const StringPiece& data) override {
+    dst_->append(data.data(), data.size());
+    return Status::OK;
+  }
+  Status Close() override { return Status::OK; }
+  Status Flush() override { return Status::OK; }
+  Status Sync() override { return Status::OK; }
+
+ private:
+  string* dst_;
+};
+
+// Keeps the contents of every spill file in memory.
+struct SpillFiles {
+  std::mutex mu;
+  std::map<int, string> files;
+
+  MapOutputBuffer::SpillFileFactory Factory() {
+    return [this](int index, std::unique_ptr<WritableFile>* file) {
+      std::lock_guard<std::mutex> l(mu);
+      if (files.count(index)) {
+        return Status(error::ALREADY_EXISTS, "spill reused");
+      }
+      file->reset(new StringWritableFile(&files[index]));
+      return Status::OK;
+    };
+  }
+};
+
+// Decodes partition "p" of a spill into key -> values.
+std::multimap<string, string> ReadPartition(const string& file,
+                                            const SpillInfo& info, int p) {
+  std::multimap<string, string> result;
+  StringPiece input(file.data() + info.partition_offsets[p],
+                    info.partition_offsets[p + 1] - info.partition_offsets[p]);
+  StringPiece key, value, prev;
+  while (!input.empty()) {
+    EXPECT_TRUE(MapOutputBuffer::ReadRecord(&input, &key, &value));
+    EXPECT_LE(prev, key);
+    prev = key;
+    result.emplace(key.ToString(), value.ToString());
+  }
+  return result;
+}
+
+void SumCombiner(StringPiece key, gtl::ArraySlice<StringPiece> values,
+                 string* combined) {
+  int64_t sum = 0;
+  for (StringPiece v : values) {
+    int64_t x;
+    CHECK(strings::safe_strto64(v, &x));
+    sum += x;
+  }
+  *combined = strings::StrCat(sum);
+}
+
+TEST(MapOutputBuffer, SortsWithinPartitions) {
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.num_partitions = 3;
+  options.partitioner = [](StringPiece key, int n) {
+    return static_cast<unsigned char>(key[0]) % n;
+  };
+  options.new_spill_file = files.Factory();
+  MapOutputBuffer buffer(options);
+  const char* keys[] = {"d", "a", "c", "b", "f", "e", "a"};
+  for (const char* k : keys) {
+    EXPECT_OK(buffer.Collect(k, "1"));
+  }
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(buffer.Flush(&spills));
+  ASSERT_EQ(1, spills.size());
+  EXPECT_EQ(7, spills[0].num_records);
+  ASSERT_EQ(4, spills[0].partition_offsets.size());
+  size_t total = 0;
+  for (int p = 0; p < 3; ++p) {
+    auto records = ReadPartition(files.files[0], spills[0], p);
+    for (const auto& r : records) {
+      EXPECT_EQ(p, static_cast<unsigned char>(r.first[0]) % 3);
+    }
+    total += records.size();
+  }
+  EXPECT_EQ(7, total);
+}
+
+TEST(MapOutputBuffer, SortsKeysSharingPrefixes) {
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.new_spill_file = files.Factory();
+  MapOutputBuffer buffer(options);
+  // Equal first 8 bytes, keys shorter and longer than 8 bytes, and keys
+  // ending in zero bytes.
+  const string keys[] = {"prefix00b", "prefix00", "prefix00a",
+                         string("prefix00\0", 9), "prefix0", "prefix00a",
+                         string("pre\0", 4), "pre", "prefix00ab"};
+  for (const string& k : keys) {
+    EXPECT_OK(buffer.Collect(k, "1"));
+  }
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(buffer.Flush(&spills));
+  ASSERT_EQ(1, spills.size());
+  // ReadPartition checks the order.
+  EXPECT_EQ(9, ReadPartition(files.files[0], spills[0], 0).size());
+}
+
+TEST(MapOutputBuffer, SpillsWhenFullAndCombines) {
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.num_partitions = 2;
+  options.buffer_bytes = 64;
+  options.combiner = SumCombiner;
+  options.new_spill_file = files.Factory();
+  MapOutputBuffer buffer(options);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_OK(buffer.Collect(strings::StrCat("k", i % 4), "2"));
+  }
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(buffer.Flush(&spills));
+  EXPECT_GT(spills.size(), 1);
+
+  std::map<string, int64_t> sums;
+  for (const SpillInfo& info : spills) {
+    for (int p = 0; p < 2; ++p) {
+      for (const auto& r : ReadPartition(files.files[info.spill_index], info,
+                                         p)) {
+        int64_t x;
+        ASSERT_TRUE(strings::safe_strto64(r.second, &x));
+        sums[r.first] += x;
+      }
+    }
+    // The combiner leaves at most one record per key in a spill.
+    EXPECT_LE(info.num_records, 4);
+  }
+  ASSERT_EQ(4, sums.size());
+  for (const auto& s : sums) EXPECT_EQ(50, s.second);
+}
+
+TEST(MapOutputBuffer, OversizedRecord) {
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.num_partitions = 4;
+  options.buffer_bytes = 16;
+  options.new_spill_file = files.Factory();
+  MapOutputBuffer buffer(options);
+  EXPECT_OK(buffer.Collect("small", "v"));
+  const string big(100, 'x');
+  EXPECT_OK(buffer.Collect("big", big));
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(buffer.Flush(&spills));
+  ASSERT_EQ(2, spills.size());
+  int found = 0;
+  for (int p = 0; p < 4; ++p) {
+    for (const auto& r : ReadPartition(files.files[1], spills[1], p)) {
+      EXPECT_EQ("big", r.first);
+      EXPECT_EQ(big, r.second);
+      ++found;
+    }
+  }
+  EXPECT_EQ(1, found);
+}
+
+TEST(MapOutputBuffer, RejectsRecordsOf4GiB) {
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.new_spill_file = files.Factory();
+  MapOutputBuffer buffer(options);
+  // Rejected before a byte is read, so the pieces need no backing memory.
+  const char data[] = "x";
+  const StringPiece huge(data, size_t{1} << 32);
+  EXPECT_EQ(error::INVALID_ARGUMENT, buffer.Collect(huge, "v").error_code());
+  EXPECT_EQ(error::INVALID_ARGUMENT, buffer.Collect("k", huge).error_code());
+  EXPECT_OK(buffer.Collect("k", StringPiece(data, 1)));
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(buffer.Flush(&spills));
+  ASSERT_EQ(1, spills.size());
+  EXPECT_EQ(1, spills[0].num_records);
+}
+
+TEST(MapOutputCollector, ParallelCollect) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  DeviceBase::CpuWorkerThreads workers;
+  workers.num_threads = pool.NumThreads();
+  workers.workers = &pool;
+  DeviceBase device(Env::Default());
+  device.set_cpu_worker_threads(&workers);
+
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.num_partitions = 8;
+  options.buffer_bytes = 4096;
+  options.combiner = SumCombiner;
+  options.new_spill_file = files.Factory();
+  MapOutputCollector collector(&device, options);
+
+  const int64_t kRecords = 100000;
+  EXPECT_OK(collector.ParallelCollect(
+      kRecords, 1000,
+      [](int64_t first, int64_t last, MapOutputBuffer* buffer) {
+        for (int64_t i = first; i < last; ++i) {
+          RETURN_IF_ERROR(buffer->Collect(strings::StrCat("key", i % 97), "1"));
+        }
+        return Status::OK;
+      }));
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(collector.Flush(&spills));
+
+  int64_t total = 0;
+  for (const SpillInfo& info : spills) {
+    for (int p = 0; p < 8; ++p) {
+      for (const auto& r :
+           ReadPartition(files.files[info.spill_index], info, p)) {
+        int64_t x;
+        ASSERT_TRUE(strings::safe_strto64(r.second, &x));
+        total += x;
+      }
+    }
+  }
+  EXPECT_EQ(kRecords, total);
+}
+
+TEST(MapOutputCollector, NestedParallelForNeverSharesBuffer) {
+  thread::ThreadPool pool(Env::Default(), "test", 2);
+  DeviceBase::CpuWorkerThreads workers;
+  workers.num_threads = pool.NumThreads();
+  workers.workers = &pool;
+  DeviceBase device(Env::Default());
+  device.set_cpu_worker_threads(&workers);
+
+  SpillFiles files;
+  MapOutputBuffer::Options options;
+  options.num_partitions = 2;
+  options.new_spill_file = files.Factory();
+  MapOutputCollector collector(&device, options);
+
+  // Blocks wait on a nested ParallelFor, so a waiting worker may run
+  // another block of the collect; no two blocks may hold one buffer.
+  std::mutex mu;
+  std::set<MapOutputBuffer*> active;
+  const int64_t kBlocks = 64;
+  EXPECT_OK(collector.ParallelCollect(
+      kBlocks, 10000000,
+      [&pool, &mu, &active](int64_t first, int64_t last,
+                            MapOutputBuffer* buffer) {
+        {
+          std::lock_guard<std::mutex> l(mu);
+          EXPECT_TRUE(active.insert(buffer).second);
+        }
+        for (int64_t i = first; i < last; ++i) {
+          RETURN_IF_ERROR(buffer->Collect(strings::StrCat("key", i), "1"));
+          pool.ParallelFor(8, 10000000, [](int64_t, int64_t) {
+            Env::Default()->SleepForMicroseconds(100);
+          });
+        }
+        std::lock_guard<std::mutex> l(mu);
+        active.erase(buffer);
+        return Status::OK;
+      }));
+  std::vector<SpillInfo> spills;
+  EXPECT_OK(collector.Flush(&spills));
+  int64_t records = 0;
+  for (const SpillInfo& info : spills) {
+    for (int p = 0; p < 2; ++p) {
+      records += ReadPartition(files.files[info.spill_index], info, p).size();
+    }
+  }
+  EXPECT_EQ(kBlocks, records);
+}
+
+}  // namespace
+}  // namespace mr
@@ -0,0 +1,141 @@
+#include "core/io/delimited_text.h"
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/io/zero_copy_stream_impl_lite.h"
+#include "core/strings/strcat.h"
+#include "core/system/env.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace io {
+namespace {
+
+typedef std::vector<std::vector<std::string>> Records;
+
+// Reads all of "text", handed out "block_size" bytes at a time.
+Status ReadAll(const std::string& text, int block_size,
+               const DelimitedTextOptions& options, Records* records) {
+  ArrayInputStream input(text.data(), text.size(), block_size);
+  DelimitedTextReader reader(&input, options);
+  std::vector<StringPiece> fields;
+  Status s;
+  while ((s = reader.ReadRecord(&fields)).ok()) {
+    records->emplace_back();
+    for (StringPiece f : fields) records->back().push_back(f.ToString());
+  }
+  if (s.error_code() == error::OUT_OF_RANGE) return Status::OK;
+  return s;
+}
+
+TEST(DelimitedTextReader, Csv) {
+  const std::string text =
+      "plain,\"with, comma\",\"say \"\"hi\"\"\",\n"
+      "\"multi\nline\",x\r\n"
+      "\n"
+      "a\"b,\"\"\n"
+      "last,\"\"\"\"";
+  const Records expected = {{"plain", "with, comma", "say \"hi\"", ""},
+                            {"multi\nline", "x"},
+                            {""},
+                            {"a\"b", ""},
+                            {"last", "\""}};
+  // Every block size makes records straddle buffers at every offset.
+  for (int block_size = 1; block_size <= static_cast<int>(text.size());
+       ++block_size) {
+    Records records;
+    EXPECT_OK(ReadAll(text, block_size, DelimitedTextOptions(), &records));
+    EXPECT_EQ(expected, records) << "block size " << block_size;
+  }
+}
+
+TEST(DelimitedTextReader, TsvWithoutQuoting) {
+  DelimitedTextOptions options;
+  options.delimiter = '\t';
+  options.quote = '\0';
+  Records records;
+  EXPECT_OK(ReadAll("\"a\"\tb\n\tc\t\n", 3, options, &records));
+  EXPECT_EQ(Records({{"\"a\"", "b"}, {"", "c", ""}}), records);
+}
+
+TEST(DelimitedTextReader, Errors) {
+  Records records;
+  Status s = ReadAll("a,b\n\"open,c\n", -1, DelimitedTextOptions(), &records);
+  EXPECT_EQ(error::INVALID_ARGUMENT, s.error_code());
+  EXPECT_EQ(1u, records.size());
+  records.clear();
+  s = ReadAll("\"quoted\"junk\n", 4, DelimitedTextOptions(), &records);
+  EXPECT_EQ(error::INVALID_ARGUMENT, s.error_code());
+}
+
+// About "size" bytes of CSV with quoted delimiters, quotes and newlines.
+std::string MakeCsv(size_t size, int* num_records) {
+  std::mt19937 rng(301);
+  std::string text;
+  *num_records = 0;
+  while (text.size() < size) {
+    for (int f = 0; f < 4; ++f) {
+      if (f > 0) text += ',';
+      switch (rng() % 4) {
+        case 0:
+          text += "\"q,\"\"\n\"";
+          break;
+        case 1:
+          text += "\"\"";
+          break;
+        default:
+          text += strings::StrCat(rng());
+      }
+    }
+    text += (rng() % 2) ? "\n" : "\r\n";
+    ++*num_records;
+  }
+  return text;
+}
+
+TEST(DelimitedText, ParseInParallel) {
+  int num_records;
+  const std::string text = MakeCsv(2 << 20, &num_records);
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  EXPECT_GT(SplitDelimitedTextChunks(&pool, text, 16, DelimitedTextOptions())
+                .size(),
+            1u);
+
+  Records sequential;
+  EXPECT_OK(ReadAll(text, 4096, DelimitedTextOptions(), &sequential));
+  ASSERT_EQ(num_records, sequential.size());
+
+  std::vector<Records> chunks(64);
+  EXPECT_OK(ParseDelimitedTextInParallel(
+      &pool, text, DelimitedTextOptions(),
+      [&chunks](int chunk, gtl::ArraySlice<StringPiece> fields) {
+        std::vector<std::string> record;
+        for (StringPiece f : fields) record.push_back(f.ToString());
+        chunks[chunk].push_back(record);
+        return Status::OK;
+      }));
+  Records parallel;
+  for (const Records& chunk : chunks) {
+    parallel.insert(parallel.end(), chunk.begin(), chunk.end());
+  }
+  EXPECT_TRUE(sequential == parallel);
+
+  std::atomic<int> calls(0);
+  const Status s = ParseDelimitedTextInParallel(
+      &pool, text, DelimitedTextOptions(),
+      [&calls](int chunk, gtl::ArraySlice<StringPiece> fields) {
+        ++calls;
+        return Status(error::CANCELLED, "stop");
+      });
+  EXPECT_EQ(error::CANCELLED, s.error_code());
+  EXPECT_LE(calls.load(), 64);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace mr
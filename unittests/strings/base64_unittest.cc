@@ -0,0 +1,159 @@
+#include "core/strings/base64.h"
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/io/zero_copy_stream_impl_lite.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace {
+
+// Bit by bit, as a reference for the kernels.
+std::string ReferenceEncode(const std::string& data, bool with_padding) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  std::string encoded;
+  uint32_t bits = 0;
+  int num_bits = 0;
+  for (unsigned char c : data) {
+    bits = (bits << 8) | c;
+    num_bits += 8;
+    while (num_bits >= 6) {
+      num_bits -= 6;
+      encoded.push_back(kChars[(bits >> num_bits) & 0x3F]);
+      bits &= (1u << num_bits) - 1;
+    }
+  }
+  if (num_bits > 0) {
+    encoded.push_back(kChars[(bits << (6 - num_bits)) & 0x3F]);
+  }
+  while (with_padding && encoded.size() % 4 != 0) encoded.push_back('=');
+  return encoded;
+}
+
+std::string RandomBytes(size_t size, std::mt19937* rng) {
+  std::string data(size, '\0');
+  for (char& c : data) c = static_cast<char>((*rng)());
+  return data;
+}
+
+TEST(Base64, EncodeDecode) {
+  const std::string original = "a simple test message!";
+  std::string encoded;
+  EXPECT_OK(Base64Encode(original, &encoded));
+  EXPECT_EQ("YSBzaW1wbGUgdGVzdCBtZXNzYWdlIQ", encoded);
+
+  std::string decoded;
+  EXPECT_OK(Base64Decode(encoded, &decoded));
+  EXPECT_EQ(original, decoded);
+}
+
+TEST(Base64, MatchesReference) {
+  std::mt19937 rng(301);
+  // Every length up to a few vectors, then long ones.
+  std::vector<size_t> sizes = {1000, 100001};
+  for (size_t size = 0; size < 100; ++size) sizes.push_back(size);
+  for (size_t size : sizes) {
+    const std::string data = RandomBytes(size, &rng);
+    for (bool with_padding : {false, true}) {
+      const std::string expected = ReferenceEncode(data, with_padding);
+      std::string encoded;
+      EXPECT_OK(Base64Encode(data, with_padding, &encoded));
+      ASSERT_EQ(expected, encoded) << data.size();
+      std::string decoded;
+      EXPECT_OK(Base64Decode(encoded, &decoded));
+      ASSERT_EQ(data, decoded) << data.size();
+    }
+  }
+}
+
+TEST(Base64, Aliasing) {
+  std::mt19937 rng(301);
+  const std::string data = RandomBytes(1000, &rng);
+  std::string s = data;
+  EXPECT_OK(Base64Encode(s, true, &s));
+  EXPECT_EQ(ReferenceEncode(data, true), s);
+  EXPECT_OK(Base64Decode(s, &s));
+  EXPECT_EQ(data, s);
+
+  // A piece from the middle of the output string.
+  s = "xx" + ReferenceEncode(data, false);
+  EXPECT_OK(Base64Decode(StringPiece(s).substr(2), &s));
+  EXPECT_EQ(data, s);
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            Base64Decode(StringPiece(s).substr(1, 5), &s).error_code());
+  EXPECT_TRUE(s.empty());
+}
+
+TEST(Base64, InvalidCharacters) {
+  std::mt19937 rng(301);
+  std::string encoded;
+  EXPECT_OK(Base64Encode(RandomBytes(96, &rng), &encoded));
+  std::string decoded;
+  // Characters outside the web-safe alphabet, at every position of
+  // vectors and the scalar tail.
+  for (char bad : {'+', '/', '=', ' ', '\x80', '\xff'}) {
+    for (size_t pos = 0; pos + 2 < encoded.size(); ++pos) {
+      std::string corrupt = encoded;
+      corrupt[pos] = bad;
+      EXPECT_EQ(error::INVALID_ARGUMENT,
+                Base64Decode(corrupt, &decoded).error_code())
+          << pos;
+    }
+  }
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            Base64Decode("AAAAA", &decoded).error_code());
+  EXPECT_OK(Base64Decode("AA==", &decoded));
+  EXPECT_EQ(std::string(1, '\0'), decoded);
+}
+
+TEST(Base64, Streams) {
+  std::mt19937 rng(301);
+  const std::string data = RandomBytes(10000, &rng);
+  for (bool with_padding : {false, true}) {
+    const std::string expected = ReferenceEncode(data, with_padding);
+    // Input and output buffers of every small size make groups straddle
+    // both.
+    for (int block_size : {1, 2, 3, 5, 7, 64, 1000}) {
+      ArrayInputStream input(data.data(), data.size(), block_size);
+      std::string encoded(expected.size() + 10, '?');
+      ArrayOutputStream output(&encoded[0], encoded.size(), block_size + 1);
+      EXPECT_OK(Base64Encode(&input, with_padding, &output));
+      ASSERT_EQ(expected.size(), output.ByteCount());
+      encoded.resize(output.ByteCount());
+      EXPECT_EQ(expected, encoded);
+
+      ArrayInputStream encoded_input(encoded.data(), encoded.size(),
+                                     block_size + 2);
+      std::string decoded;
+      {
+        StringOutputStream decoded_output(&decoded);
+        EXPECT_OK(Base64Decode(&encoded_input, &decoded_output));
+      }
+      EXPECT_EQ(data, decoded) << block_size;
+    }
+  }
+
+  std::string decoded;
+  StringOutputStream output(&decoded);
+  Base64Decoder decoder(&output);
+  EXPECT_OK(decoder.Write("YSBz"));
+  EXPECT_OK(decoder.Write("aW0="));
+  EXPECT_EQ(error::INVALID_ARGUMENT, decoder.Write("YQ").error_code());
+
+  // The output stream running out.
+  char small[8];
+  ArrayOutputStream small_output(small, sizeof(small));
+  Base64Encoder encoder(false, &small_output);
+  EXPECT_OK(encoder.Write("abcdef"));
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED, encoder.Write("ghi").error_code());
+}
+
+}  // namespace
+}  // namespace mr
@@ -0,0 +1,56 @@
+#include "core/strings/byte_set.h"
+
+#include <string.h>
+
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace strings {
+namespace {
+
+TEST(ByteSet, Members) {
+  const ByteSet set(StringPiece("a\0\xff" "aa", 5));
+  EXPECT_EQ(3, set.num_chars());
+  EXPECT_TRUE(set.contains('a'));
+  EXPECT_TRUE(set.contains('\0'));
+  EXPECT_TRUE(set.contains('\xff'));
+  EXPECT_FALSE(set.contains('b'));
+
+  std::string all;
+  for (int c = 0; c < 256; ++c) all.push_back(static_cast<char>(c));
+  EXPECT_EQ(ByteSet::kMaxVectorChars + 1, ByteSet(all).num_chars());
+}
+
+TEST(ByteSet, FindAndCountMatchScalar) {
+  std::mt19937 rng(301);
+  std::string text(300, '\0');
+  for (const char* chars :
+       {"", "x", "\t\n", ",;|\"", "abcdefgh", "abcdefghi"}) {
+    const ByteSet set(chars);
+    for (size_t n = 0; n < text.size(); n += 1 + n / 8) {
+      // One member every ~40 bytes, at every offset within a vector.
+      for (char& c : text) {
+        c = rng() % 40 == 0 && chars[0] != '\0'
+                ? chars[rng() % strlen(chars)]
+                : static_cast<char>('0' + rng() % 10);
+      }
+      const char* p = text.data();
+      size_t count = 0;
+      size_t first = n;
+      for (size_t i = 0; i < n; ++i) {
+        if (!set.contains(p[i])) continue;
+        ++count;
+        if (first == n) first = i;
+      }
+      EXPECT_EQ(p + first, FindByteInSet(p, p + n, set)) << chars << " " << n;
+      EXPECT_EQ(count, CountBytesInSet(p, p + n, set)) << chars << " " << n;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace strings
+}  // namespace mr
@@ -0,0 +1,220 @@
+#include "core/strings/numbers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace strings {
+namespace {
+
+template <typename T, typename Bits>
+T FromBits(Bits bits) {
+  T value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+std::string Double(double d) {
+  char buffer[kFastToBufferSize];
+  return DoubleToBuffer(d, buffer);
+}
+
+std::string Float(float f) {
+  char buffer[kFastToBufferSize];
+  return FloatToBuffer(f, buffer);
+}
+
+// Number of significant digits in a DoubleToBuffer() result.
+int SignificantDigits(const std::string& s) {
+  const std::string mantissa = s.substr(0, s.find('e'));
+  std::string digits;
+  for (char c : mantissa) {
+    if (isdigit(c)) digits.push_back(c);
+  }
+  // Zeros that only place the decimal point do not count.
+  return digits.find_last_not_of('0') - digits.find_first_not_of('0') + 1;
+}
+
+TEST(FastInt64ToBufferLeft, MatchesToString) {
+  std::vector<int64_t> values = {std::numeric_limits<int64_t>::min(),
+                                 std::numeric_limits<int64_t>::max()};
+  for (int e = 0; e <= 18; ++e) {
+    int64_t p = 1;
+    for (int i = 0; i < e; ++i) p *= 10;
+    for (int64_t v : {p - 1, p, p + 1}) {
+      values.push_back(v);
+      values.push_back(-v);
+    }
+  }
+  for (int64_t v : values) {
+    char buffer[kFastToBufferSize];
+    char* end = FastInt64ToBufferLeft(v, buffer);
+    EXPECT_EQ(std::to_string(v), buffer);
+    EXPECT_EQ('\0', *end);
+    EXPECT_EQ(std::to_string(v).size(), end - buffer);
+    if (v == static_cast<int32_t>(v)) {
+      FastInt32ToBufferLeft(v, buffer);
+      EXPECT_EQ(std::to_string(v), buffer);
+    }
+  }
+  char buffer[kFastToBufferSize];
+  FastUInt64ToBufferLeft(std::numeric_limits<uint64_t>::max(), buffer);
+  EXPECT_STREQ("18446744073709551615", buffer);
+  FastUInt32ToBufferLeft(std::numeric_limits<uint32_t>::max(), buffer);
+  EXPECT_STREQ("4294967295", buffer);
+}
+
+TEST(DoubleToBuffer, Format) {
+  EXPECT_EQ("0", Double(0));
+  EXPECT_EQ("-0", Double(-0.0));
+  EXPECT_EQ("0.1", Double(0.1));
+  EXPECT_EQ("0.30000000000000004", Double(0.1 + 0.2));
+  EXPECT_EQ("-1.5", Double(-1.5));
+  EXPECT_EQ("123456", Double(123456));
+  EXPECT_EQ("100000000000000", Double(1e14));
+  EXPECT_EQ("1e+15", Double(1e15));
+  EXPECT_EQ("1e+20", Double(1e20));
+  EXPECT_EQ("0.0001", Double(1e-4));
+  EXPECT_EQ("1e-05", Double(1e-5));
+  EXPECT_EQ("1.2345e-300", Double(1.2345e-300));
+  EXPECT_EQ("9007199254740992", Double(9007199254740992.0));
+  EXPECT_EQ("5e-324", Double(std::numeric_limits<double>::denorm_min()));
+  EXPECT_EQ("1.7976931348623157e+308",
+            Double(std::numeric_limits<double>::max()));
+  EXPECT_EQ("inf", Double(std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("-inf", Double(-std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("nan", Double(std::numeric_limits<double>::quiet_NaN()));
+
+  EXPECT_EQ("0.1", Float(0.1f));
+  EXPECT_EQ("100000.5", Float(100000.5f));
+  EXPECT_EQ("16777216", Float(16777216.0f));
+  EXPECT_EQ("1e-45", Float(std::numeric_limits<float>::denorm_min()));
+  EXPECT_EQ("3.4028235e+38", Float(std::numeric_limits<float>::max()));
+}
+
+TEST(DoubleToBuffer, ShortestRoundTrip) {
+  std::mt19937_64 rng(301);
+  for (int i = 0; i < 100000; ++i) {
+    const double d = FromBits<double>(rng());
+    if (std::isnan(d)) continue;
+    const std::string s = Double(d);
+    ASSERT_EQ(d, strtod(s.c_str(), nullptr)) << s;
+    // No shorter decimal rounds to d.
+    const int digits = SignificantDigits(s);
+    if (d != 0 && !std::isinf(d) && digits > 1) {
+      char shorter[64];
+      snprintf(shorter, sizeof(shorter), "%.*e", digits - 2, d);
+      EXPECT_NE(d, strtod(shorter, nullptr)) << s << " " << shorter;
+    }
+
+    const float f = FromBits<float>(static_cast<uint32_t>(rng()));
+    if (std::isnan(f)) continue;
+    const std::string t = Float(f);
+    ASSERT_EQ(f, strtof(t.c_str(), nullptr)) << t;
+  }
+}
+
+// Decimal strings near halfway points, with long and short mantissas and
+// exponents from subnormal to overflow.
+std::string RandomDecimal(std::mt19937_64* rng) {
+  std::string s;
+  if ((*rng)() % 2) s.push_back('-');
+  const int num_digits = 1 + (*rng)() % 24;
+  for (int i = 0; i < num_digits; ++i) {
+    s.push_back('0' + (*rng)() % 10);
+    if (i == 0 && (*rng)() % 3 == 0) s.push_back('.');
+  }
+  if ((*rng)() % 4) {
+    s += "e" + std::to_string(static_cast<int>((*rng)() % 660) - 340);
+  }
+  return s;
+}
+
+TEST(safe_strtod, MatchesStrtod) {
+  std::mt19937_64 rng(301);
+  std::vector<std::string> inputs = {
+      "9007199254740993",  // 2^53 + 1: halfway, rounds to even.
+      "9007199254740995",
+      "2.2250738585072011e-308",
+      "1.7976931348623157e308",
+      "1.7976931348623159e308",
+      "4.9406564584124654e-324",
+      "0.000000000000000000000000000000000000000001",
+      "  12.5e-1  ",
+      "+.5",
+      "1.",
+      "123456789012345678901234567890",
+  };
+  for (int i = 0; i < 100000; ++i) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.17g", FromBits<double>(rng()));
+    inputs.push_back(buffer);
+    snprintf(buffer, sizeof(buffer), "%.9g",
+             FromBits<float>(static_cast<uint32_t>(rng())));
+    inputs.push_back(buffer);
+    inputs.push_back(RandomDecimal(&rng));
+  }
+  for (const std::string& s : inputs) {
+    double d;
+    ASSERT_TRUE(safe_strtod(s.c_str(), &d)) << s;
+    const double expected = strtod(s.c_str(), nullptr);
+    if (std::isnan(expected)) {
+      EXPECT_TRUE(std::isnan(d)) << s;
+      continue;
+    }
+    ASSERT_EQ(expected, d) << s;
+    ASSERT_EQ(std::signbit(expected), std::signbit(d)) << s;
+    ASSERT_TRUE(safe_strtod(StringPiece(s), &d)) << s;
+    ASSERT_EQ(expected, d) << s;
+    float f;
+    ASSERT_TRUE(safe_strtof(s.c_str(), &f)) << s;
+    ASSERT_EQ(strtof(s.c_str(), nullptr), f) << s;
+  }
+}
+
+TEST(safe_strtod, Syntax) {
+  double d;
+  EXPECT_TRUE(safe_strtod(StringPiece("1.5e3 junk", 5), &d));
+  EXPECT_EQ(1500, d);
+  EXPECT_TRUE(safe_strtod(StringPiece(" -inf "), &d));
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(), d);
+  EXPECT_TRUE(safe_strtod(StringPiece("0x10"), &d));
+  EXPECT_EQ(16, d);
+  EXPECT_FALSE(safe_strtod(StringPiece("1e"), &d));
+  EXPECT_FALSE(safe_strtod(StringPiece("."), &d));
+  EXPECT_FALSE(safe_strtod(StringPiece("1.5.2"), &d));
+  EXPECT_FALSE(safe_strtod(StringPiece("1\0", 2), &d));
+  EXPECT_FALSE(safe_strtod(StringPiece(""), &d));
+}
+
+TEST(ParseDoubles, StopsAtFirstError) {
+  const std::vector<StringPiece> column = {"1", "2.5", "-3e2", "x", "5"};
+  std::vector<double> doubles(column.size());
+  EXPECT_EQ(3, ParseDoubles(column, &doubles));
+  EXPECT_EQ(std::vector<double>({1, 2.5, -300, 0, 0}), doubles);
+
+  std::vector<float> floats(3);
+  EXPECT_EQ(3, ParseFloats({"0.1", "1e39", " 7 "}, &floats));
+  EXPECT_EQ(0.1f, floats[0]);
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), floats[1]);
+
+  std::vector<int64_t> ints(3);
+  EXPECT_EQ(3, ParseInt64s({"-9223372036854775808", "0", "9223372036854775807"},
+                           &ints));
+  EXPECT_EQ(std::numeric_limits<int64_t>::min(), ints[0]);
+  EXPECT_EQ(1, ParseInt64s({"1", "2.5", "3"}, &ints));
+}
+
+}  // namespace
+}  // namespace strings
+}  // namespace mr
@@ -0,0 +1,112 @@
+#include "core/strings/ordered_code.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/strings/string_piece.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace strings {
+namespace {
+
+TEST(OrderedCode, WriteKeysMatchesWriteOneByOne) {
+  std::mt19937 rng(301);
+  const size_t kNumKeys = 1000;
+  std::vector<std::string> names(kNumKeys);
+  std::vector<uint64_t> counts(kNumKeys);
+  std::vector<int64_t> deltas(kNumKeys);
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    // Short and long strings, some with bytes that need escaping.
+    names[i].resize(rng() % (i % 2 ? 8 : 100));
+    for (char& c : names[i]) c = static_cast<char>(rng() % 256);
+    counts[i] = static_cast<uint64_t>(rng()) << (rng() % 40);
+    deltas[i] = static_cast<int64_t>(counts[i]) * (i % 3 ? 1 : -1);
+  }
+  counts[0] = 0;
+  counts[1] = std::numeric_limits<uint64_t>::max();
+  deltas[0] = std::numeric_limits<int64_t>::min();
+  deltas[1] = std::numeric_limits<int64_t>::max();
+  const std::vector<StringPiece> name_pieces(names.begin(), names.end());
+
+  std::string batch = "prefix";
+  std::vector<size_t> offsets;
+  OrderedCode::WriteKeys(
+      {OrderedCode::Column::Strings(name_pieces),
+       OrderedCode::Column::NumIncreasing(counts),
+       OrderedCode::Column::SignedNumIncreasing(deltas)},
+      &batch, &offsets);
+
+  ASSERT_EQ(kNumKeys + 1, offsets.size());
+  EXPECT_EQ(6u, offsets[0]);
+  EXPECT_EQ(batch.size(), offsets[kNumKeys]);
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    std::string key;
+    OrderedCode::WriteString(&key, names[i]);
+    OrderedCode::WriteNumIncreasing(&key, counts[i]);
+    OrderedCode::WriteSignedNumIncreasing(&key, deltas[i]);
+    EXPECT_EQ(key, batch.substr(offsets[i], offsets[i + 1] - offsets[i]))
+        << "key " << i;
+  }
+}
+
+TEST(OrderedCode, WriteKeysWithoutKeys) {
+  std::string batch;
+  std::vector<size_t> offsets(3, 7);
+  OrderedCode::WriteKeys({}, &batch, &offsets);
+  EXPECT_EQ(std::vector<size_t>(1, 0), offsets);
+  OrderedCode::WriteKeys({OrderedCode::Column::NumIncreasing({})}, &batch,
+                         &offsets);
+  EXPECT_EQ(std::vector<size_t>(1, 0), offsets);
+  EXPECT_TRUE(batch.empty());
+}
+
+TEST(OrderedCode, KeyPrefixOrdersLikeKeys) {
+  std::vector<std::string> keys = {"", std::string(1, '\0'), "a",
+                                   std::string("a\0", 2), "ab", "abcdefgh",
+                                   "abcdefgh\x01", "abcdefghi", "b",
+                                   "\xff\xff\xff\xff\xff\xff\xff\xff"};
+  std::mt19937 rng(301);
+  for (int i = 0; i < 200; ++i) {
+    std::string key;
+    OrderedCode::WriteNumIncreasing(&key, rng() % 1000);
+    OrderedCode::WriteString(&key, std::string(rng() % 12, 'x' + i % 3));
+    OrderedCode::WriteSignedNumIncreasing(&key, static_cast<int32_t>(rng()));
+    keys.push_back(key);
+  }
+  for (const std::string& a : keys) {
+    for (const std::string& b : keys) {
+      const uint64_t pa = OrderedCode::KeyPrefix64(a);
+      const uint64_t pb = OrderedCode::KeyPrefix64(b);
+      if (pa < pb) {
+        EXPECT_LT(a, b);
+      }
+      if (pa == pb && std::min(a.size(), b.size()) <= 8) {
+        EXPECT_EQ(a.size() < b.size(), a < b);
+      }
+      uint64_t ha, la, hb, lb;
+      OrderedCode::KeyPrefix128(a, &ha, &la);
+      OrderedCode::KeyPrefix128(b, &hb, &lb);
+      EXPECT_EQ(pa, ha);
+      if (ha < hb || (ha == hb && la < lb)) {
+        EXPECT_LT(a, b);
+      }
+    }
+  }
+  EXPECT_EQ(0x6162000000000000ull, OrderedCode::KeyPrefix64("ab"));
+  uint64_t high, low;
+  OrderedCode::KeyPrefix128("abcdefghi", &high, &low);
+  EXPECT_EQ(0x6162636465666768ull, high);
+  EXPECT_EQ(0x6900000000000000ull, low);
+}
+
+}  // namespace
+}  // namespace strings
+}  // namespace mr
@@ -0,0 +1,88 @@
+#include "core/strings/split.h"
+
+#include <string>
+#include <vector>
+
+#include "core/strings/str_util.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace str_util {
+namespace {
+
+template <typename Range>
+std::vector<std::string> Tokens(const Range& range) {
+  std::vector<std::string> tokens;
+  for (StringPiece token : range) tokens.push_back(token.ToString());
+  return tokens;
+}
+
+typedef std::vector<std::string> V;
+
+TEST(SplitPieces, MatchesSplit) {
+  const char* texts[] = {"", ",", "a", "a,b", ",a,,b,", "  , x ,,"};
+  for (const char* text : texts) {
+    EXPECT_EQ(Split(text, ','), Tokens(SplitPieces(text, ','))) << text;
+    EXPECT_EQ(Split(text, ',', SkipEmpty()),
+              Tokens(SplitPieces(text, ',', SkipEmpty())))
+        << text;
+    EXPECT_EQ(Split(text, ',', SkipWhitespace()),
+              Tokens(SplitPieces(text, ',', SkipWhitespace())))
+        << text;
+  }
+}
+
+TEST(SplitPieces, PiecesAliasText) {
+  const StringPiece text("key=value");
+  const auto pieces = SplitPieces(text, '=');
+  auto it = pieces.begin();
+  EXPECT_EQ(text.data(), it->data());
+  ++it;
+  EXPECT_EQ(text.data() + 4, it->data());
+  EXPECT_EQ("value", *it);
+  EXPECT_TRUE(++it == pieces.end());
+}
+
+TEST(SplitPieces, ByString) {
+  EXPECT_EQ(V({"a", "b", "", "c"}),
+            Tokens(SplitPieces("a\r\nb\r\n\r\nc", ByString("\r\n"))));
+  EXPECT_EQ(V({"a\rb", "\n"}),
+            Tokens(SplitPieces("a\rb\r\n\n", ByString("\r\n"))));
+  EXPECT_EQ(V({"", "a", ""}), Tokens(SplitPieces("::a::", ByString("::"))));
+  EXPECT_EQ(V({"a:"}), Tokens(SplitPieces("a:", ByString("::"))));
+}
+
+TEST(SplitPieces, ByAnyChar) {
+  EXPECT_EQ(V({"a", "b", "c", "d"}),
+            Tokens(SplitPieces("a b\tc d", ByAnyChar(" \t"))));
+  EXPECT_EQ(V({"x", "y"}),
+            Tokens(SplitPieces(";x,,y;", ByAnyChar(",;"), SkipEmpty())));
+  // Sets too big for the vector kernels.
+  EXPECT_EQ(V({"a", "b", "c"}),
+            Tokens(SplitPieces("a0b9c", ByAnyChar("0123456789"))));
+}
+
+TEST(SplitPieces, LongLines) {
+  // Delimiters at every offset of vectors of 16 and 32 bytes, and past
+  // the last full vector.
+  for (size_t len = 1; len < 100; ++len) {
+    for (size_t pos = 0; pos < len; ++pos) {
+      std::string line(len, 'x');
+      line[pos] = '\t';
+      const V expected = {line.substr(0, pos), line.substr(pos + 1)};
+      EXPECT_EQ(expected, Tokens(SplitPieces(line, '\t')));
+      EXPECT_EQ(expected, Tokens(SplitPieces(line, ByAnyChar("\t|"))));
+      EXPECT_EQ(expected, Tokens(SplitPieces(line, ByString("\t"))));
+    }
+  }
+  std::string tsv;
+  for (int i = 0; i < 1000; ++i) tsv += (i % 7 ? "field\t" : "f|");
+  EXPECT_EQ(Split(tsv, '\t').size() + 143,
+            Tokens(SplitPieces(tsv, ByAnyChar("\t|"))).size());
+}
+
+}  // namespace
+}  // namespace str_util
+}  // namespace mr
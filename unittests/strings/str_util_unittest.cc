@@ -0,0 +1,116 @@
+#include "core/strings/str_util.h"
+
+#include <random>
+#include <string>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace str_util {
+namespace {
+
+// The byte-at-a-time escaping CEscape() is equivalent to.
+string ReferenceCEscape(const string& src) {
+  string dest;
+  for (unsigned char c : src) {
+    switch (c) {
+      case '\n': dest += "\\n"; break;
+      case '\r': dest += "\\r"; break;
+      case '\t': dest += "\\t"; break;
+      case '\"': dest += "\\\""; break;
+      case '\'': dest += "\\'"; break;
+      case '\\': dest += "\\\\"; break;
+      default:
+        if (c >= 0x80 || c < 0x20 || c == 0x7f) {
+          dest += '\\';
+          dest += '0' + c / 64;
+          dest += '0' + (c % 64) / 8;
+          dest += '0' + c % 8;
+        } else {
+          dest += c;
+        }
+    }
+  }
+  return dest;
+}
+
+// Mostly printable text with an occasional byte to escape, so runs and
+// single escapes land on every position of a vector.
+string RandomText(size_t size, std::mt19937* rng) {
+  string text(size, '\0');
+  for (char& c : text) {
+    c = (*rng)() % 8 == 0 ? static_cast<char>((*rng)())
+                          : static_cast<char>(' ' + (*rng)() % 95);
+  }
+  return text;
+}
+
+TEST(CEscape, RoundTrip) {
+  EXPECT_EQ("a\\nb\\t\\\"c\\'\\\\\\000\\177\\377",
+            CEscape(string("a\nb\t\"c'\\\0\x7f\xff", 11)));
+
+  std::mt19937 rng(301);
+  for (size_t size = 0; size < 200; ++size) {
+    const string text = RandomText(size, &rng);
+    const string escaped = CEscape(text);
+    ASSERT_EQ(ReferenceCEscape(text), escaped);
+
+    string unescaped;
+    string error;
+    ASSERT_TRUE(CUnescape(escaped, &unescaped, &error)) << error;
+    EXPECT_EQ(text, unescaped);
+    string in_place = escaped;
+    ASSERT_TRUE(CUnescapeInPlace(&in_place, &error)) << error;
+    EXPECT_EQ(text, in_place);
+  }
+
+  string dest = "x=";
+  CEscapeAndAppend("\"1\"", &dest);
+  EXPECT_EQ("x=\\\"1\\\"", dest);
+}
+
+TEST(CUnescape, Errors) {
+  string dest;
+  string error;
+  EXPECT_TRUE(CUnescape("plain text, no escapes", &dest, &error));
+  EXPECT_EQ("plain text, no escapes", dest);
+  EXPECT_TRUE(CUnescape("\\x41\\102\\?", &dest, &error));
+  EXPECT_EQ("AB?", dest);
+  EXPECT_FALSE(CUnescape("abc\\", &dest, &error));
+  EXPECT_EQ("String cannot end with \\", error);
+  EXPECT_FALSE(CUnescape("\\400", &dest, &error));
+  EXPECT_FALSE(CUnescape("\\xg", &dest, &error));
+  EXPECT_FALSE(CUnescape("\\q", &dest, nullptr));
+}
+
+TEST(Lowercase, AllBytes) {
+  string all;
+  for (int c = 0; c < 256; ++c) all.push_back(static_cast<char>(c));
+  all += all;  // Some bytes in the scalar tail.
+  string lower;
+  string upper;
+  for (char c : all) {
+    lower.push_back(c >= 'A' && c <= 'Z' ? c + 32 : c);
+    upper.push_back(c >= 'a' && c <= 'z' ? c - 32 : c);
+  }
+  EXPECT_EQ(lower, Lowercase(all));
+  EXPECT_EQ(upper, Uppercase(all));
+
+  string s = all;
+  LowercaseInPlace(&s);
+  EXPECT_EQ(lower, s);
+  UppercaseInPlace(&s);
+  EXPECT_EQ(upper, s);
+
+  char buffer[16];
+  EXPECT_EQ(buffer + 9, LowercaseToBuffer("GroupKey1", buffer));
+  EXPECT_EQ("groupkey1", string(buffer, 9));
+  EXPECT_EQ(buffer + 9, UppercaseToBuffer("GroupKey1", buffer));
+  EXPECT_EQ("GROUPKEY1", string(buffer, 9));
+  EXPECT_EQ("", Lowercase(""));
+}
+
+}  // namespace
+}  // namespace str_util
+}  // namespace mr
@@ -0,0 +1,81 @@
+#include "core/strings/strcat.h"
+
+#include <stdint.h>
+
+#include <limits>
+#include <string>
+
+#include "core/base/arena.h"
+#include "core/strings/string_builder.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+namespace mr {
+namespace strings {
+namespace {
+
+TEST(StrCat, ManyArguments) {
+  const string s = "str";
+  EXPECT_EQ("1-2.5str0xffpiece7",
+            StrCat(1, "-", 2.5, s, "0x", Hex(255), StringPiece("piece"),
+                   uint64_t{7}));
+
+  string dest = "x";
+  StrAppend(&dest, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+  EXPECT_EQ("x123456789101112", dest);
+}
+
+TEST(StrCat, Padding) {
+  EXPECT_EQ("ff", StrCat(Hex(255)));
+  EXPECT_EQ("00ff", StrCat(Hex(255, ZERO_PAD_4)));
+  EXPECT_EQ("  ff", StrCat(Hex(255, SPACE_PAD_4)));
+  EXPECT_EQ("12345", StrCat(Hex(0x12345, ZERO_PAD_2)));
+  EXPECT_EQ("ffffffffffffffff", StrCat(Hex(int64_t{-1})));
+  EXPECT_EQ("ff", StrCat(Hex(int8_t{-1})));
+
+  EXPECT_EQ("0", StrCat(Dec(0)));
+  EXPECT_EQ("007", StrCat(Dec(7, ZERO_PAD_3)));
+  EXPECT_EQ("-07", StrCat(Dec(-7, ZERO_PAD_3)));
+  EXPECT_EQ("  -7", StrCat(Dec(-7, SPACE_PAD_4)));
+  EXPECT_EQ("12345", StrCat(Dec(12345, SPACE_PAD_3)));
+  EXPECT_EQ("-9223372036854775808",
+            StrCat(Dec(std::numeric_limits<int64_t>::min())));
+  EXPECT_EQ("18446744073709551615",
+            StrCat(Dec(std::numeric_limits<uint64_t>::max(), ZERO_PAD_16)));
+  EXPECT_EQ("part-00017.txt", StrCat("part-", Dec(17, ZERO_PAD_5), ".txt"));
+}
+
+TEST(StringBuilder, Append) {
+  Arena arena(8192);
+  StringBuilder builder(&arena);
+  EXPECT_TRUE(builder.empty());
+  builder.Append("events/", Dec(3, ZERO_PAD_4), "/").Append(Hex(48879));
+  builder.push_back('!');
+  EXPECT_EQ("events/0003/beef!", builder.piece());
+
+  // Growing keeps the contents.
+  string expected = builder.ToString();
+  for (int i = 0; i < 1000; ++i) {
+    builder.Append(i, ",");
+    StrAppend(&expected, i, ",");
+  }
+  EXPECT_EQ(expected, builder.piece());
+  EXPECT_GE(builder.capacity(), expected.size());
+
+  builder.Truncate(6);
+  EXPECT_EQ("events", builder.piece());
+  builder.clear();
+  builder.Append(string(100, 'x'));
+  EXPECT_EQ(string(100, 'x'), builder.ToString());
+
+  // An initial capacity avoids growing.
+  StringBuilder sized(&arena, 64);
+  const char* const data = sized.data();
+  sized.Append(string(64, 'y'));
+  EXPECT_EQ(data, sized.data());
+}
+
+}  // namespace
+}  // namespace strings
+}  // namespace mr